@@ -10,6 +10,9 @@
 
 #include <android-base/file.h>
 #include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+#include <json/writer.h>
 #include <utils/Trace.h>
 
 namespace aidl {
@@ -30,6 +33,10 @@ ndk::ScopedAStatus readErrorStatus() {
             EX_ILLEGAL_STATE, "ThermalHal cannot read any sensor data");
 }
 
+bool matchPolicy(const CallbackPolicy &policy, std::string_view sensor) {
+    return policy.sensors.empty() || policy.sensors.find(sensor) != policy.sensors.end();
+}
+
 bool interfacesEqual(const std::shared_ptr<::ndk::ICInterface> left,
                      const std::shared_ptr<::ndk::ICInterface> right) {
     if (left == nullptr || right == nullptr || !left->isRemote() || !right->isRemote()) {
@@ -64,6 +71,8 @@ ndk::ScopedAStatus Thermal::getFilteredTemperatures(bool filterType, Temperature
     if (!thermal_helper_->isInitializedOk()) {
         return initErrorStatus();
     }
+    // The thresholds read to classify the temperatures are updated in place by a config reload
+    const auto config_lock = thermal_helper_->LockConfigShared();
     if (!thermal_helper_->fillCurrentTemperatures(filterType, false, type, _aidl_return)) {
         return readErrorStatus();
     }
@@ -108,6 +117,7 @@ ndk::ScopedAStatus Thermal::getFilteredTemperatureThresholds(
     if (!thermal_helper_->isInitializedOk()) {
         return initErrorStatus();
     }
+    const auto config_lock = thermal_helper_->LockConfigShared();
     if (!thermal_helper_->fillTemperatureThresholds(filterType, type, _aidl_return)) {
         return readErrorStatus();
     }
@@ -173,13 +183,25 @@ ndk::ScopedAStatus Thermal::registerThermalChangedCallback(
         return ndk::ScopedAStatus::fromExceptionCodeWithMessage(EX_ILLEGAL_ARGUMENT,
                                                                 "Callback already registered");
     }
-    auto c = callbacks_.emplace_back(callback, filterType, type);
+    const uid_t uid = AIBinder_getCallingUid();
+    const auto policy_it = callback_policies_.find(uid);
+    auto c = callbacks_.emplace_back(
+            callback, filterType, type, uid,
+            policy_it != callback_policies_.end() ? policy_it->second : CallbackPolicy());
     LOG(INFO) << "a callback has been registered to ThermalHAL, isFilter: " << c.is_filter_type
-              << " Type: " << toString(c.type);
+              << " Type: " << toString(c.type) << " Uid: " << uid;
     // Send notification right away after successful thermal callback registration
     std::function<void()> handler = [this, c, filterType, type]() {
         std::vector<Temperature> temperatures;
-        if (thermal_helper_->fillCurrentTemperatures(filterType, true, type, &temperatures)) {
+        bool is_filled;
+        {
+            const auto config_lock = thermal_helper_->LockConfigShared();
+            // The published state is sent, the sensors are only read before the first update
+            is_filled = fillPublishedTemperatures(filterType, type, &temperatures) ||
+                        thermal_helper_->fillCurrentTemperatures(filterType, true, type,
+                                                                 &temperatures);
+        }
+        if (is_filled) {
             std::lock_guard<std::mutex> _lock(thermal_callback_mutex_);
             auto it = std::find_if(callbacks_.begin(), callbacks_.end(),
                                    [&](const CallbackSetting &cc) {
@@ -187,8 +209,9 @@ ndk::ScopedAStatus Thermal::registerThermalChangedCallback(
                                    });
             if (it != callbacks_.end()) {
                 if (AIBinder_isAlive(c.callback->asBinder().get())) {
+                    it->last_notify_time = boot_clock::now();
                     for (const auto &t : temperatures) {
-                        if (!filterType || t.type == type) {
+                        if ((!filterType || t.type == type) && matchPolicy(it->policy, t.name)) {
                             LOG(INFO) << "Sending notification: "
                                       << " Type: " << toString(t.type) << " Name: " << t.name
                                       << " CurrentValue: " << t.value
@@ -206,6 +229,89 @@ ndk::ScopedAStatus Thermal::registerThermalChangedCallback(
     return ndk::ScopedAStatus::ok();
 }
 
+bool Thermal::fillPublishedTemperatures(bool filterType, TemperatureType type,
+                                        std::vector<Temperature> *temperatures) const {
+    const auto &map = thermal_helper_->GetSensorInfoMap();
+    const auto sensor_status_map = thermal_helper_->GetSensorStatusSnapshot();
+    temperatures->clear();
+    for (const auto &[sensor_name, sensor_info] : map) {
+        if (sensor_info.is_hidden || !sensor_info.send_cb ||
+            (filterType && sensor_info.type != type)) {
+            continue;
+        }
+        const auto &sensor_status = sensor_status_map.at(sensor_name);
+        // An emulated sensor is read, its value is not published
+        if (sensor_status.thermal_cached.timestamp == boot_clock::time_point::min() ||
+            std::isnan(sensor_status.thermal_cached.temp) || sensor_status.emul_temp.has_value()) {
+            return false;
+        }
+        Temperature temp;
+        temp.type = sensor_info.type;
+        temp.name = sensor_name;
+        temp.value = sensor_status.thermal_cached.temp * sensor_info.multiplier;
+        temp.throttlingStatus = sensor_status.severity;
+        temperatures->emplace_back(std::move(temp));
+    }
+    return temperatures->size() > 0;
+}
+
+bool Thermal::notifyCallback(CallbackSetting *c, const Temperature &t,
+                             boot_clock::time_point now) {
+    // A notification replaces the coalesced one of the same sensor
+    const auto pending_it =
+            std::find_if(c->pending.begin(), c->pending.end(),
+                         [&t](const Temperature &pending) { return pending.name == t.name; });
+    if (pending_it != c->pending.end()) {
+        c->pending.erase(pending_it);
+    }
+
+    const auto next_notify_time = (c->last_notify_time == boot_clock::time_point::min())
+                                          ? c->last_notify_time
+                                          : c->last_notify_time + c->policy.min_interval;
+    if (now >= next_notify_time || t.throttlingStatus >= ThrottlingSeverity::SEVERE) {
+        c->last_notify_time = now;
+        return c->callback->notifyThrottling(t).isOk();
+    }
+
+    if (c->pending.size() >= c->policy.max_pending) {
+        c->pending.erase(c->pending.begin());
+        c->dropped_count++;
+    }
+    c->pending.push_back(t);
+    if (!c->is_flush_scheduled) {
+        c->is_flush_scheduled = true;
+        const auto callback = c->callback;
+        looper_.addDelayedEvent(Looper::Event{[this, callback] { flushPendingCallback(callback); }},
+                                next_notify_time);
+    }
+    return true;
+}
+
+void Thermal::flushPendingCallback(const std::shared_ptr<IThermalChangedCallback> &callback) {
+    ATRACE_CALL();
+    std::lock_guard<std::mutex> _lock(thermal_callback_mutex_);
+    auto it = std::find_if(
+            callbacks_.begin(), callbacks_.end(),
+            [&](const CallbackSetting &c) { return interfacesEqual(c.callback, callback); });
+    if (it == callbacks_.end()) {
+        return;
+    }
+    it->is_flush_scheduled = false;
+    it->last_notify_time = boot_clock::now();
+    for (const auto &t : it->pending) {
+        LOG(VERBOSE) << "Sending coalesced notification: "
+                     << " Type: " << toString(t.type) << " Name: " << t.name
+                     << " CurrentValue: " << t.value
+                     << " ThrottlingStatus: " << toString(t.throttlingStatus);
+        if (!it->callback->notifyThrottling(t).isOk()) {
+            LOG(ERROR) << "a Thermal callback is dead, removed from callback list.";
+            callbacks_.erase(it);
+            return;
+        }
+    }
+    it->pending.clear();
+}
+
 void Thermal::sendThermalChangedCallback(const Temperature &t) {
     ATRACE_CALL();
     std::lock_guard<std::mutex> _lock(thermal_callback_mutex_);
@@ -214,27 +320,86 @@ void Thermal::sendThermalChangedCallback(const Temperature &t) {
                  << " CurrentValue: " << t.value
                  << " ThrottlingStatus: " << toString(t.throttlingStatus);
 
+    const auto now = boot_clock::now();
     callbacks_.erase(std::remove_if(callbacks_.begin(), callbacks_.end(),
-                                    [&](const CallbackSetting &c) {
-                                        if (!c.is_filter_type || t.type == c.type) {
-                                            ::ndk::ScopedAStatus ret =
-                                                    c.callback->notifyThrottling(t);
-                                            if (!ret.isOk()) {
-                                                LOG(ERROR) << "a Thermal callback is dead, removed "
-                                                              "from callback list.";
-                                                return true;
-                                            }
+                                    [&](CallbackSetting &c) {
+                                        if ((c.is_filter_type && t.type != c.type) ||
+                                            !matchPolicy(c.policy, t.name)) {
                                             return false;
                                         }
+                                        if (!notifyCallback(&c, t, now)) {
+                                            LOG(ERROR) << "a Thermal callback is dead, removed "
+                                                          "from callback list.";
+                                            return true;
+                                        }
                                         return false;
                                     }),
                      callbacks_.end());
 }
 
-void Thermal::dumpVirtualSensorInfo(std::ostringstream *dump_buf) {
+bool Thermal::setCallbackPolicy(const char **args, uint32_t numArgs, std::string *result) {
+    if (numArgs < 2) {
+        *result = "usage: callback_policy <uid> [sensors <name,...>] [interval <ms>] "
+                  "[queue <count>] | clear";
+        return false;
+    }
+    const uid_t uid = static_cast<uid_t>(std::strtoul(args[1], nullptr, 10));
+    std::lock_guard<std::mutex> _lock(thermal_callback_mutex_);
+    CallbackPolicy policy;
+    if (numArgs == 3 && std::string(args[2]) == "clear") {
+        callback_policies_.erase(uid);
+    } else {
+        const auto &map = thermal_helper_->GetSensorInfoMap();
+        for (uint32_t i = 2; i < numArgs; i += 2) {
+            const std::string key(args[i]);
+            if (i + 1 >= numArgs) {
+                *result = "missing value of " + key;
+                return false;
+            }
+            const std::string value(args[i + 1]);
+            if (key == "sensors") {
+                for (const auto &sensor : ::android::base::Split(value, ",")) {
+                    if (!map.count(sensor)) {
+                        *result = "unknown sensor " + sensor;
+                        return false;
+                    }
+                    policy.sensors.insert(sensor);
+                }
+            } else if (key == "interval") {
+                policy.min_interval = std::chrono::milliseconds(std::atoi(value.c_str()));
+            } else if (key == "queue") {
+                policy.max_pending = std::max(1, std::atoi(value.c_str()));
+            } else {
+                *result = "unknown policy " + key;
+                return false;
+            }
+        }
+        callback_policies_[uid] = policy;
+    }
+
+    // The registered callbacks of the uid follow the new policy, their pending notifications
+    // are sent on the scheduled flush
+    size_t updated = 0;
+    for (auto &c : callbacks_) {
+        if (c.uid == uid) {
+            c.policy = policy;
+            updated++;
+        }
+    }
+    *result = ::android::base::StringPrintf(
+            "uid %u: %zu sensors, interval %lldms, queue %zu, %zu callbacks updated", uid,
+            policy.sensors.size(), static_cast<long long>(policy.min_interval.count()),
+            policy.max_pending, updated);
+    return true;
+}
+
+void Thermal::dumpVirtualSensorInfo(std::ostringstream *dump_buf, const DumpOptions &options) {
     *dump_buf << "getVirtualSensorInfo:" << std::endl;
     const auto &map = thermal_helper_->GetSensorInfoMap();
     for (const auto &sensor_info_pair : map) {
+        if (!options.matchSensor(sensor_info_pair.first)) {
+            continue;
+        }
         if (sensor_info_pair.second.virtual_sensor_info != nullptr) {
             *dump_buf << " Name: " << sensor_info_pair.first << std::endl;
             *dump_buf << "  LinkedSensorName: [";
@@ -286,12 +451,14 @@ void Thermal::dumpVirtualSensorInfo(std::ostringstream *dump_buf) {
     }
 }
 
-void Thermal::dumpThrottlingInfo(std::ostringstream *dump_buf) {
+void Thermal::dumpThrottlingInfo(std::ostringstream *dump_buf, const DumpOptions &options) {
     *dump_buf << "getThrottlingInfo:" << std::endl;
     const auto &map = thermal_helper_->GetSensorInfoMap();
-    const auto &thermal_throttling_status_map = thermal_helper_->GetThermalThrottlingStatusMap();
+    const auto thermal_throttling_status_map =
+            thermal_helper_->GetThermalThrottlingStatusSnapshot();
     for (const auto &name_info_pair : map) {
-        if (name_info_pair.second.throttling_info == nullptr) {
+        if (name_info_pair.second.throttling_info == nullptr ||
+            !options.matchSensor(name_info_pair.first)) {
             continue;
         }
         if (name_info_pair.second.throttling_info->binded_cdev_info_map.size()) {
@@ -405,11 +572,19 @@ void Thermal::dumpThrottlingInfo(std::ostringstream *dump_buf) {
                         case ReleaseLogic::RELEASE_TO_FLOOR:
                             *dump_buf << "RELEASE_TO_FLOOR";
                             break;
+                        case ReleaseLogic::PREDICTIVE:
+                            *dump_buf << "PREDICTIVE";
+                            break;
                         default:
                             *dump_buf << "NONE";
                             break;
                     }
                     *dump_buf << std::endl;
+                    if (binded_cdev_info_pair.second.release_step_limit !=
+                        std::numeric_limits<int>::max()) {
+                        *dump_buf << "    Release step limit: "
+                                  << binded_cdev_info_pair.second.release_step_limit << std::endl;
+                    }
                     *dump_buf << "    high_power_check: " << std::boolalpha
                               << binded_cdev_info_pair.second.high_power_check << std::endl;
                     *dump_buf << "    throttling_with_power_link: " << std::boolalpha
@@ -421,13 +596,18 @@ void Thermal::dumpThrottlingInfo(std::ostringstream *dump_buf) {
     }
 }
 
-void Thermal::dumpThrottlingRequestStatus(std::ostringstream *dump_buf) {
-    const auto &thermal_throttling_status_map = thermal_helper_->GetThermalThrottlingStatusMap();
+void Thermal::dumpThrottlingRequestStatus(std::ostringstream *dump_buf,
+                                          const DumpOptions &options) {
+    const auto thermal_throttling_status_map =
+            thermal_helper_->GetThermalThrottlingStatusSnapshot();
     if (!thermal_throttling_status_map.size()) {
         return;
     }
     *dump_buf << "getThrottlingRequestStatus:" << std::endl;
     for (const auto &thermal_throttling_status_pair : thermal_throttling_status_map) {
+        if (!options.matchSensor(thermal_throttling_status_pair.first)) {
+            continue;
+        }
         *dump_buf << " Name: " << thermal_throttling_status_pair.first << std::endl;
         if (thermal_throttling_status_pair.second.pid_power_budget_map.size()) {
             *dump_buf << "  power budget request state" << std::endl;
@@ -473,7 +653,7 @@ void Thermal::dumpThrottlingRequestStatus(std::ostringstream *dump_buf) {
 
 void Thermal::dumpPowerRailInfo(std::ostringstream *dump_buf) {
     const auto &power_rail_info_map = thermal_helper_->GetPowerRailInfoMap();
-    const auto &power_status_map = thermal_helper_->GetPowerStatusMap();
+    const auto power_status_map = thermal_helper_->GetPowerStatusSnapshot();
 
     *dump_buf << "getPowerRailInfo:" << std::endl;
     for (const auto &power_rail_pair : power_rail_info_map) {
@@ -518,6 +698,10 @@ void Thermal::dumpPowerRailInfo(std::ostringstream *dump_buf) {
                               << power_rail_pair.second.virtual_power_rail_info->coefficients[i]
                               << std::endl;
                     *dump_buf << "   Power Samples: ";
+                    if (power_status_map.count(power_rail_pair.second.virtual_power_rail_info
+                                                       ->linked_power_rails[i])) {
+                        *dump_buf << "shared power rail";
+                    }
                 } else {
                     *dump_buf << "  Power Samples: ";
                 }
@@ -548,12 +732,15 @@ void Thermal::dumpStatsRecord(std::ostringstream *dump_buf, const StatsRecord &s
     *dump_buf << "]" << std::endl;
 }
 
-void Thermal::dumpThermalStats(std::ostringstream *dump_buf) {
+void Thermal::dumpThermalStats(std::ostringstream *dump_buf, const DumpOptions &options) {
     *dump_buf << "getThermalStatsInfo:" << std::endl;
     *dump_buf << " Sensor Temp Stats Info:" << std::endl;
     const auto &sensor_temp_stats_map_ = thermal_helper_->GetSensorTempStatsSnapshot();
     const std::string sensor_temp_stats_line_prefix("    ");
     for (const auto &sensor_temp_stats_pair : sensor_temp_stats_map_) {
+        if (!options.matchSensor(sensor_temp_stats_pair.first)) {
+            continue;
+        }
         *dump_buf << "  Sensor Name: " << sensor_temp_stats_pair.first << std::endl;
         const auto &sensor_temp_stats = sensor_temp_stats_pair.second;
         *dump_buf << "   Max Temp: " << sensor_temp_stats.max_temp << ", TimeStamp: "
@@ -585,6 +772,9 @@ void Thermal::dumpThermalStats(std::ostringstream *dump_buf) {
             thermal_helper_->GetSensorCoolingDeviceRequestStatsSnapshot();
     const std::string sensor_cdev_request_stats_line_prefix("     ");
     for (const auto &sensor_cdev_request_stats_pair : sensor_cdev_request_stats_map_) {
+        if (!options.matchSensor(sensor_cdev_request_stats_pair.first)) {
+            continue;
+        }
         *dump_buf << "  Sensor Name: " << sensor_cdev_request_stats_pair.first << std::endl;
         for (const auto &cdev_request_stats_pair : sensor_cdev_request_stats_pair.second) {
             *dump_buf << "   Cooling Device Name: " << cdev_request_stats_pair.first << std::endl;
@@ -611,158 +801,435 @@ void Thermal::dumpThermalStats(std::ostringstream *dump_buf) {
     }
 }
 
-void Thermal::dumpThermalData(int fd) {
-    std::ostringstream dump_buf;
+void Thermal::dumpThermalHistograms(std::ostringstream *dump_buf, const DumpOptions &options) {
+    const auto histograms_snapshot = thermal_helper_->GetThermalHistogramsSnapshot();
+    const auto dump_percentiles = [dump_buf](const HistogramSnapshot &histogram) {
+        *dump_buf << "Count: " << histogram.count << " P50: " << histogram.getPercentile(50)
+                  << " P95: " << histogram.getPercentile(95)
+                  << " P99: " << histogram.getPercentile(99)
+                  << " Max: " << histogram.getPercentile(100);
+    };
+
+    *dump_buf << "getThermalHistograms:" << std::endl;
+    *dump_buf << " Sensor Temp:" << std::endl;
+    for (const auto &[sensor, histogram] : histograms_snapshot.sensor_temp) {
+        if (!options.matchSensor(sensor)) {
+            continue;
+        }
+        *dump_buf << "  Name: " << sensor << " ";
+        dump_percentiles(histogram);
+        *dump_buf << std::endl;
+    }
+    *dump_buf << " Sensor Time To Mitigate ms:" << std::endl;
+    for (const auto &[sensor, histogram] : histograms_snapshot.sensor_time_to_mitigate) {
+        if (!histogram.count || !options.matchSensor(sensor)) {
+            continue;
+        }
+        *dump_buf << "  Name: " << sensor << " ";
+        dump_percentiles(histogram);
+        *dump_buf << std::endl;
+    }
+    *dump_buf << " Cdev State Dwell ms:" << std::endl;
+    for (const auto &[cdev, state_histograms] : histograms_snapshot.cdev_state_dwell) {
+        *dump_buf << "  Name: " << cdev << std::endl;
+        for (size_t state = 0; state < state_histograms.size(); ++state) {
+            if (!state_histograms[state].count) {
+                continue;
+            }
+            *dump_buf << "   State " << state << ": ";
+            dump_percentiles(state_histograms[state]);
+            *dump_buf << std::endl;
+        }
+    }
+}
+
+void Thermal::dumpThermalForecast(std::ostringstream *dump_buf, const DumpOptions &options) {
+    const auto forecast_map = thermal_helper_->GetSensorForecastSnapshot();
+    const auto now = boot_clock::now();
+
+    *dump_buf << "getThermalForecast:" << std::endl;
+    *dump_buf << " Horizon: " << thermal_helper_->GetForecastHorizon().count() << "ms" << std::endl;
+    for (const auto &forecast_pair : forecast_map) {
+        if (!options.matchSensor(forecast_pair.first)) {
+            continue;
+        }
+        const auto &forecast = forecast_pair.second;
+        *dump_buf << " Name: " << forecast_pair.first << " Temp: " << forecast.temp
+                  << " Slope: " << forecast.slope << "/s"
+                  << " Power: " << forecast.power << "mW"
+                  << " NextSeverity: " << toString(forecast.next_severity)
+                  << " TimeToThreshold: ";
+        if (forecast.time_to_threshold == std::chrono::milliseconds::max()) {
+            *dump_buf << "N/A";
+        } else {
+            *dump_buf << forecast.time_to_threshold.count() << "ms";
+        }
+        *dump_buf << " PredictedTemp: " << forecast.predicted_temp
+                  << " PredictedHeadroom: " << forecast.predicted_headroom << " Age: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(now - forecast.timestamp)
+                             .count()
+                  << "ms" << std::endl;
+    }
+}
+
+void Thermal::dumpCachedTemperatures(std::ostringstream *dump_buf, const DumpOptions &options) {
+    *dump_buf << "getCachedTemperatures:" << std::endl;
+    const auto sensor_status_map = thermal_helper_->GetSensorStatusSnapshot();
+    const auto now = boot_clock::now();
+    for (const auto &[sensor, sensor_status] : sensor_status_map) {
+        if (sensor_status.thermal_cached.timestamp == boot_clock::time_point::min() ||
+            !options.matchSensor(sensor)) {
+            continue;
+        }
+        *dump_buf << " Name: " << sensor << " CachedValue: " << sensor_status.thermal_cached.temp
+                  << " TimeToCache: "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(
+                             now - sensor_status.thermal_cached.timestamp)
+                             .count()
+                  << "ms" << std::endl;
+    }
+    *dump_buf << "getEmulSettings:" << std::endl;
+    for (const auto &[sensor, sensor_status] : sensor_status_map) {
+        if (!sensor_status.emul_temp.has_value() || !options.matchSensor(sensor)) {
+            continue;
+        }
+        *dump_buf << " Name: " << sensor << " EmulTemp: " << sensor_status.emul_temp->temp
+                  << " EmulSeverity: " << sensor_status.emul_temp->severity
+                  << " maxThrottling: " << std::boolalpha << sensor_status.max_throttling
+                  << std::endl;
+    }
+}
+
+void Thermal::dumpCurrentTemperatures(std::ostringstream *dump_buf, const DumpOptions &options) {
+    const auto &map = thermal_helper_->GetSensorInfoMap();
+    // The published values are dumped unless asked, reading the sensors here would race with
+    // the thermal control on a hot device
+    const auto sensor_status_map = thermal_helper_->GetSensorStatusSnapshot();
+    *dump_buf << "getCurrentTemperatures:" << (options.fresh ? "" : " (cached)") << std::endl;
+    for (const auto &name_info_pair : map) {
+        if (!options.matchSensor(name_info_pair.first)) {
+            continue;
+        }
+        Temperature temp_2_0;
+        if (options.fresh) {
+            thermal_helper_->readTemperature(name_info_pair.first, &temp_2_0, nullptr, true);
+        } else {
+            const auto &sensor_status = sensor_status_map.at(name_info_pair.first);
+            temp_2_0.type = name_info_pair.second.type;
+            temp_2_0.value = sensor_status.thermal_cached.temp * name_info_pair.second.multiplier;
+            temp_2_0.throttlingStatus = sensor_status.severity;
+        }
+        *dump_buf << " Type: " << toString(temp_2_0.type) << " Name: " << name_info_pair.first
+                  << " CurrentValue: " << temp_2_0.value
+                  << " ThrottlingStatus: " << toString(temp_2_0.throttlingStatus) << std::endl;
+    }
+    *dump_buf << "getTemperatureThresholds:" << std::endl;
+    for (const auto &name_info_pair : map) {
+        if (!name_info_pair.second.is_watch || !options.matchSensor(name_info_pair.first)) {
+            continue;
+        }
+        *dump_buf << " Type: " << toString(name_info_pair.second.type)
+                  << " Name: " << name_info_pair.first;
+        *dump_buf << " hotThrottlingThreshold: [";
+        for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
+            *dump_buf << name_info_pair.second.hot_thresholds[i] << " ";
+        }
+        *dump_buf << "] coldThrottlingThreshold: [";
+        for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
+            *dump_buf << name_info_pair.second.cold_thresholds[i] << " ";
+        }
+        *dump_buf << "] vrThrottlingThreshold: " << name_info_pair.second.vr_threshold;
+        *dump_buf << std::endl;
+    }
+    *dump_buf << "getHysteresis:" << std::endl;
+    for (const auto &name_info_pair : map) {
+        if (!name_info_pair.second.is_watch || !options.matchSensor(name_info_pair.first)) {
+            continue;
+        }
+        *dump_buf << " Name: " << name_info_pair.first;
+        *dump_buf << " hotHysteresis: [";
+        for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
+            *dump_buf << name_info_pair.second.hot_hysteresis[i] << " ";
+        }
+        *dump_buf << "] coldHysteresis: [";
+        for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
+            *dump_buf << name_info_pair.second.cold_hysteresis[i] << " ";
+        }
+        *dump_buf << "]" << std::endl;
+    }
+}
+
+void Thermal::dumpCoolingDevices(std::ostringstream *dump_buf, const DumpOptions &options) {
+    // As the temperatures, the requested states are dumped unless asked to read the devices
+    *dump_buf << "getCurrentCoolingDevices:" << (options.fresh ? "" : " (requested)") << std::endl;
+    std::vector<CoolingDevice> cooling_devices;
+    if (!options.fresh) {
+        cooling_devices = thermal_helper_->GetCoolingDeviceSnapshot();
+    } else if (!thermal_helper_->fillCurrentCoolingDevices(false, CoolingType::CPU,
+                                                           &cooling_devices)) {
+        *dump_buf << " Failed to getCurrentCoolingDevices." << std::endl;
+    }
+
+    for (const auto &c : cooling_devices) {
+        *dump_buf << " Type: " << toString(c.type) << " Name: " << c.name
+                  << " CurrentValue: " << c.value << std::endl;
+    }
+}
+
+void Thermal::dumpCallbacks(std::ostringstream *dump_buf) {
+    {
+        std::lock_guard<std::mutex> _lock(thermal_callback_mutex_);
+        *dump_buf << "getCallbacks:" << std::endl;
+        *dump_buf << " Total: " << callbacks_.size() << std::endl;
+        for (const auto &c : callbacks_) {
+            *dump_buf << " IsFilter: " << c.is_filter_type << " Type: " << toString(c.type)
+                      << " Uid: " << c.uid << " Sensors: " << c.policy.sensors.size()
+                      << " MinInterval: " << c.policy.min_interval.count()
+                      << "ms Pending: " << c.pending.size() << " Dropped: " << c.dropped_count
+                      << std::endl;
+        }
+    }
+    const auto &map = thermal_helper_->GetSensorInfoMap();
+    *dump_buf << "sendCallback:" << std::endl;
+    *dump_buf << "  Enabled List: ";
+    for (const auto &name_info_pair : map) {
+        if (name_info_pair.second.send_cb) {
+            *dump_buf << name_info_pair.first << " ";
+        }
+    }
+    *dump_buf << std::endl;
+    *dump_buf << "sendPowerHint:" << std::endl;
+    *dump_buf << "  Enabled List: ";
+    for (const auto &name_info_pair : map) {
+        if (name_info_pair.second.send_powerhint) {
+            *dump_buf << name_info_pair.first << " ";
+        }
+    }
+    *dump_buf << std::endl;
+}
+
+void Thermal::dumpPowerHalInfo(std::ostringstream *dump_buf) {
+    *dump_buf << "getAIDLPowerHalInfo:" << std::endl;
+    *dump_buf << " Exist: " << std::boolalpha << thermal_helper_->isAidlPowerHalExist()
+              << std::endl;
+    *dump_buf << " Connected: " << std::boolalpha << thermal_helper_->isPowerHalConnected()
+              << std::endl;
+    *dump_buf << " Ext connected: " << std::boolalpha << thermal_helper_->isPowerHalExtConnected()
+              << std::endl;
+}
 
+void Thermal::dumpThermalJson(int fd, const DumpOptions &options) {
+    Json::Value root;
     if (!thermal_helper_->isInitializedOk()) {
-        dump_buf << "ThermalHAL not initialized properly." << std::endl;
+        root["error"] = "ThermalHAL not initialized properly.";
     } else {
-        const auto &sensor_status_map = thermal_helper_->GetSensorStatusMap();
-        {
-            dump_buf << "getCachedTemperatures:" << std::endl;
-            boot_clock::time_point now = boot_clock::now();
-            for (const auto &sensor_status_pair : sensor_status_map) {
-                if ((sensor_status_pair.second.thermal_cached.timestamp) ==
-                    boot_clock::time_point::min()) {
+        const auto config_lock = thermal_helper_->LockConfigShared();
+        const auto &sensor_info_map = thermal_helper_->GetSensorInfoMap();
+        const auto sensor_status_map = thermal_helper_->GetSensorStatusSnapshot();
+        const auto forecast_map = thermal_helper_->GetSensorForecastSnapshot();
+        const auto now = boot_clock::now();
+        if (options.matchSection("temperatures")) {
+            for (const auto &[sensor, sensor_info] : sensor_info_map) {
+                if (!options.matchSensor(sensor)) {
                     continue;
                 }
-                dump_buf << " Name: " << sensor_status_pair.first
-                         << " CachedValue: " << sensor_status_pair.second.thermal_cached.temp
-                         << " TimeToCache: "
-                         << std::chrono::duration_cast<std::chrono::milliseconds>(
-                                    now - sensor_status_pair.second.thermal_cached.timestamp)
-                                    .count()
-                         << "ms" << std::endl;
+                Json::Value sensor_value;
+                Temperature temp;
+                if (options.fresh &&
+                    thermal_helper_->readTemperature(sensor, &temp, nullptr, true)) {
+                    sensor_value["value"] = temp.value;
+                    sensor_value["severity"] = toString(temp.throttlingStatus);
+                } else {
+                    const auto &sensor_status = sensor_status_map.at(sensor);
+                    sensor_value["value"] =
+                            sensor_status.thermal_cached.temp * sensor_info.multiplier;
+                    sensor_value["severity"] = toString(sensor_status.severity);
+                    if (sensor_status.thermal_cached.timestamp != boot_clock::time_point::min()) {
+                        sensor_value["ageMs"] = static_cast<Json::Int64>(
+                                std::chrono::duration_cast<std::chrono::milliseconds>(
+                                        now - sensor_status.thermal_cached.timestamp)
+                                        .count());
+                    }
+                }
+                sensor_value["type"] = toString(sensor_info.type);
+                sensor_value["watched"] = sensor_info.is_watch;
+                if (sensor_info.is_watch) {
+                    for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
+                        sensor_value["hotThresholds"].append(sensor_info.hot_thresholds[i]);
+                    }
+                }
+                root["temperatures"][sensor] = sensor_value;
             }
         }
-        {
-            dump_buf << "getEmulSettings:" << std::endl;
-            for (const auto &sensor_status_pair : sensor_status_map) {
-                if (sensor_status_pair.second.override_status.emul_temp == nullptr) {
-                    continue;
-                }
-                dump_buf << " Name: " << sensor_status_pair.first << " EmulTemp: "
-                         << sensor_status_pair.second.override_status.emul_temp->temp
-                         << " EmulSeverity: "
-                         << sensor_status_pair.second.override_status.emul_temp->severity
-                         << " maxThrottling: " << std::boolalpha
-                         << sensor_status_pair.second.override_status.max_throttling << std::endl;
+        if (options.matchSection("cooling_devices")) {
+            std::vector<CoolingDevice> cooling_devices;
+            if (options.fresh) {
+                thermal_helper_->fillCurrentCoolingDevices(false, CoolingType::CPU,
+                                                           &cooling_devices);
+            } else {
+                cooling_devices = thermal_helper_->GetCoolingDeviceSnapshot();
+            }
+            for (const auto &c : cooling_devices) {
+                root["coolingDevices"][c.name]["type"] = toString(c.type);
+                root["coolingDevices"][c.name]["value"] = static_cast<Json::Int64>(c.value);
             }
         }
-        {
-            const auto &map = thermal_helper_->GetSensorInfoMap();
-            dump_buf << "getCurrentTemperatures:" << std::endl;
-            Temperature temp_2_0;
-            for (const auto &name_info_pair : map) {
-                thermal_helper_->readTemperature(name_info_pair.first, &temp_2_0, nullptr, true);
-                dump_buf << " Type: " << toString(temp_2_0.type)
-                         << " Name: " << name_info_pair.first << " CurrentValue: " << temp_2_0.value
-                         << " ThrottlingStatus: " << toString(temp_2_0.throttlingStatus)
-                         << std::endl;
-            }
-            dump_buf << "getTemperatureThresholds:" << std::endl;
-            for (const auto &name_info_pair : map) {
-                if (!name_info_pair.second.is_watch) {
+        if (options.matchSection("throttling_request")) {
+            for (const auto &[sensor, throttling_status] :
+                 thermal_helper_->GetThermalThrottlingStatusSnapshot()) {
+                if (!options.matchSensor(sensor)) {
                     continue;
                 }
-                dump_buf << " Type: " << toString(name_info_pair.second.type)
-                         << " Name: " << name_info_pair.first;
-                dump_buf << " hotThrottlingThreshold: [";
-                for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
-                    dump_buf << name_info_pair.second.hot_thresholds[i] << " ";
-                }
-                dump_buf << "] coldThrottlingThreshold: [";
-                for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
-                    dump_buf << name_info_pair.second.cold_thresholds[i] << " ";
+                for (const auto &[cdev, request] : throttling_status.cdev_status_map) {
+                    root["throttlingRequest"][sensor][cdev] = request;
                 }
-                dump_buf << "] vrThrottlingThreshold: " << name_info_pair.second.vr_threshold;
-                dump_buf << std::endl;
             }
-            dump_buf << "getHysteresis:" << std::endl;
-            for (const auto &name_info_pair : map) {
-                if (!name_info_pair.second.is_watch) {
+        }
+        if (options.matchSection("forecast")) {
+            for (const auto &[sensor, forecast] : forecast_map) {
+                if (!options.matchSensor(sensor)) {
                     continue;
                 }
-                dump_buf << " Name: " << name_info_pair.first;
-                dump_buf << " hotHysteresis: [";
-                for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
-                    dump_buf << name_info_pair.second.hot_hysteresis[i] << " ";
+                Json::Value forecast_value;
+                forecast_value["slope"] = forecast.slope;
+                forecast_value["predictedTemp"] = forecast.predicted_temp;
+                forecast_value["predictedHeadroom"] = forecast.predicted_headroom;
+                forecast_value["nextSeverity"] = toString(forecast.next_severity);
+                if (forecast.time_to_threshold != std::chrono::milliseconds::max()) {
+                    forecast_value["timeToThresholdMs"] =
+                            static_cast<Json::Int64>(forecast.time_to_threshold.count());
                 }
-                dump_buf << "] coldHysteresis: [";
-                for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
-                    dump_buf << name_info_pair.second.cold_hysteresis[i] << " ";
-                }
-                dump_buf << "]" << std::endl;
+                root["forecast"][sensor] = forecast_value;
             }
         }
-        {
-            dump_buf << "getCurrentCoolingDevices:" << std::endl;
-            std::vector<CoolingDevice> cooling_devices;
-            if (!thermal_helper_->fillCurrentCoolingDevices(false, CoolingType::CPU,
-                                                            &cooling_devices)) {
-                dump_buf << " Failed to getCurrentCoolingDevices." << std::endl;
-            }
-
-            for (const auto &c : cooling_devices) {
-                dump_buf << " Type: " << toString(c.type) << " Name: " << c.name
-                         << " CurrentValue: " << c.value << std::endl;
+        if (options.matchSection("power_rails")) {
+            for (const auto &[power_rail, power_status] :
+                 thermal_helper_->GetPowerStatusSnapshot()) {
+                root["powerRails"][power_rail] = power_status.last_updated_avg_power;
             }
         }
-        {
-            dump_buf << "getCallbacks:" << std::endl;
-            dump_buf << " Total: " << callbacks_.size() << std::endl;
-            for (const auto &c : callbacks_) {
-                dump_buf << " IsFilter: " << c.is_filter_type << " Type: " << toString(c.type)
-                         << std::endl;
-            }
-        }
-        {
-            dump_buf << "sendCallback:" << std::endl;
-            dump_buf << "  Enabled List: ";
-            const auto &map = thermal_helper_->GetSensorInfoMap();
-            for (const auto &name_info_pair : map) {
-                if (name_info_pair.second.send_cb) {
-                    dump_buf << name_info_pair.first << " ";
+        if (options.matchSection("histograms")) {
+            const auto histograms_snapshot = thermal_helper_->GetThermalHistogramsSnapshot();
+            const auto to_json = [](const HistogramSnapshot &histogram) {
+                Json::Value value;
+                value["count"] = static_cast<Json::UInt64>(histogram.count);
+                value["p50"] = histogram.getPercentile(50);
+                value["p95"] = histogram.getPercentile(95);
+                value["p99"] = histogram.getPercentile(99);
+                return value;
+            };
+            for (const auto &[sensor, histogram] : histograms_snapshot.sensor_temp) {
+                if (options.matchSensor(sensor)) {
+                    root["histograms"]["sensorTemp"][sensor] = to_json(histogram);
                 }
             }
-            dump_buf << std::endl;
-        }
-        {
-            dump_buf << "sendPowerHint:" << std::endl;
-            dump_buf << "  Enabled List: ";
-            const auto &map = thermal_helper_->GetSensorInfoMap();
-            for (const auto &name_info_pair : map) {
-                if (name_info_pair.second.send_powerhint) {
-                    dump_buf << name_info_pair.first << " ";
+            for (const auto &[sensor, histogram] : histograms_snapshot.sensor_time_to_mitigate) {
+                if (options.matchSensor(sensor) && histogram.count) {
+                    root["histograms"]["timeToMitigateMs"][sensor] = to_json(histogram);
                 }
             }
-            dump_buf << std::endl;
-        }
-        dumpVirtualSensorInfo(&dump_buf);
-        dumpThrottlingInfo(&dump_buf);
-        dumpThrottlingRequestStatus(&dump_buf);
-        dumpPowerRailInfo(&dump_buf);
-        dumpThermalStats(&dump_buf);
-        {
-            dump_buf << "getAIDLPowerHalInfo:" << std::endl;
-            dump_buf << " Exist: " << std::boolalpha << thermal_helper_->isAidlPowerHalExist()
-                     << std::endl;
-            dump_buf << " Connected: " << std::boolalpha << thermal_helper_->isPowerHalConnected()
-                     << std::endl;
-            dump_buf << " Ext connected: " << std::boolalpha
-                     << thermal_helper_->isPowerHalExtConnected() << std::endl;
         }
     }
-    std::string buf = dump_buf.str();
-    if (!::android::base::WriteStringToFd(buf, fd)) {
+
+    Json::StreamWriterBuilder writer_builder;
+    writer_builder["indentation"] = " ";
+    if (!::android::base::WriteStringToFd(Json::writeString(writer_builder, root) + "\n", fd)) {
         PLOG(ERROR) << "Failed to dump state to fd";
     }
     fsync(fd);
 }
 
+void Thermal::dumpThermalData(int fd, const DumpOptions &options) {
+    if (options.json) {
+        dumpThermalJson(fd, options);
+        return;
+    }
+    if (!thermal_helper_->isInitializedOk()) {
+        if (!::android::base::WriteStringToFd("ThermalHAL not initialized properly.\n", fd)) {
+            PLOG(ERROR) << "Failed to dump state to fd";
+        }
+        fsync(fd);
+        return;
+    }
+
+    // Each section is written once it is formatted, so that a large dump is neither kept in
+    // memory nor holding any state while it is being written out
+    const std::vector<std::pair<std::string_view, std::function<void(std::ostringstream *)>>>
+            sections = {
+                    {"cached",
+                     [&](std::ostringstream *buf) { dumpCachedTemperatures(buf, options); }},
+                    {"temperatures",
+                     [&](std::ostringstream *buf) { dumpCurrentTemperatures(buf, options); }},
+                    {"cooling_devices",
+                     [&](std::ostringstream *buf) { dumpCoolingDevices(buf, options); }},
+                    {"freq_cdev",
+                     [&](std::ostringstream *buf) { thermal_helper_->dumpFreqCoolingDevices(buf); }},
+                    {"callbacks", [&](std::ostringstream *buf) { dumpCallbacks(buf); }},
+                    {"virtual_sensor",
+                     [&](std::ostringstream *buf) { dumpVirtualSensorInfo(buf, options); }},
+                    {"throttling",
+                     [&](std::ostringstream *buf) { dumpThrottlingInfo(buf, options); }},
+                    {"throttling_request",
+                     [&](std::ostringstream *buf) { dumpThrottlingRequestStatus(buf, options); }},
+                    {"forecast",
+                     [&](std::ostringstream *buf) { dumpThermalForecast(buf, options); }},
+                    {"power_rails", [&](std::ostringstream *buf) { dumpPowerRailInfo(buf); }},
+                    {"stats", [&](std::ostringstream *buf) { dumpThermalStats(buf, options); }},
+                    {"histograms",
+                     [&](std::ostringstream *buf) { dumpThermalHistograms(buf, options); }},
+                    {"sample_log",
+                     [&](std::ostringstream *buf) {
+                         thermal_helper_->dumpSampleLog(
+                                 buf, options.sensors.size() == 1 ? *options.sensors.begin() : "");
+                     }},
+                    {"scenario",
+                     [&](std::ostringstream *buf) { thermal_helper_->dumpScenario(buf); }},
+                    {"profile",
+                     [&](std::ostringstream *buf) { thermal_helper_->dumpProfile(buf); }},
+                    {"power_hal", [&](std::ostringstream *buf) { dumpPowerHalInfo(buf); }},
+            };
+    for (const auto &[section, dump_section] : sections) {
+        if (!options.matchSection(section)) {
+            continue;
+        }
+        std::ostringstream dump_buf;
+        {
+            // A config reload updates the tunables in place
+            const auto config_lock = thermal_helper_->LockConfigShared();
+            dump_section(&dump_buf);
+        }
+        if (!::android::base::WriteStringToFd(dump_buf.str(), fd)) {
+            PLOG(ERROR) << "Failed to dump " << section << " to fd";
+            break;
+        }
+    }
+    fsync(fd);
+}
+
 binder_status_t Thermal::dump(int fd, const char **args, uint32_t numArgs) {
     if (numArgs == 0 || std::string(args[0]) == "-a") {
-        dumpThermalData(fd);
+        dumpThermalData(fd, DumpOptions());
+        return STATUS_OK;
+    }
+
+    if (std::string(args[0]).starts_with("--")) {
+        DumpOptions options;
+        for (uint32_t i = 0; i < numArgs; ++i) {
+            const std::string arg(args[i]);
+            if (arg == "--fresh") {
+                options.fresh = true;
+            } else if (arg == "--json") {
+                options.json = true;
+            } else if (arg == "--sensor" && i + 1 < numArgs) {
+                options.sensors.insert(args[++i]);
+            } else if (arg == "--section" && i + 1 < numArgs) {
+                options.sections.insert(args[++i]);
+            } else {
+                LOG(ERROR) << "Unknown dump option " << arg;
+                return STATUS_BAD_VALUE;
+            }
+        }
+        dumpThermalData(fd, options);
         return STATUS_OK;
     }
 
@@ -782,6 +1249,66 @@ binder_status_t Thermal::dump(int fd, const char **args, uint32_t numArgs) {
         return (numArgs != 2 || !thermal_helper_->emulClear(std::string(args[1])))
                        ? STATUS_BAD_VALUE
                        : STATUS_OK;
+    } else if (std::string(args[0]) == "forecast") {
+        std::ostringstream dump_buf;
+        dumpThermalForecast(&dump_buf, DumpOptions());
+        if (!::android::base::WriteStringToFd(dump_buf.str(), fd)) {
+            PLOG(ERROR) << "Failed to dump forecast to fd";
+        }
+        fsync(fd);
+        return STATUS_OK;
+    } else if (std::string(args[0]) == "sample_log") {
+        std::ostringstream dump_buf;
+        thermal_helper_->dumpSampleLog(&dump_buf, numArgs >= 2 ? args[1] : "");
+        if (!::android::base::WriteStringToFd(dump_buf.str(), fd)) {
+            PLOG(ERROR) << "Failed to dump sample log to fd";
+        }
+        fsync(fd);
+        return STATUS_OK;
+    } else if (std::string(args[0]) == "reload") {
+        // reload [config file]
+        std::string result;
+        const bool ret = thermal_helper_->reloadConfig(numArgs >= 2 ? args[1] : "", &result);
+        if (!::android::base::WriteStringToFd(result + "\n", fd)) {
+            PLOG(ERROR) << "Failed to dump reload result to fd";
+        }
+        fsync(fd);
+        return ret ? STATUS_OK : STATUS_BAD_VALUE;
+    } else if (std::string(args[0]) == "callback_policy") {
+        std::string result;
+        const bool ret = setCallbackPolicy(args, numArgs, &result);
+        if (!::android::base::WriteStringToFd(result + "\n", fd)) {
+            PLOG(ERROR) << "Failed to dump callback policy result to fd";
+        }
+        fsync(fd);
+        return ret ? STATUS_OK : STATUS_BAD_VALUE;
+    } else if (std::string(args[0]) == "scenario" && numArgs >= 2) {
+        const std::string command(args[1]);
+        if (command == "start" && numArgs >= 3) {
+            // scenario start <file|inline script> [loop] [speed]
+            bool loop = false;
+            float speed = 1.0;
+            for (uint32_t i = 3; i < numArgs; ++i) {
+                if (std::string(args[i]) == "loop") {
+                    loop = true;
+                } else {
+                    speed = std::atof(args[i]);
+                }
+            }
+            return thermal_helper_->startScenario(args[2], loop, speed) ? STATUS_OK
+                                                                        : STATUS_BAD_VALUE;
+        } else if (command == "stop") {
+            thermal_helper_->stopScenario();
+            return STATUS_OK;
+        } else if (command == "status") {
+            std::ostringstream dump_buf;
+            thermal_helper_->dumpScenario(&dump_buf);
+            if (!::android::base::WriteStringToFd(dump_buf.str(), fd)) {
+                PLOG(ERROR) << "Failed to dump scenario to fd";
+            }
+            fsync(fd);
+            return STATUS_OK;
+        }
     }
     return STATUS_BAD_VALUE;
 }
@@ -792,6 +1319,13 @@ void Thermal::Looper::addEvent(const Thermal::Looper::Event &e) {
     cv_.notify_all();
 }
 
+void Thermal::Looper::addDelayedEvent(const Thermal::Looper::Event &e,
+                                      boot_clock::time_point time) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    delayed_events_.emplace(time, e);
+    cv_.notify_all();
+}
+
 Thermal::Looper::~Looper() {
     {
         std::unique_lock<std::mutex> lock(mutex_);
@@ -804,13 +1338,28 @@ Thermal::Looper::~Looper() {
 void Thermal::Looper::loop() {
     while (!aborted_) {
         std::unique_lock<std::mutex> lock(mutex_);
-        cv_.wait(lock, [&] { return aborted_ || !events_.empty(); });
-        if (!aborted_ && !events_.empty()) {
-            Event event = events_.front();
-            events_.pop();
-            lock.unlock();
-            event.handler();
+        if (aborted_) {
+            break;
+        }
+        for (auto it = delayed_events_.begin();
+             it != delayed_events_.end() && it->first <= boot_clock::now();
+             it = delayed_events_.erase(it)) {
+            events_.push(it->second);
+        }
+        if (events_.empty()) {
+            // Woken up by a new event, or at the time of the first delayed one
+            if (delayed_events_.empty()) {
+                cv_.wait(lock);
+            } else {
+                cv_.wait_for(lock, std::max(delayed_events_.begin()->first - boot_clock::now(),
+                                            boot_clock::duration::zero()));
+            }
+            continue;
         }
+        Event event = events_.front();
+        events_.pop();
+        lock.unlock();
+        event.handler();
     }
 }
 
@@ -8,8 +8,14 @@
 
 #include <aidl/android/hardware/thermal/BnThermal.h>
 
+#include <chrono>
+#include <map>
 #include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <vector>
 
 #include "thermal-helper.h"
 
@@ -19,13 +25,53 @@ namespace hardware {
 namespace thermal {
 namespace implementation {
 
+constexpr size_t kDefaultMaxPendingCallbacks = 16;
+
+// How the notifications to the callbacks of a client uid are filtered and paced, set with the
+// callback_policy dump command since the AIDL registration only carries a type
+struct CallbackPolicy {
+    // Empty means all the sensors of the registered type
+    std::set<std::string, std::less<>> sensors;
+    // The notifications closer than this to the previous one are coalesced, the latest per
+    // sensor is sent once the interval elapsed. SEVERE and above are always sent right away.
+    std::chrono::milliseconds min_interval = std::chrono::milliseconds::zero();
+    // The coalesced notifications held for the client, the oldest is dropped beyond
+    size_t max_pending = kDefaultMaxPendingCallbacks;
+};
+
 struct CallbackSetting {
     CallbackSetting(std::shared_ptr<IThermalChangedCallback> callback, bool is_filter_type,
-                    TemperatureType type)
-        : callback(std::move(callback)), is_filter_type(is_filter_type), type(type) {}
+                    TemperatureType type, uid_t uid, CallbackPolicy policy)
+        : callback(std::move(callback)),
+          is_filter_type(is_filter_type),
+          type(type),
+          uid(uid),
+          policy(std::move(policy)) {}
     std::shared_ptr<IThermalChangedCallback> callback;
     bool is_filter_type;
     TemperatureType type;
+    uid_t uid;
+    CallbackPolicy policy;
+    boot_clock::time_point last_notify_time = boot_clock::time_point::min();
+    // The coalesced notifications, at most one per sensor in arrival order
+    std::vector<Temperature> pending;
+    bool is_flush_scheduled = false;
+    size_t dropped_count = 0;
+};
+
+// Dump arguments, empty sensors or sections mean everything
+struct DumpOptions {
+    std::set<std::string, std::less<>> sensors;
+    std::set<std::string, std::less<>> sections;
+    // Read the sensors instead of dumping the last published values
+    bool fresh = false;
+    bool json = false;
+    bool matchSensor(std::string_view sensor) const {
+        return sensors.empty() || sensors.find(sensor) != sensors.end();
+    }
+    bool matchSection(std::string_view section) const {
+        return sections.empty() || sections.find(section) != sections.end();
+    }
 };
 
 class Thermal : public BnThermal {
@@ -71,10 +117,13 @@ class Thermal : public BnThermal {
         ~Looper();
 
         void addEvent(const Event &e);
+        // Run the event once the time is reached, after the events already due
+        void addDelayedEvent(const Event &e, boot_clock::time_point time);
 
       private:
         std::condition_variable cv_;
         std::queue<Event> events_;
+        std::multimap<boot_clock::time_point, Event> delayed_events_;
         std::mutex mutex_;
         std::thread thread_;
         bool aborted_;
@@ -85,6 +134,7 @@ class Thermal : public BnThermal {
     std::shared_ptr<ThermalHelper> thermal_helper_;
     std::mutex thermal_callback_mutex_;
     std::vector<CallbackSetting> callbacks_;
+    std::map<uid_t, CallbackPolicy> callback_policies_;
     Looper looper_;
 
     ndk::ScopedAStatus getFilteredTemperatures(bool filterType, TemperatureType type,
@@ -97,14 +147,33 @@ class Thermal : public BnThermal {
             const std::shared_ptr<IThermalChangedCallback> &callback, bool filterType,
             TemperatureType type);
 
-    void dumpVirtualSensorInfo(std::ostringstream *dump_buf);
-    void dumpThrottlingInfo(std::ostringstream *dump_buf);
-    void dumpThrottlingRequestStatus(std::ostringstream *dump_buf);
+    void dumpCachedTemperatures(std::ostringstream *dump_buf, const DumpOptions &options);
+    void dumpCurrentTemperatures(std::ostringstream *dump_buf, const DumpOptions &options);
+    void dumpCoolingDevices(std::ostringstream *dump_buf, const DumpOptions &options);
+    // Fill the last published temperatures of the callback sensors, return false if any of
+    // them is not published yet
+    bool fillPublishedTemperatures(bool filterType, TemperatureType type,
+                                   std::vector<Temperature> *temperatures) const;
+    // Send the notification now or coalesce it by the policy of the callback, return false if
+    // the callback is dead
+    bool notifyCallback(CallbackSetting *c, const Temperature &t, boot_clock::time_point now);
+    // Send the coalesced notifications of the callback, on the looper thread
+    void flushPendingCallback(const std::shared_ptr<IThermalChangedCallback> &callback);
+    // callback_policy <uid> [sensors <name,...>] [interval <ms>] [queue <count>] | clear
+    bool setCallbackPolicy(const char **args, uint32_t numArgs, std::string *result);
+    void dumpCallbacks(std::ostringstream *dump_buf);
+    void dumpVirtualSensorInfo(std::ostringstream *dump_buf, const DumpOptions &options);
+    void dumpThrottlingInfo(std::ostringstream *dump_buf, const DumpOptions &options);
+    void dumpThrottlingRequestStatus(std::ostringstream *dump_buf, const DumpOptions &options);
     void dumpPowerRailInfo(std::ostringstream *dump_buf);
     void dumpStatsRecord(std::ostringstream *dump_buf, const StatsRecord &stats_record,
                          std::string_view line_prefix);
-    void dumpThermalStats(std::ostringstream *dump_buf);
-    void dumpThermalData(int fd);
+    void dumpThermalStats(std::ostringstream *dump_buf, const DumpOptions &options);
+    void dumpThermalHistograms(std::ostringstream *dump_buf, const DumpOptions &options);
+    void dumpThermalForecast(std::ostringstream *dump_buf, const DumpOptions &options);
+    void dumpPowerHalInfo(std::ostringstream *dump_buf);
+    void dumpThermalJson(int fd, const DumpOptions &options);
+    void dumpThermalData(int fd, const DumpOptions &options);
 };
 
 }  // namespace implementation
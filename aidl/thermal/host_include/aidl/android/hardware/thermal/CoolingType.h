@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host copy of the CoolingType NDK header of android.hardware.thermal-V2, for the config parsers
+// built on the host. The values must match the AIDL interface.
+
+#pragma once
+
+#include <android/binder_enums.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+
+enum class CoolingType : int32_t {
+    FAN = 0,
+    BATTERY = 1,
+    CPU = 2,
+    GPU = 3,
+    MODEM = 4,
+    NPU = 5,
+    COMPONENT = 6,
+    TPU = 7,
+    POWER_AMPLIFIER = 8,
+    DISPLAY = 9,
+    SPEAKER = 10,
+    WIFI = 11,
+    CAMERA = 12,
+    FLASHLIGHT = 13,
+    USB_PORT = 14,
+};
+
+[[nodiscard]] static inline std::string toString(CoolingType val) {
+    switch (val) {
+        case CoolingType::FAN:
+            return "FAN";
+        case CoolingType::BATTERY:
+            return "BATTERY";
+        case CoolingType::CPU:
+            return "CPU";
+        case CoolingType::GPU:
+            return "GPU";
+        case CoolingType::MODEM:
+            return "MODEM";
+        case CoolingType::NPU:
+            return "NPU";
+        case CoolingType::COMPONENT:
+            return "COMPONENT";
+        case CoolingType::TPU:
+            return "TPU";
+        case CoolingType::POWER_AMPLIFIER:
+            return "POWER_AMPLIFIER";
+        case CoolingType::DISPLAY:
+            return "DISPLAY";
+        case CoolingType::SPEAKER:
+            return "SPEAKER";
+        case CoolingType::WIFI:
+            return "WIFI";
+        case CoolingType::CAMERA:
+            return "CAMERA";
+        case CoolingType::FLASHLIGHT:
+            return "FLASHLIGHT";
+        case CoolingType::USB_PORT:
+            return "USB_PORT";
+        default:
+            return std::to_string(static_cast<int32_t>(val));
+    }
+}
+
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
+
+namespace ndk {
+namespace internal {
+template <>
+constexpr inline std::array<aidl::android::hardware::thermal::CoolingType, 15> enum_values<aidl::android::hardware::thermal::CoolingType> = {
+        aidl::android::hardware::thermal::CoolingType::FAN,
+        aidl::android::hardware::thermal::CoolingType::BATTERY,
+        aidl::android::hardware::thermal::CoolingType::CPU,
+        aidl::android::hardware::thermal::CoolingType::GPU,
+        aidl::android::hardware::thermal::CoolingType::MODEM,
+        aidl::android::hardware::thermal::CoolingType::NPU,
+        aidl::android::hardware::thermal::CoolingType::COMPONENT,
+        aidl::android::hardware::thermal::CoolingType::TPU,
+        aidl::android::hardware::thermal::CoolingType::POWER_AMPLIFIER,
+        aidl::android::hardware::thermal::CoolingType::DISPLAY,
+        aidl::android::hardware::thermal::CoolingType::SPEAKER,
+        aidl::android::hardware::thermal::CoolingType::WIFI,
+        aidl::android::hardware::thermal::CoolingType::CAMERA,
+        aidl::android::hardware::thermal::CoolingType::FLASHLIGHT,
+        aidl::android::hardware::thermal::CoolingType::USB_PORT,
+};
+}  // namespace internal
+}  // namespace ndk
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host copy of the TemperatureType NDK header of android.hardware.thermal-V2, for the config parsers
+// built on the host. The values must match the AIDL interface.
+
+#pragma once
+
+#include <android/binder_enums.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+
+enum class TemperatureType : int32_t {
+    UNKNOWN = -1,
+    CPU = 0,
+    GPU = 1,
+    BATTERY = 2,
+    SKIN = 3,
+    USB_PORT = 4,
+    POWER_AMPLIFIER = 5,
+    BCL_VOLTAGE = 6,
+    BCL_CURRENT = 7,
+    BCL_PERCENTAGE = 8,
+    NPU = 9,
+    TPU = 10,
+    DISPLAY = 11,
+    MODEM = 12,
+    SOC = 13,
+    WIFI = 14,
+    CAMERA = 15,
+    FLASHLIGHT = 16,
+    SPEAKER = 17,
+    AMBIENT = 18,
+    POGO = 19,
+};
+
+[[nodiscard]] static inline std::string toString(TemperatureType val) {
+    switch (val) {
+        case TemperatureType::UNKNOWN:
+            return "UNKNOWN";
+        case TemperatureType::CPU:
+            return "CPU";
+        case TemperatureType::GPU:
+            return "GPU";
+        case TemperatureType::BATTERY:
+            return "BATTERY";
+        case TemperatureType::SKIN:
+            return "SKIN";
+        case TemperatureType::USB_PORT:
+            return "USB_PORT";
+        case TemperatureType::POWER_AMPLIFIER:
+            return "POWER_AMPLIFIER";
+        case TemperatureType::BCL_VOLTAGE:
+            return "BCL_VOLTAGE";
+        case TemperatureType::BCL_CURRENT:
+            return "BCL_CURRENT";
+        case TemperatureType::BCL_PERCENTAGE:
+            return "BCL_PERCENTAGE";
+        case TemperatureType::NPU:
+            return "NPU";
+        case TemperatureType::TPU:
+            return "TPU";
+        case TemperatureType::DISPLAY:
+            return "DISPLAY";
+        case TemperatureType::MODEM:
+            return "MODEM";
+        case TemperatureType::SOC:
+            return "SOC";
+        case TemperatureType::WIFI:
+            return "WIFI";
+        case TemperatureType::CAMERA:
+            return "CAMERA";
+        case TemperatureType::FLASHLIGHT:
+            return "FLASHLIGHT";
+        case TemperatureType::SPEAKER:
+            return "SPEAKER";
+        case TemperatureType::AMBIENT:
+            return "AMBIENT";
+        case TemperatureType::POGO:
+            return "POGO";
+        default:
+            return std::to_string(static_cast<int32_t>(val));
+    }
+}
+
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
+
+namespace ndk {
+namespace internal {
+template <>
+constexpr inline std::array<aidl::android::hardware::thermal::TemperatureType, 21> enum_values<aidl::android::hardware::thermal::TemperatureType> = {
+        aidl::android::hardware::thermal::TemperatureType::UNKNOWN,
+        aidl::android::hardware::thermal::TemperatureType::CPU,
+        aidl::android::hardware::thermal::TemperatureType::GPU,
+        aidl::android::hardware::thermal::TemperatureType::BATTERY,
+        aidl::android::hardware::thermal::TemperatureType::SKIN,
+        aidl::android::hardware::thermal::TemperatureType::USB_PORT,
+        aidl::android::hardware::thermal::TemperatureType::POWER_AMPLIFIER,
+        aidl::android::hardware::thermal::TemperatureType::BCL_VOLTAGE,
+        aidl::android::hardware::thermal::TemperatureType::BCL_CURRENT,
+        aidl::android::hardware::thermal::TemperatureType::BCL_PERCENTAGE,
+        aidl::android::hardware::thermal::TemperatureType::NPU,
+        aidl::android::hardware::thermal::TemperatureType::TPU,
+        aidl::android::hardware::thermal::TemperatureType::DISPLAY,
+        aidl::android::hardware::thermal::TemperatureType::MODEM,
+        aidl::android::hardware::thermal::TemperatureType::SOC,
+        aidl::android::hardware::thermal::TemperatureType::WIFI,
+        aidl::android::hardware::thermal::TemperatureType::CAMERA,
+        aidl::android::hardware::thermal::TemperatureType::FLASHLIGHT,
+        aidl::android::hardware::thermal::TemperatureType::SPEAKER,
+        aidl::android::hardware::thermal::TemperatureType::AMBIENT,
+        aidl::android::hardware::thermal::TemperatureType::POGO,
+};
+}  // namespace internal
+}  // namespace ndk
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host copy of the ThrottlingSeverity NDK header of android.hardware.thermal-V2, for the config parsers
+// built on the host. The values must match the AIDL interface.
+
+#pragma once
+
+#include <android/binder_enums.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+
+enum class ThrottlingSeverity : int32_t {
+    NONE = 0,
+    LIGHT = 1,
+    MODERATE = 2,
+    SEVERE = 3,
+    CRITICAL = 4,
+    EMERGENCY = 5,
+    SHUTDOWN = 6,
+};
+
+[[nodiscard]] static inline std::string toString(ThrottlingSeverity val) {
+    switch (val) {
+        case ThrottlingSeverity::NONE:
+            return "NONE";
+        case ThrottlingSeverity::LIGHT:
+            return "LIGHT";
+        case ThrottlingSeverity::MODERATE:
+            return "MODERATE";
+        case ThrottlingSeverity::SEVERE:
+            return "SEVERE";
+        case ThrottlingSeverity::CRITICAL:
+            return "CRITICAL";
+        case ThrottlingSeverity::EMERGENCY:
+            return "EMERGENCY";
+        case ThrottlingSeverity::SHUTDOWN:
+            return "SHUTDOWN";
+        default:
+            return std::to_string(static_cast<int32_t>(val));
+    }
+}
+
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
+
+namespace ndk {
+namespace internal {
+template <>
+constexpr inline std::array<aidl::android::hardware::thermal::ThrottlingSeverity, 7> enum_values<aidl::android::hardware::thermal::ThrottlingSeverity> = {
+        aidl::android::hardware::thermal::ThrottlingSeverity::NONE,
+        aidl::android::hardware::thermal::ThrottlingSeverity::LIGHT,
+        aidl::android::hardware::thermal::ThrottlingSeverity::MODERATE,
+        aidl::android::hardware::thermal::ThrottlingSeverity::SEVERE,
+        aidl::android::hardware::thermal::ThrottlingSeverity::CRITICAL,
+        aidl::android::hardware::thermal::ThrottlingSeverity::EMERGENCY,
+        aidl::android::hardware::thermal::ThrottlingSeverity::SHUTDOWN,
+};
+}  // namespace internal
+}  // namespace ndk
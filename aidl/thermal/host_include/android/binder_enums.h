@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host copy of the enum range of libbinder_ndk, for the config parsers built on the host
+
+#pragma once
+
+#include <array>
+#include <iterator>
+#include <type_traits>
+
+namespace ndk {
+namespace internal {
+// Specialized by the generated enum headers
+template <typename EnumType>
+extern std::array<EnumType, 0> enum_values;
+}  // namespace internal
+
+// Iterable range over the values of an AIDL enum
+template <typename EnumType, typename = std::enable_if_t<std::is_enum_v<EnumType>>>
+struct enum_range {
+    constexpr auto begin() const { return std::begin(internal::enum_values<EnumType>); }
+    constexpr auto end() const { return std::end(internal::enum_values<EnumType>); }
+};
+
+}  // namespace ndk
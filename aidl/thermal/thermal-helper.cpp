@@ -12,8 +12,11 @@
 #include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
+#include <sys/system_properties.h>
+#include <unistd.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
 #include <iterator>
 #include <set>
 #include <sstream>
@@ -34,14 +37,36 @@ constexpr std::string_view kSensorPolicyFile("policy");
 constexpr std::string_view kSensorTempSuffix("temp");
 constexpr std::string_view kSensorTripPointTempZeroFile("trip_point_0_temp");
 constexpr std::string_view kSensorTripPointHystZeroFile("trip_point_0_hyst");
+constexpr std::string_view kSensorTripPointTempOneFile("trip_point_1_temp");
+constexpr std::string_view kSensorTripPointHystOneFile("trip_point_1_hyst");
 constexpr std::string_view kUserSpaceSuffix("user_space");
 constexpr std::string_view kCoolingDeviceCurStateSuffix("cur_state");
 constexpr std::string_view kCoolingDeviceMaxStateSuffix("max_state");
 constexpr std::string_view kCoolingDeviceState2powerSuffix("state2power_table");
 constexpr std::string_view kConfigProperty("vendor.thermal.config");
 constexpr std::string_view kConfigDefaultFileName("thermal_info_config.json");
+constexpr std::string_view kConfigSchemaFileName("thermal_config_schema.json");
 constexpr std::string_view kThermalGenlProperty("persist.vendor.enable.thermal.genl");
 constexpr std::string_view kThermalDisabledProperty("vendor.disable.thermalhal.control");
+constexpr std::string_view kForecastHorizonProperty("vendor.thermal.forecast_horizon_ms");
+constexpr std::string_view kSampleLogIntervalProperty("vendor.thermal.sample_log_interval_ms");
+constexpr std::string_view kThermalProfilingProperty("persist.vendor.thermal.profiling");
+constexpr std::string_view kEvalWorkersProperty("persist.vendor.thermal.eval_workers");
+constexpr std::string_view kIoUringProperty("persist.vendor.thermal.io_uring");
+// Any new value reloads the config named by vendor.thermal.config
+constexpr std::string_view kConfigReloadProperty("vendor.thermal.reload");
+constexpr std::chrono::milliseconds kConfigReloadAbortCheckInterval(1000);
+constexpr std::string_view kConfigDir("/vendor/etc/");
+constexpr std::chrono::milliseconds kConfigReloadTimeoutMs = std::chrono::milliseconds(5000);
+// Parallel reads only pay off with enough cores and enough sensors due at once
+constexpr unsigned int kMinCoresForEvalWorkers = 8;
+constexpr size_t kMinParallelReadings = 4;
+constexpr size_t kMinBatchReadings = 2;
+// A boot time drift over the monotonic time beyond this is a system suspend
+constexpr std::chrono::milliseconds kMinSuspendDurationMs = std::chrono::milliseconds(1000);
+// After resume the cold sensors are read a few per tick, one tick per step
+constexpr size_t kResumeSensorsPerStep = 4;
+constexpr std::chrono::milliseconds kResumeStaggerStepMs = std::chrono::milliseconds(50);
 
 namespace {
 using ::android::base::StringPrintf;
@@ -67,19 +92,30 @@ std::unordered_map<std::string, std::string> parseThermalPathMap(std::string_vie
         std::string path = ::android::base::StringPrintf("%s/%s/%s", kThermalSensorsRoot.data(),
                                                          dp->d_name, kThermalNameFile.data());
         std::string name;
-        if (!::android::base::ReadFileToString(path, &name)) {
+        if (!ReadStaticThermalFile(path, &name)) {
             PLOG(ERROR) << "Failed to read from " << path;
             continue;
         }
 
-        path_map.emplace(
-                ::android::base::Trim(name),
-                ::android::base::StringPrintf("%s/%s", kThermalSensorsRoot.data(), dp->d_name));
+        path_map.emplace(name, ::android::base::StringPrintf("%s/%s", kThermalSensorsRoot.data(),
+                                                             dp->d_name));
     }
 
     return path_map;
 }
 
+std::string getConfigPath(std::string_view config_file) {
+    if (config_file.empty()) {
+        return std::string(kConfigDir) +
+               ::android::base::GetProperty(kConfigProperty.data(), kConfigDefaultFileName.data());
+    }
+    // A tuned config may be pushed outside of the vendor partition
+    if (config_file.front() == '/') {
+        return std::string(config_file);
+    }
+    return std::string(kConfigDir) + std::string(config_file);
+}
+
 }  // namespace
 
 // If the cdev_ceiling is higher than CDEV max_state, cap the cdev_ceiling to max_state.
@@ -108,17 +144,34 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
     : thermal_watcher_(new ThermalWatcher(std::bind(&ThermalHelperImpl::thermalWatcherCallbackFunc,
                                                     this, std::placeholders::_1))),
       cb_(cb) {
-    const std::string config_path =
-            "/vendor/etc/" +
-            ::android::base::GetProperty(kConfigProperty.data(), kConfigDefaultFileName.data());
+    // The sysfs operations are counted where the files are accessed
+    thermal_sensors_.setProfiler(&thermal_profiler_);
+    cooling_devices_.setProfiler(&thermal_profiler_);
+    power_files_.setProfiler(&thermal_profiler_);
+    const std::string config_path = getConfigPath("");
     bool thermal_throttling_disabled =
             ::android::base::GetBoolProperty(kThermalDisabledProperty.data(), false);
     bool ret = true;
     Json::Value config;
+    std::vector<std::string> schema_errors;
+    // The configs are checked against the schema at build time, a schema problem is only logged
+    // here so that it cannot keep the HAL from starting
+    if (!ParseThermalConfig(std::string(kConfigDir) + std::string(kConfigSchemaFileName),
+                            &config_schema_)) {
+        LOG(WARNING) << "Failed to read JSON config schema, the config is not validated";
+        config_schema_ = Json::Value();
+    }
     if (!ParseThermalConfig(config_path, &config)) {
         LOG(ERROR) << "Failed to read JSON config";
         ret = false;
+    } else if (!ValidateThermalConfigSchema(config_schema_, config, &schema_errors)) {
+        for (const auto &schema_error : schema_errors) {
+            LOG(WARNING) << schema_error;
+        }
+        LOG(WARNING) << "JSON config does not match the schema, " << schema_errors.size()
+                     << " errors";
     }
+    live_config_ = config;
 
     if (!ParseCoolingDevice(config, &cooling_device_info_map_)) {
         LOG(ERROR) << "Failed to parse cooling device info config";
@@ -146,6 +199,20 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
         LOG(ERROR) << "Failed to register power rails";
         ret = false;
     }
+    power_files_.registerPowerRailConsumers(sensor_info_map_);
+
+    // Report every unresolved reference of the config at once
+    std::vector<std::string> plan_errors;
+    if (!CompileControlPlan(sensor_info_map_, cooling_device_info_map_,
+                            power_files_.GetPowerRailInfoMap(), &control_plan_, &plan_errors)) {
+        for (const auto &plan_error : plan_errors) {
+            LOG(ERROR) << plan_error;
+        }
+        LOG(ERROR) << "Failed to compile control plan with " << plan_errors.size() << " errors";
+        ret = false;
+    } else {
+        LOG(INFO) << "Control plan compiled, size: " << GetControlPlanSize(control_plan_);
+    }
 
     if (ret) {
         if (!thermal_stats_helper_.initializeStats(config, sensor_info_map_,
@@ -154,7 +221,10 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
         }
     }
 
+    severity_classifier_.registerSensors(sensor_info_map_);
     for (auto &name_status_pair : sensor_info_map_) {
+        size_t severity_index = 0;
+        severity_classifier_.getSensorIndex(name_status_pair.first, &severity_index);
         sensor_status_map_[name_status_pair.first] = {
                 .severity = ThrottlingSeverity::NONE,
                 .prev_hot_severity = ThrottlingSeverity::NONE,
@@ -162,6 +232,10 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
                 .last_update_time = boot_clock::time_point::min(),
                 .thermal_cached = {NAN, boot_clock::time_point::min()},
                 .override_status = {nullptr, false, false},
+                .log_index = kInvalidSampleLogIndex,
+                .linked_log_indices = {},
+                .coefficient_log_indices = {},
+                .severity_index = severity_index,
         };
 
         if (name_status_pair.second.throttling_info != nullptr) {
@@ -221,6 +295,45 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
         }
     }
 
+    // The sensor maps are not changed from here on, their entries are addressed by plan index
+    if (control_plan_.sensor_names.size() == sensor_info_map_.size()) {
+        for (const auto &sensor_name : control_plan_.sensor_names) {
+            plan_sensor_info_.push_back(&sensor_info_map_.at(sensor_name));
+            plan_sensor_status_.push_back(&sensor_status_map_.at(sensor_name));
+        }
+        resume_deferred_until_.assign(control_plan_.sensor_names.size(),
+                                      boot_clock::time_point::min());
+    }
+
+    initializeSampleLog();
+    sample_log_.setMinLogInterval(std::chrono::milliseconds(::android::base::GetIntProperty(
+            kSampleLogIntervalProperty.data(), kDefaultSampleLogIntervalMs.count())));
+
+    thermal_forecaster_.setHorizon(std::chrono::milliseconds(::android::base::GetIntProperty(
+            kForecastHorizonProperty.data(), kDefaultForecastHorizonMs.count())));
+
+    if (::android::base::GetBoolProperty(kThermalProfilingProperty.data(), false)) {
+        thermal_profiler_.setEnabled(true);
+    }
+
+    // -1 picks a quarter of the cores on large devices, 0 keeps the reads serial
+    const auto cores = std::thread::hardware_concurrency();
+    int eval_workers = ::android::base::GetIntProperty(kEvalWorkersProperty.data(), -1);
+    if (eval_workers < 0) {
+        eval_workers = (cores >= kMinCoresForEvalWorkers) ? cores / 4 : 0;
+    }
+    thermal_executor_.start(eval_workers);
+
+    // The sensor and energy files are read in one io_uring batch per tick, else with pread
+    if (::android::base::GetBoolProperty(kIoUringProperty.data(), false)) {
+        if (!thermal_sensors_.enableBatchRead()) {
+            LOG(WARNING) << "Failed to enable the batch read of the sensors";
+        }
+        if (!power_files_.enableBatchRead()) {
+            LOG(WARNING) << "Failed to enable the batch read of the power rails";
+        }
+    }
+
     if (!power_hal_service_.connect()) {
         LOG(ERROR) << "Fail to connect to Power Hal";
     } else {
@@ -233,6 +346,8 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
             is_initialized_ = ret;
             return;
         } else {
+            plan_sensor_info_.clear();
+            plan_sensor_status_.clear();
             sensor_info_map_.clear();
             cooling_device_info_map_.clear();
             return;
@@ -259,6 +374,14 @@ ThermalHelperImpl::ThermalHelperImpl(const NotificationCallback &cb)
     if (!is_initialized_) {
         LOG(FATAL) << "ThermalHAL could not start watching thread properly.";
     }
+    config_reload_thread_ = std::thread([this] { configReloadRequestLoop(); });
+}
+
+ThermalHelperImpl::~ThermalHelperImpl() {
+    config_reload_aborted_ = true;
+    if (config_reload_thread_.joinable()) {
+        config_reload_thread_.join();
+    }
 }
 
 bool getThermalZoneTypeById(int tz_id, std::string *type) {
@@ -267,13 +390,12 @@ bool getThermalZoneTypeById(int tz_id, std::string *type) {
             ::android::base::StringPrintf("%s/%s%d/%s", kThermalSensorsRoot.data(),
                                           kSensorPrefix.data(), tz_id, kThermalNameFile.data());
     LOG(INFO) << "TZ Path: " << path;
-    if (!::android::base::ReadFileToString(path, &tz_type)) {
+    if (!ReadStaticThermalFile(path, &tz_type)) {
         LOG(ERROR) << "Failed to read sensor: " << tz_type;
         return false;
     }
 
-    // Strip the newline.
-    *type = ::android::base::Trim(tz_type);
+    *type = tz_type;
     LOG(INFO) << "TZ type: " << *type;
     return true;
 }
@@ -383,8 +505,254 @@ bool ThermalHelperImpl::emulClear(std::string_view target_sensor) {
     return true;
 }
 
+bool ThermalHelperImpl::startScenario(std::string_view source, const bool loop,
+                                      const float speed) {
+    if (!thermal_scenario_.start(source, loop, speed, sensor_info_map_)) {
+        return false;
+    }
+    thermal_watcher_->wake();
+    return true;
+}
+
+void ThermalHelperImpl::stopScenario() {
+    // Drop the temperatures left by the scenario, the other emulations are kept
+    for (const auto &sensor_name : thermal_scenario_.stop()) {
+        emulClear(sensor_name);
+    }
+}
+
+bool ThermalHelperImpl::reloadConfig(std::string_view config_file, std::string *result) {
+    std::lock_guard<std::mutex> _lock(config_reload_mutex_);
+    const std::string config_path = getConfigPath(config_file);
+    Json::Value config;
+    std::vector<std::string> errors;
+    auto pending = std::make_unique<PendingConfigReload>();
+    if (!ParseThermalConfig(config_path, &config)) {
+        errors.emplace_back("Failed to read JSON config");
+    } else if (ValidateThermalConfigSchema(config_schema_, config, &errors)) {
+        PrepareConfigReload(live_config_, config, sensor_info_map_, cooling_device_info_map_,
+                            power_files_.GetPowerRailInfoMap(), &pending->reload, &errors);
+    }
+    if (!errors.empty()) {
+        *result = "Rejected reload of " + config_path + ", restart to apply:\n  " +
+                  ::android::base::Join(errors, "\n  ");
+        LOG(ERROR) << *result;
+        return false;
+    }
+
+    auto applied = pending->result.get_future();
+    {
+        std::lock_guard<std::mutex> _pending_lock(pending_config_reload_mutex_);
+        pending_config_reload_ = std::move(pending);
+    }
+    thermal_watcher_->wake();
+    if (applied.wait_for(kConfigReloadTimeoutMs) != std::future_status::ready) {
+        std::lock_guard<std::mutex> _pending_lock(pending_config_reload_mutex_);
+        // Withdraw it unless the watcher is already applying it
+        if (pending_config_reload_ != nullptr) {
+            pending_config_reload_.reset();
+            *result = "Timed out reloading " + config_path;
+            LOG(ERROR) << *result;
+            return false;
+        }
+    }
+    *result = "Reloaded " + config_path + ": " + applied.get();
+    live_config_ = std::move(config);
+    LOG(INFO) << *result;
+    return true;
+}
+
+void ThermalHelperImpl::configReloadRequestLoop() {
+    // Only the initial value is read before the property is watched, a request made in between
+    // is caught by the comparison below
+    std::string last_request = ::android::base::GetProperty(kConfigReloadProperty.data(), "");
+    const prop_info *request_prop = nullptr;
+    uint32_t serial = 0;
+    // The waits time out to notice the abort on destruction
+    while (!config_reload_aborted_) {
+        if (request_prop == nullptr) {
+            if (!::android::base::WaitForPropertyCreation(kConfigReloadProperty.data(),
+                                                          kConfigReloadAbortCheckInterval)) {
+                continue;
+            }
+            request_prop = __system_property_find(kConfigReloadProperty.data());
+            if (request_prop == nullptr) {
+                continue;
+            }
+            serial = __system_property_serial(request_prop);
+        } else {
+            const auto timeout_s = std::chrono::duration_cast<std::chrono::seconds>(
+                    kConfigReloadAbortCheckInterval);
+            const timespec timeout = {.tv_sec = static_cast<time_t>(timeout_s.count()),
+                                      .tv_nsec = 0};
+            if (!__system_property_wait(request_prop, serial, &serial, &timeout)) {
+                continue;
+            }
+        }
+        auto request = ::android::base::GetProperty(kConfigReloadProperty.data(), "");
+        if (request == last_request) {
+            continue;
+        }
+        last_request = std::move(request);
+        // Blocks until the watcher applied the reload, the requests made meanwhile are coalesced
+        std::string result;
+        reloadConfig("", &result);
+    }
+}
+
+void ThermalHelperImpl::applyConfigReload() {
+    std::unique_ptr<PendingConfigReload> pending;
+    {
+        std::lock_guard<std::mutex> _lock(pending_config_reload_mutex_);
+        pending = std::move(pending_config_reload_);
+    }
+    if (pending == nullptr) {
+        return;
+    }
+
+    ATRACE_CALL();
+    // The throttling info, state2power and power rail tunables are updated in place while the
+    // dump reads them
+    std::unique_lock<std::shared_mutex> config_lock(config_mutex_);
+    const auto &reload = pending->reload;
+    for (const auto &[cdev_name, cdev_info] : reload.cooling_device_info_map) {
+        cooling_device_info_map_.at(cdev_name).state2power = cdev_info.state2power;
+    }
+    power_files_.applyPowerRailTunables(reload.power_rail_info_map);
+
+    // The requests of a sensor also depend on the power of its cdevs and rails
+    std::set<std::string> sensors_to_update;
+    for (const auto &[sensor_name, sensor_info] : sensor_info_map_) {
+        if (reload.sensor_info_map.count(sensor_name)) {
+            sensors_to_update.insert(sensor_name);
+            continue;
+        }
+        if (sensor_info.throttling_info == nullptr) {
+            continue;
+        }
+        for (const auto &[cdev_name, binded_cdev_info] :
+             sensor_info.throttling_info->binded_cdev_info_map) {
+            if (reload.cooling_device_info_map.count(cdev_name) ||
+                reload.power_rail_info_map.count(binded_cdev_info.power_rail)) {
+                sensors_to_update.insert(sensor_name);
+            }
+        }
+        for (const auto &[power_rail, excluded_power_info] :
+             sensor_info.throttling_info->excluded_power_info_map) {
+            if (reload.power_rail_info_map.count(power_rail)) {
+                sensors_to_update.insert(sensor_name);
+            }
+        }
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> _lock(sensor_status_map_mutex_);
+        for (const auto &[sensor_name, reloaded_sensor_info] : reload.sensor_info_map) {
+            auto &sensor_info = sensor_info_map_.at(sensor_name);
+            ApplySensorTunables(reloaded_sensor_info, &sensor_info);
+            // A watched zone without trip points keeps the polling set at init
+            if (sensor_info.is_watch && sensor_info.virtual_sensor_info == nullptr &&
+                !trip_point_map_.count(sensor_name)) {
+                setMinTimeout(&sensor_info);
+            }
+            if (sensor_info.throttling_info != nullptr) {
+                maxCoolingRequestCheck(&sensor_info.throttling_info->binded_cdev_info_map);
+                for (auto &[profile, binded_cdev_info_map] :
+                     sensor_info.throttling_info->profile_map) {
+                    maxCoolingRequestCheck(&binded_cdev_info_map);
+                }
+            }
+        }
+        // Re-evaluated in this tick, their severity and PID integrator are kept
+        for (const auto &[sensor_name, reloaded_sensor_info] : reload.sensor_info_map) {
+            // The thresholds may have moved, the trip points are programmed again on update
+            const auto trip_it = trip_point_map_.find(sensor_name);
+            if (trip_it != trip_point_map_.end()) {
+                trip_it->second.is_armed = false;
+            }
+        }
+        for (const auto &sensor_name : sensors_to_update) {
+            sensor_status_map_.at(sensor_name).last_update_time = boot_clock::time_point::min();
+            thermal_throttling_.onConfigReload(sensor_name);
+        }
+        severity_classifier_.registerSensors(sensor_info_map_);
+    }
+    // The release logic decides whether the throttling power rails are always sampled
+    power_files_.registerPowerRailConsumers(sensor_info_map_);
+    pending->result.set_value(StringPrintf(
+            "%zu sensors, %zu cdevs and %zu power rails changed, %zu sensors updated",
+            reload.sensor_info_map.size(), reload.cooling_device_info_map.size(),
+            reload.power_rail_info_map.size(), sensors_to_update.size()));
+}
+
+std::chrono::milliseconds ThermalHelperImpl::applyScenarioEvents(boot_clock::time_point now) {
+    std::vector<ScenarioEvent> due_events;
+    const auto next_event_ms = thermal_scenario_.poll(now, &due_events);
+    if (due_events.empty()) {
+        return next_event_ms;
+    }
+
+    std::lock_guard<std::shared_mutex> _lock(sensor_status_map_mutex_);
+    for (const auto &event : due_events) {
+        LOG(VERBOSE) << "Apply scenario event of " << event.sensor << " at "
+                     << event.offset.count() << "ms";
+        if (event.action == ScenarioAction::CLEAR) {
+            for (auto &[sensor_name, sensor_status] : sensor_status_map_) {
+                if (event.sensor != "all" && event.sensor != sensor_name) {
+                    continue;
+                }
+                sensor_status.override_status = {
+                        .emul_temp = nullptr, .max_throttling = false, .pending_update = true};
+                checkUpdateSensorForEmul(sensor_name, false);
+            }
+            continue;
+        }
+        if (!sensor_status_map_.count(event.sensor)) {
+            continue;
+        }
+        const auto &sensor_info = sensor_info_map_.at(event.sensor);
+        auto &sensor_status = sensor_status_map_.at(event.sensor);
+        if (event.action == ScenarioAction::TEMP) {
+            sensor_status.override_status.emul_temp.reset(new EmulTemp{event.value, -1});
+        } else {
+            const int severity = static_cast<int>(event.value);
+            sensor_status.override_status.emul_temp.reset(new EmulTemp{
+                    sensor_info.hot_thresholds[severity] / sensor_info.multiplier, severity});
+        }
+        sensor_status.override_status.max_throttling = event.max_throttling;
+        sensor_status.override_status.pending_update = true;
+        checkUpdateSensorForEmul(event.sensor, event.max_throttling);
+    }
+    return next_event_ms;
+}
+
+std::unordered_map<std::string, SensorStatusSnapshot> ThermalHelperImpl::GetSensorStatusSnapshot()
+        const {
+    std::unordered_map<std::string, SensorStatusSnapshot> snapshot;
+    std::shared_lock<std::shared_mutex> _lock(sensor_status_map_mutex_);
+    snapshot.reserve(sensor_status_map_.size());
+    for (const auto &[sensor_name, sensor_status] : sensor_status_map_) {
+        auto &sensor_snapshot = snapshot[sensor_name];
+        sensor_snapshot.severity = sensor_status.severity;
+        sensor_snapshot.thermal_cached = sensor_status.thermal_cached;
+        if (sensor_status.override_status.emul_temp != nullptr) {
+            sensor_snapshot.emul_temp = *sensor_status.override_status.emul_temp;
+        }
+        sensor_snapshot.max_throttling = sensor_status.override_status.max_throttling;
+    }
+    return snapshot;
+}
+
 bool ThermalHelperImpl::readCoolingDevice(std::string_view cooling_device,
                                           CoolingDevice *out) const {
+    const auto freq_cdev_it = freq_cdev_map_.find(cooling_device.data());
+    if (freq_cdev_it != freq_cdev_map_.end()) {
+        out->type = cooling_device_info_map_.at(cooling_device.data()).type;
+        out->name = cooling_device.data();
+        out->value = freq_cdev_it->second->getState();
+        return true;
+    }
+
     // Read the file.  If the file can't be read temp will be empty string.
     std::string data;
 
@@ -407,28 +775,12 @@ bool ThermalHelperImpl::readTemperature(
         std::string_view sensor_name, Temperature *out,
         std::pair<ThrottlingSeverity, ThrottlingSeverity> *throttling_status,
         const bool force_no_cache) {
-    // Return fail if the thermal sensor cannot be read.
-    float temp;
-    std::map<std::string, float> sensor_log_map;
-    auto &sensor_status = sensor_status_map_.at(sensor_name.data());
-
-    if (!readThermalSensor(sensor_name, &temp, force_no_cache, &sensor_log_map)) {
-        LOG(ERROR) << "Failed to read thermal sensor " << sensor_name.data();
-        thermal_stats_helper_.reportThermalAbnormality(
-                ThermalSensorAbnormalityDetected::TEMP_READ_FAIL, sensor_name, std::nullopt);
-        return false;
-    }
-
-    if (std::isnan(temp)) {
-        LOG(INFO) << "Sensor " << sensor_name.data() << " temperature is nan.";
+    if (!readSensorTemperature(sensor_name, out, force_no_cache)) {
         return false;
     }
 
     const auto &sensor_info = sensor_info_map_.at(sensor_name.data());
-    out->type = sensor_info.type;
-    out->name = sensor_name.data();
-    out->value = temp * sensor_info.multiplier;
-
+    const auto &sensor_status = sensor_status_map_.at(sensor_name.data());
     std::pair<ThrottlingSeverity, ThrottlingSeverity> status =
             std::make_pair(ThrottlingSeverity::NONE, ThrottlingSeverity::NONE);
     // Only update status if the thermal sensor is being monitored
@@ -440,15 +792,44 @@ bool ThermalHelperImpl::readTemperature(
             prev_hot_severity = sensor_status.prev_hot_severity;
             prev_cold_severity = sensor_status.prev_cold_severity;
         }
-        status = getSeverityFromThresholds(sensor_info.hot_thresholds, sensor_info.cold_thresholds,
-                                           sensor_info.hot_hysteresis, sensor_info.cold_hysteresis,
-                                           prev_hot_severity, prev_cold_severity, out->value);
+        status = severity_classifier_.classify(sensor_status.severity_index, out->value,
+                                               prev_hot_severity, prev_cold_severity);
     }
 
     if (throttling_status) {
         *throttling_status = status;
     }
+    applyTemperatureSeverity(sensor_name, status, out);
+    return true;
+}
+
+bool ThermalHelperImpl::readSensorTemperature(std::string_view sensor_name, Temperature *out,
+                                              const bool force_no_cache) {
+    // Return fail if the thermal sensor cannot be read.
+    float temp;
+    if (!readThermalSensor(sensor_name, &temp, force_no_cache)) {
+        LOG(ERROR) << "Failed to read thermal sensor " << sensor_name.data();
+        thermal_stats_helper_.reportThermalAbnormality(
+                ThermalSensorAbnormalityDetected::TEMP_READ_FAIL, sensor_name, std::nullopt);
+        return false;
+    }
+
+    if (std::isnan(temp)) {
+        LOG(INFO) << "Sensor " << sensor_name.data() << " temperature is nan.";
+        return false;
+    }
 
+    const auto &sensor_info = sensor_info_map_.at(sensor_name.data());
+    out->type = sensor_info.type;
+    out->name = sensor_name.data();
+    out->value = temp * sensor_info.multiplier;
+    return true;
+}
+
+void ThermalHelperImpl::applyTemperatureSeverity(std::string_view sensor_name,
+                                                 const SeverityPair &status, Temperature *out) {
+    const auto &sensor_info = sensor_info_map_.at(sensor_name.data());
+    const auto &sensor_status = sensor_status_map_.at(sensor_name.data());
     if (sensor_status.override_status.emul_temp != nullptr &&
         sensor_status.override_status.emul_temp->severity >= 0) {
         std::shared_lock<std::shared_mutex> _lock(sensor_status_map_mutex_);
@@ -461,16 +842,14 @@ bool ThermalHelperImpl::readTemperature(
                         : status.second;
     }
     if (sensor_info.is_watch) {
-        std::ostringstream sensor_log;
-        for (const auto &sensor_log_pair : sensor_log_map) {
-            sensor_log << sensor_log_pair.first << ":" << sensor_log_pair.second << " ";
-        }
         // Update sensor temperature time in state
         thermal_stats_helper_.updateSensorTempStatsBySeverity(sensor_name, out->throttlingStatus);
-        LOG(INFO) << sensor_name.data() << ":" << out->value << " raw data: " << sensor_log.str();
+        std::string sample_log_line;
+        if (sample_log_.addSample(sensor_status.log_index, out->value, out->throttlingStatus,
+                                  &sample_log_line)) {
+            LOG(INFO) << sample_log_line;
+        }
     }
-
-    return true;
 }
 
 bool ThermalHelperImpl::readTemperatureThreshold(std::string_view sensor_name,
@@ -495,13 +874,34 @@ bool ThermalHelperImpl::readTemperatureThreshold(std::string_view sensor_name,
     return true;
 }
 
+bool ThermalHelperImpl::writeCoolingDevice(std::string_view cdev, int state) {
+    const auto freq_cdev_it = freq_cdev_map_.find(cdev.data());
+    const bool ret = freq_cdev_it != freq_cdev_map_.end()
+                             ? freq_cdev_it->second->setState(state)
+                             : cooling_devices_.writeCdevFile(cdev, std::to_string(state));
+    if (ret) {
+        std::lock_guard<std::mutex> _lock(cdev_state_map_mutex_);
+        cdev_state_map_[cdev.data()] = state;
+    }
+    return ret;
+}
+
+void ThermalHelperImpl::dumpFreqCoolingDevices(std::ostringstream *dump_buf) const {
+    *dump_buf << "getFreqCoolingDevices:" << std::endl;
+    for (const auto &[cdev_name, freq_cdev] : freq_cdev_map_) {
+        freq_cdev->dump(dump_buf);
+    }
+}
+
 void ThermalHelperImpl::updateCoolingDevices(const std::vector<std::string> &updated_cdev) {
     int max_state;
 
     for (const auto &target_cdev : updated_cdev) {
         if (thermal_throttling_.getCdevMaxRequest(target_cdev, &max_state)) {
-            if (cooling_devices_.writeCdevFile(target_cdev, std::to_string(max_state))) {
+            if (writeCoolingDevice(target_cdev, max_state)) {
                 ATRACE_INT(target_cdev.c_str(), max_state);
+                thermal_stats_helper_.updateCdevStateDwell(target_cdev, max_state);
+                thermal_scenario_.recordCdevRequest(target_cdev, max_state, boot_clock::now());
                 LOG(INFO) << "Successfully update cdev " << target_cdev << " sysfs to "
                           << max_state;
             } else {
@@ -511,47 +911,6 @@ void ThermalHelperImpl::updateCoolingDevices(const std::vector<std::string> &upd
     }
 }
 
-std::pair<ThrottlingSeverity, ThrottlingSeverity> ThermalHelperImpl::getSeverityFromThresholds(
-        const ThrottlingArray &hot_thresholds, const ThrottlingArray &cold_thresholds,
-        const ThrottlingArray &hot_hysteresis, const ThrottlingArray &cold_hysteresis,
-        ThrottlingSeverity prev_hot_severity, ThrottlingSeverity prev_cold_severity,
-        float value) const {
-    ThrottlingSeverity ret_hot = ThrottlingSeverity::NONE;
-    ThrottlingSeverity ret_hot_hysteresis = ThrottlingSeverity::NONE;
-    ThrottlingSeverity ret_cold = ThrottlingSeverity::NONE;
-    ThrottlingSeverity ret_cold_hysteresis = ThrottlingSeverity::NONE;
-
-    // Here we want to control the iteration from high to low, and ::ndk::enum_range doesn't support
-    // a reverse iterator yet.
-    for (size_t i = static_cast<size_t>(ThrottlingSeverity::SHUTDOWN);
-         i > static_cast<size_t>(ThrottlingSeverity::NONE); --i) {
-        if (!std::isnan(hot_thresholds[i]) && hot_thresholds[i] <= value &&
-            ret_hot == ThrottlingSeverity::NONE) {
-            ret_hot = static_cast<ThrottlingSeverity>(i);
-        }
-        if (!std::isnan(hot_thresholds[i]) && (hot_thresholds[i] - hot_hysteresis[i]) < value &&
-            ret_hot_hysteresis == ThrottlingSeverity::NONE) {
-            ret_hot_hysteresis = static_cast<ThrottlingSeverity>(i);
-        }
-        if (!std::isnan(cold_thresholds[i]) && cold_thresholds[i] >= value &&
-            ret_cold == ThrottlingSeverity::NONE) {
-            ret_cold = static_cast<ThrottlingSeverity>(i);
-        }
-        if (!std::isnan(cold_thresholds[i]) && (cold_thresholds[i] + cold_hysteresis[i]) > value &&
-            ret_cold_hysteresis == ThrottlingSeverity::NONE) {
-            ret_cold_hysteresis = static_cast<ThrottlingSeverity>(i);
-        }
-    }
-    if (static_cast<size_t>(ret_hot) < static_cast<size_t>(prev_hot_severity)) {
-        ret_hot = ret_hot_hysteresis;
-    }
-    if (static_cast<size_t>(ret_cold) < static_cast<size_t>(prev_cold_severity)) {
-        ret_cold = ret_cold_hysteresis;
-    }
-
-    return std::make_pair(ret_hot, ret_cold);
-}
-
 bool ThermalHelperImpl::isSubSensorValid(std::string_view sensor_data,
                                          const SensorFusionType sensor_fusion_type) {
     switch (sensor_fusion_type) {
@@ -576,7 +935,7 @@ bool ThermalHelperImpl::isSubSensorValid(std::string_view sensor_data,
 void ThermalHelperImpl::clearAllThrottling(void) {
     // Clear the CDEV request
     for (const auto &cdev_info_pair : cooling_device_info_map_) {
-        cooling_devices_.writeCdevFile(cdev_info_pair.first, "0");
+        writeCoolingDevice(cdev_info_pair.first, 0);
     }
 
     for (auto &sensor_info_pair : sensor_info_map_) {
@@ -594,11 +953,9 @@ void ThermalHelperImpl::clearAllThrottling(void) {
         if (sensor_info_pair.second.send_cb && cb_) {
             cb_(temp);
         }
-        // Disable thermal power hints
+        // Disable thermal power hints, through the sender thread to keep its sync state
         if (sensor_info_pair.second.send_powerhint) {
-            for (const auto &severity : ::ndk::enum_range<ThrottlingSeverity>()) {
-                power_hal_service_.setMode(sensor_info_pair.first, severity, false);
-            }
+            power_hal_service_.sendPowerExtHint(temp);
         }
     }
 }
@@ -635,6 +992,27 @@ bool ThermalHelperImpl::initializeCoolingDevices(
         const std::unordered_map<std::string, std::string> &path_map) {
     for (auto &cooling_device_info_pair : cooling_device_info_map_) {
         std::string cooling_device_name = cooling_device_info_pair.first;
+        // A frequency domain is capped directly, without a kernel cooling device
+        if (!cooling_device_info_pair.second.freq_domain.empty()) {
+            auto freq_cdev = std::make_unique<FreqCoolingDevice>();
+            if (!freq_cdev->init(cooling_device_name, cooling_device_info_pair.second.freq_domain,
+                                 &thermal_profiler_)) {
+                LOG(ERROR) << "Could not initialize freq cooling device " << cooling_device_name;
+                return false;
+            }
+            cooling_device_info_pair.second.max_state = freq_cdev->getMaxState();
+            if (cooling_device_info_pair.second.state2power.size() > 0 &&
+                static_cast<int>(cooling_device_info_pair.second.state2power.size()) !=
+                        (cooling_device_info_pair.second.max_state + 1)) {
+                LOG(ERROR) << "Invalid state2power number: "
+                           << cooling_device_info_pair.second.state2power.size()
+                           << ", number should be " << cooling_device_info_pair.second.max_state + 1
+                           << " (available frequency number)";
+                return false;
+            }
+            freq_cdev_map_[cooling_device_name] = std::move(freq_cdev);
+            continue;
+        }
         if (!path_map.count(cooling_device_name)) {
             LOG(ERROR) << "Could not find " << cooling_device_name << " in sysfs";
             return false;
@@ -648,7 +1026,22 @@ bool ThermalHelperImpl::initializeCoolingDevices(
             read_path = ::android::base::StringPrintf("%s/%s", path.data(),
                                                       kCoolingDeviceCurStateSuffix.data());
         }
-        if (!cooling_devices_.addThermalFile(cooling_device_name, read_path)) {
+        std::string write_path;
+        if (!cooling_device_info_pair.second.write_path.empty()) {
+            write_path = cooling_device_info_pair.second.write_path.data();
+        } else {
+            write_path = ::android::base::StringPrintf("%s/%s", path.data(),
+                                                       kCoolingDeviceCurStateSuffix.data());
+        }
+        // A state only requested by the HAL is kept from its writes instead of read back, the
+        // kernel governors may also write a cur_state so it is opted in by the config
+        const bool is_owned = cooling_device_info_pair.second.hal_owned;
+        if (is_owned && read_path != write_path) {
+            LOG(WARNING) << "Cooling device " << cooling_device_name
+                         << " is HalOwned but reads another node than it writes, read it back";
+        }
+        if (!cooling_devices_.addThermalFile(cooling_device_name, read_path,
+                                             is_owned && read_path == write_path)) {
             LOG(ERROR) << "Could not add " << cooling_device_name
                        << " read path to cooling device map";
             return false;
@@ -657,7 +1050,7 @@ bool ThermalHelperImpl::initializeCoolingDevices(
         std::string state2power_path = ::android::base::StringPrintf(
                 "%s/%s", path.data(), kCoolingDeviceState2powerSuffix.data());
         std::string state2power_str;
-        if (::android::base::ReadFileToString(state2power_path, &state2power_str)) {
+        if (ReadStaticThermalFile(state2power_path, &state2power_str)) {
             LOG(INFO) << "Cooling device " << cooling_device_info_pair.first
                       << " use state2power read from sysfs";
             cooling_device_info_pair.second.state2power.clear();
@@ -678,12 +1071,12 @@ bool ThermalHelperImpl::initializeCoolingDevices(
         std::string max_state;
         std::string max_state_path = ::android::base::StringPrintf(
                 "%s/%s", path.data(), kCoolingDeviceMaxStateSuffix.data());
-        if (!::android::base::ReadFileToString(max_state_path, &max_state)) {
+        if (!ReadStaticThermalFile(max_state_path, &max_state)) {
             LOG(ERROR) << cooling_device_info_pair.first
                        << " could not open max state file:" << max_state_path;
             cooling_device_info_pair.second.max_state = std::numeric_limits<int>::max();
         } else {
-            cooling_device_info_pair.second.max_state = std::stoi(::android::base::Trim(max_state));
+            cooling_device_info_pair.second.max_state = std::stoi(max_state);
             LOG(INFO) << "Cooling device " << cooling_device_info_pair.first
                       << " max state: " << cooling_device_info_pair.second.max_state
                       << " state2power number: "
@@ -702,14 +1095,6 @@ bool ThermalHelperImpl::initializeCoolingDevices(
         // Add cooling device path for thermalHAL to request state
         cooling_device_name =
                 ::android::base::StringPrintf("%s_%s", cooling_device_name.c_str(), "w");
-        std::string write_path;
-        if (!cooling_device_info_pair.second.write_path.empty()) {
-            write_path = cooling_device_info_pair.second.write_path.data();
-        } else {
-            write_path = ::android::base::StringPrintf("%s/%s", path.data(),
-                                                       kCoolingDeviceCurStateSuffix.data());
-        }
-
         if (!cooling_devices_.addThermalFile(cooling_device_name, write_path)) {
             LOG(ERROR) << "Could not add " << cooling_device_name
                        << " write path to cooling device map";
@@ -743,10 +1128,9 @@ void ThermalHelperImpl::initializeTrip(const std::unordered_map<std::string, std
             trip_update = true;
         } else {
             // Check if thermal zone support uevent notify
-            if (!::android::base::ReadFileToString(path, &tz_policy)) {
+            if (!ReadStaticThermalFile(path, &tz_policy)) {
                 LOG(ERROR) << sensor_name << " could not open tz policy file:" << path;
             } else {
-                tz_policy = ::android::base::Trim(tz_policy);
                 if (tz_policy != kUserSpaceSuffix) {
                     LOG(ERROR) << sensor_name << " does not support uevent notify";
                 } else {
@@ -755,38 +1139,18 @@ void ThermalHelperImpl::initializeTrip(const std::unordered_map<std::string, std
             }
         }
         if (trip_update) {
-            // Update thermal zone trip point
-            for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
-                if (!std::isnan(sensor_info.second.hot_thresholds[i]) &&
-                    !std::isnan(sensor_info.second.hot_hysteresis[i])) {
-                    // Update trip_point_0_temp threshold
-                    std::string threshold = std::to_string(static_cast<int>(
-                            sensor_info.second.hot_thresholds[i] / sensor_info.second.multiplier));
-                    path = ::android::base::StringPrintf("%s/%s", (tz_path.data()),
-                                                         kSensorTripPointTempZeroFile.data());
-                    if (!::android::base::WriteStringToFile(threshold, path)) {
-                        LOG(ERROR) << "fail to update " << sensor_name << " trip point: " << path
-                                   << " to " << threshold;
-                        trip_update = false;
-                        break;
-                    }
-                    // Update trip_point_0_hyst threshold
-                    threshold = std::to_string(static_cast<int>(
-                            sensor_info.second.hot_hysteresis[i] / sensor_info.second.multiplier));
-                    path = ::android::base::StringPrintf("%s/%s", (tz_path.data()),
-                                                         kSensorTripPointHystZeroFile.data());
-                    if (!::android::base::WriteStringToFile(threshold, path)) {
-                        LOG(ERROR) << "fail to update " << sensor_name << "trip hyst" << threshold
-                                   << path;
-                        trip_update = false;
-                        break;
-                    }
-                    break;
-                } else if (i == kThrottlingSeverityCount - 1) {
-                    LOG(ERROR) << sensor_name << ":all thresholds are NAN";
-                    trip_update = false;
-                    break;
-                }
+            // The trip points follow the severity, starting below the first hot threshold
+            path = ::android::base::StringPrintf("%s/%s", (tz_path.data()),
+                                                 kSensorTripPointTempOneFile.data());
+            trip_point_map_[sensor_info.first] = {
+                    .tz_path = std::string(tz_path),
+                    .has_low_trip = access(path.c_str(), W_OK) == 0,
+                    .armed_severity = ThrottlingSeverity::NONE,
+                    .is_armed = false,
+            };
+            if (!armTripPoints(sensor_name, ThrottlingSeverity::NONE)) {
+                trip_point_map_.erase(sensor_info.first);
+                trip_update = false;
             }
             monitored_sensors->insert(sensor_info.first);
         }
@@ -799,6 +1163,93 @@ void ThermalHelperImpl::initializeTrip(const std::unordered_map<std::string, std
     }
 }
 
+bool ThermalHelperImpl::armTripPoints(std::string_view sensor_name, ThrottlingSeverity severity) {
+    auto &trip_status = trip_point_map_.at(sensor_name.data());
+    const auto &sensor_info = sensor_info_map_.at(sensor_name.data());
+    const auto has_threshold = [&sensor_info](size_t i) {
+        return !std::isnan(sensor_info.hot_thresholds[i]) &&
+               !std::isnan(sensor_info.hot_hysteresis[i]);
+    };
+
+    const size_t current = static_cast<size_t>(severity);
+    size_t upper = kThrottlingSeverityCount;
+    for (size_t i = current + 1; i < kThrottlingSeverityCount; ++i) {
+        if (has_threshold(i)) {
+            upper = i;
+            break;
+        }
+    }
+    size_t lower = (current > 0 && has_threshold(current)) ? current : upper;
+    if (upper == kThrottlingSeverityCount) {
+        upper = lower;
+    }
+    if (upper == kThrottlingSeverityCount) {
+        LOG(ERROR) << sensor_name << ":all thresholds are NAN";
+        trip_status.is_armed = false;
+        return false;
+    }
+
+    const auto write_trip = [&](size_t i, std::string_view temp_file, std::string_view hyst_file) {
+        // The kernel notifies the trip on the way up at the threshold, and on the way down
+        // once below the threshold minus its hysteresis
+        std::string threshold = std::to_string(
+                static_cast<int>(sensor_info.hot_thresholds[i] / sensor_info.multiplier));
+        std::string path = ::android::base::StringPrintf("%s/%s", trip_status.tz_path.c_str(),
+                                                         temp_file.data());
+        thermal_profiler_.countSysfsOp();
+        if (!::android::base::WriteStringToFile(threshold, path)) {
+            LOG(ERROR) << "fail to update " << sensor_name << " trip point: " << path << " to "
+                       << threshold;
+            return false;
+        }
+        threshold = std::to_string(
+                static_cast<int>(sensor_info.hot_hysteresis[i] / sensor_info.multiplier));
+        path = ::android::base::StringPrintf("%s/%s", trip_status.tz_path.c_str(),
+                                             hyst_file.data());
+        thermal_profiler_.countSysfsOp();
+        if (!::android::base::WriteStringToFile(threshold, path)) {
+            LOG(ERROR) << "fail to update " << sensor_name << " trip hyst: " << path << " to "
+                       << threshold;
+            return false;
+        }
+        return true;
+    };
+
+    ATRACE_NAME(StringPrintf("ThermalHelper::armTripPoints - %s", sensor_name.data()).c_str());
+    trip_status.is_armed =
+            write_trip(upper, kSensorTripPointTempZeroFile, kSensorTripPointHystZeroFile) &&
+            (!trip_status.has_low_trip ||
+             write_trip(lower, kSensorTripPointTempOneFile, kSensorTripPointHystOneFile));
+    trip_status.armed_severity = severity;
+    LOG(VERBOSE) << sensor_name << ": trip points armed at severity " << toString(severity)
+                 << ", upper " << sensor_info.hot_thresholds[upper] << ", lower "
+                 << sensor_info.hot_thresholds[lower] << ", result " << trip_status.is_armed;
+    return trip_status.is_armed;
+}
+
+std::chrono::milliseconds ThermalHelperImpl::getPollingDelay(std::string_view sensor_name,
+                                                             const SensorInfo &sensor_info,
+                                                             ThrottlingSeverity severity) const {
+    const auto trip_it = trip_point_map_.find(sensor_name.data());
+    if (trip_it != trip_point_map_.end() && !trip_it->second.is_armed) {
+        return std::min(kMinPollIntervalMs, (severity != ThrottlingSeverity::NONE)
+                                                    ? sensor_info.passive_delay
+                                                    : sensor_info.polling_delay);
+    }
+    if (severity != ThrottlingSeverity::NONE) {
+        return sensor_info.passive_delay;
+    }
+    // In band the armed trip point notifies the first hot threshold, the default uevent
+    // timeout is not needed unless the cold thresholds are polled. A polling delay set in the
+    // config is kept.
+    if (trip_it != trip_point_map_.end() && sensor_info.polling_delay == kUeventPollTimeoutMs &&
+        std::all_of(sensor_info.cold_thresholds.begin(), sensor_info.cold_thresholds.end(),
+                    [](float threshold) { return std::isnan(threshold); })) {
+        return std::chrono::milliseconds::max();
+    }
+    return sensor_info.polling_delay;
+}
+
 bool ThermalHelperImpl::fillCurrentTemperatures(bool filterType, bool filterCallback,
                                                 TemperatureType type,
                                                 std::vector<Temperature> *temperatures) {
@@ -868,13 +1319,28 @@ bool ThermalHelperImpl::fillCurrentCoolingDevices(
     return ret.size() > 0;
 }
 
+std::vector<CoolingDevice> ThermalHelperImpl::GetCoolingDeviceSnapshot() const {
+    std::vector<CoolingDevice> cooling_devices;
+    cooling_devices.reserve(cooling_device_info_map_.size());
+    std::lock_guard<std::mutex> _lock(cdev_state_map_mutex_);
+    for (const auto &[cdev_name, cdev_info] : cooling_device_info_map_) {
+        // A cooling device the HAL never requested is not throttled by it
+        const auto state_it = cdev_state_map_.find(cdev_name);
+        cooling_devices.push_back({
+                .type = cdev_info.type,
+                .name = cdev_name,
+                .value = state_it != cdev_state_map_.end() ? state_it->second : 0,
+        });
+    }
+    return cooling_devices;
+}
+
 bool ThermalHelperImpl::readDataByType(std::string_view sensor_data, float *reading_value,
                                        const SensorFusionType type, const bool force_no_cache,
-                                       std::map<std::string, float> *sensor_log_map) {
+                                       size_t log_index) {
     switch (type) {
         case SensorFusionType::SENSOR:
-            if (!readThermalSensor(sensor_data.data(), reading_value, force_no_cache,
-                                   sensor_log_map)) {
+            if (!readThermalSensor(sensor_data.data(), reading_value, force_no_cache)) {
                 LOG(ERROR) << "Failed to get " << sensor_data.data() << " data";
                 return false;
             }
@@ -885,7 +1351,7 @@ bool ThermalHelperImpl::readDataByType(std::string_view sensor_data, float *read
                 LOG(INFO) << "Power data " << sensor_data.data() << " is under collecting";
                 return true;
             }
-            (*sensor_log_map)[sensor_data.data()] = *reading_value;
+            sample_log_.updateValue(log_index, *reading_value);
             break;
         case SensorFusionType::CONSTANT:
             *reading_value = std::atof(sensor_data.data());
@@ -897,7 +1363,7 @@ bool ThermalHelperImpl::readDataByType(std::string_view sensor_data, float *read
 }
 
 float ThermalHelperImpl::runVirtualTempEstimator(std::string_view sensor_name,
-                                                 std::map<std::string, float> *sensor_log_map) {
+                                                 const std::vector<float> &sensor_readings) {
     std::vector<float> model_inputs;
     float estimated_vt = NAN;
     constexpr int kCelsius2mC = 1000;
@@ -919,15 +1385,13 @@ float ThermalHelperImpl::runVirtualTempEstimator(std::string_view sensor_name,
     model_inputs.reserve(sensor_info.virtual_sensor_info->linked_sensors.size());
 
     for (size_t i = 0; i < sensor_info.virtual_sensor_info->linked_sensors.size(); i++) {
-        std::string linked_sensor = sensor_info.virtual_sensor_info->linked_sensors[i];
-
-        if ((*sensor_log_map).count(linked_sensor.data())) {
-            float value = (*sensor_log_map)[linked_sensor.data()];
-            model_inputs.push_back(value / kCelsius2mC);
-        } else {
-            LOG(ERROR) << "failed to read sensor: " << linked_sensor;
+        if (i >= sensor_readings.size() ||
+            sensor_info.virtual_sensor_info->linked_sensors_type[i] != SensorFusionType::SENSOR) {
+            LOG(ERROR) << "failed to read sensor: "
+                       << sensor_info.virtual_sensor_info->linked_sensors[i];
             return NAN;
         }
+        model_inputs.push_back(sensor_readings[i] / kCelsius2mC);
     }
 
     ::thermal::vtestimator::VtEstimatorStatus ret =
@@ -940,11 +1404,81 @@ float ThermalHelperImpl::runVirtualTempEstimator(std::string_view sensor_name,
     return (estimated_vt * kCelsius2mC);
 }
 
+void ThermalHelperImpl::initializeSampleLog() {
+    // Sensors take the first indices, then the power rails they are linked to
+    for (auto &[sensor, sensor_status] : sensor_status_map_) {
+        sensor_status.log_index = sample_log_.getSourceIndex(sensor);
+    }
+    const auto get_log_indices = [this](const std::vector<std::string> &sources,
+                                        const std::vector<SensorFusionType> &types) {
+        std::vector<size_t> log_indices(sources.size(), kInvalidSampleLogIndex);
+        for (size_t i = 0; i < sources.size() && i < types.size(); i++) {
+            if (types[i] == SensorFusionType::SENSOR || types[i] == SensorFusionType::ODPM) {
+                log_indices[i] = sample_log_.getSourceIndex(sources[i]);
+            }
+        }
+        return log_indices;
+    };
+    for (auto &[sensor, sensor_status] : sensor_status_map_) {
+        const auto &virtual_sensor_info = sensor_info_map_.at(sensor).virtual_sensor_info;
+        if (virtual_sensor_info == nullptr) {
+            continue;
+        }
+        sensor_status.linked_log_indices = get_log_indices(virtual_sensor_info->linked_sensors,
+                                                           virtual_sensor_info->linked_sensors_type);
+        sensor_status.coefficient_log_indices = get_log_indices(
+                virtual_sensor_info->coefficients, virtual_sensor_info->coefficients_type);
+    }
+
+    // A sample captures the sensor itself and all the sources it is composed of
+    for (const auto &[sensor, sensor_status] : sensor_status_map_) {
+        std::vector<size_t> inputs;
+        std::vector<std::string_view> pending_sensors = {sensor};
+        const auto add_input = [&inputs](size_t log_index) {
+            if (std::find(inputs.begin(), inputs.end(), log_index) != inputs.end()) {
+                return false;
+            }
+            inputs.push_back(log_index);
+            return true;
+        };
+        while (!pending_sensors.empty()) {
+            const auto status_it = sensor_status_map_.find(pending_sensors.back().data());
+            pending_sensors.pop_back();
+            if (status_it == sensor_status_map_.end() ||
+                !add_input(status_it->second.log_index)) {
+                continue;
+            }
+            const auto &virtual_sensor_info =
+                    sensor_info_map_.at(status_it->first).virtual_sensor_info;
+            if (virtual_sensor_info == nullptr) {
+                continue;
+            }
+            for (const auto &[sources, types, log_indices] :
+                 {std::tie(virtual_sensor_info->linked_sensors,
+                           virtual_sensor_info->linked_sensors_type,
+                           status_it->second.linked_log_indices),
+                  std::tie(virtual_sensor_info->coefficients,
+                           virtual_sensor_info->coefficients_type,
+                           status_it->second.coefficient_log_indices)}) {
+                for (size_t i = 0; i < log_indices.size(); i++) {
+                    if (types[i] == SensorFusionType::SENSOR) {
+                        // Linked sensors are expanded to their own sources
+                        pending_sensors.push_back(sources[i]);
+                    } else if (log_indices[i] != kInvalidSampleLogIndex) {
+                        add_input(log_indices[i]);
+                    }
+                }
+            }
+        }
+        sample_log_.setSampleInputs(sensor_status.log_index, std::move(inputs));
+    }
+    sample_log_.finalize();
+}
+
 constexpr int kTranTimeoutParam = 2;
 
 bool ThermalHelperImpl::readThermalSensor(std::string_view sensor_name, float *temp,
-                                          const bool force_no_cache,
-                                          std::map<std::string, float> *sensor_log_map) {
+                                          const bool force_no_cache) {
     std::string file_reading;
     boot_clock::time_point now = boot_clock::now();
 
@@ -974,15 +1508,28 @@ bool ThermalHelperImpl::readThermalSensor(std::string_view sensor_name, float *t
         (since_last_update < sensor_info.time_resolution) &&
         !isnan(sensor_status.thermal_cached.temp)) {
         *temp = sensor_status.thermal_cached.temp;
-        (*sensor_log_map)[sensor_name.data()] = *temp;
+        sample_log_.updateValue(sensor_status.log_index, *temp);
         ATRACE_INT((sensor_name.data() + std::string("-cached")).c_str(), static_cast<int>(*temp));
         return true;
     }
 
     // Reading thermal sensor according to it's composition
     if (sensor_info.virtual_sensor_info == nullptr) {
-        if (!thermal_sensors_.readThermalFile(sensor_name.data(), &file_reading) ||
-            file_reading.empty()) {
+        {
+            // Binder threads may read the sensors while the watcher prefetches
+            std::lock_guard<std::mutex> _lock(prefetched_reading_mutex_);
+            const auto prefetched_it = prefetched_reading_map_.find(sensor_name.data());
+            if (prefetched_it != prefetched_reading_map_.end()) {
+                file_reading = std::move(prefetched_it->second);
+                prefetched_reading_map_.erase(prefetched_it);
+            }
+        }
+        if (file_reading.empty()) {
+            if (!thermal_sensors_.readThermalFile(sensor_name.data(), &file_reading)) {
+                file_reading.clear();
+            }
+        }
+        if (file_reading.empty()) {
             LOG(ERROR) << "failed to read sensor: " << sensor_name << " zone: " << sensor_info.zone_name;
             return false;
         }
@@ -996,7 +1543,7 @@ bool ThermalHelperImpl::readThermalSensor(std::string_view sensor_name, float *t
             if (!readDataByType(sensor_info.virtual_sensor_info->linked_sensors[i],
                                 &sensor_readings[i],
                                 sensor_info.virtual_sensor_info->linked_sensors_type[i],
-                                force_no_cache, sensor_log_map)) {
+                                force_no_cache, sensor_status.linked_log_indices[i])) {
                 LOG(ERROR) << "Failed to read " << sensor_name.data() << "'s linked sensor "
                            << sensor_info.virtual_sensor_info->linked_sensors[i];
                 return false;
@@ -1008,7 +1555,7 @@ bool ThermalHelperImpl::readThermalSensor(std::string_view sensor_name, float *t
         }
 
         if (sensor_info.virtual_sensor_info->formula == FormulaOption::USE_ML_MODEL) {
-            *temp = runVirtualTempEstimator(sensor_name, sensor_log_map);
+            *temp = runVirtualTempEstimator(sensor_name, sensor_readings);
 
             if (std::isnan(*temp)) {
                 LOG(ERROR) << "VirtualEstimator returned NAN for " << sensor_name;
@@ -1020,7 +1567,7 @@ bool ThermalHelperImpl::readThermalSensor(std::string_view sensor_name, float *t
                 float coefficient = 0.0;
                 if (!readDataByType(sensor_info.virtual_sensor_info->coefficients[i], &coefficient,
                                     sensor_info.virtual_sensor_info->coefficients_type[i],
-                                    force_no_cache, sensor_log_map)) {
+                                    force_no_cache, sensor_status.coefficient_log_indices[i])) {
                     LOG(ERROR) << "Failed to read " << sensor_name.data() << "'s coefficient "
                                << sensor_info.virtual_sensor_info->coefficients[i];
                     return false;
@@ -1065,7 +1612,7 @@ bool ThermalHelperImpl::readThermalSensor(std::string_view sensor_name, float *t
                  (1 - sensor_info.step_ratio) * sensor_status.thermal_cached.temp);
     }
 
-    (*sensor_log_map)[sensor_name.data()] = *temp;
+    sample_log_.updateValue(sensor_status.log_index, *temp);
     ATRACE_INT(sensor_name.data(), static_cast<int>(*temp));
 
     {
@@ -1078,6 +1625,158 @@ bool ThermalHelperImpl::readThermalSensor(std::string_view sensor_name, float *t
     return true;
 }
 
+void ThermalHelperImpl::checkResume(boot_clock::time_point now) {
+    const auto steady_now = std::chrono::steady_clock::now();
+    const auto last_tick_boot_time = last_tick_boot_time_;
+    const auto last_tick_steady_time = last_tick_steady_time_;
+    last_tick_boot_time_ = now;
+    last_tick_steady_time_ = steady_now;
+    if (last_tick_boot_time == boot_clock::time_point::min()) {
+        return;
+    }
+    const auto suspend_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            (now - last_tick_boot_time) - (steady_now - last_tick_steady_time));
+    if (suspend_duration < kMinSuspendDurationMs) {
+        return;
+    }
+
+    ATRACE_CALL();
+    thermal_throttling_.onResume();
+
+    // Every sensor is due now. The hot ones, throttling or above their lowest hot threshold
+    // before suspend, are read in this tick and the others are staggered over the next ticks.
+    // Sensors come in name order
+    std::vector<size_t> cold_sensors;
+    {
+        std::shared_lock<std::shared_mutex> _lock(sensor_status_map_mutex_);
+        for (size_t j = 0; j < plan_sensor_info_.size(); ++j) {
+            const auto &sensor_info = *plan_sensor_info_[j];
+            const auto &sensor_status = *plan_sensor_status_[j];
+            thermal_forecaster_.clearForecast(control_plan_.sensor_names[j]);
+            if (!sensor_info.is_watch || sensor_status.severity != ThrottlingSeverity::NONE) {
+                continue;
+            }
+            const auto severity = severity_classifier_.classify(
+                    sensor_status.severity_index,
+                    sensor_status.thermal_cached.temp * sensor_info.multiplier,
+                    sensor_status.prev_hot_severity, sensor_status.prev_cold_severity);
+            if (severity.first == ThrottlingSeverity::NONE) {
+                cold_sensors.push_back(j);
+            }
+        }
+    }
+    std::fill(resume_deferred_until_.begin(), resume_deferred_until_.end(),
+              boot_clock::time_point::min());
+    for (size_t i = 0; i < cold_sensors.size(); ++i) {
+        resume_deferred_until_[cold_sensors[i]] =
+                now + kResumeStaggerStepMs * static_cast<int>(i / kResumeSensorsPerStep + 1);
+    }
+    LOG(INFO) << "Resumed after " << suspend_duration.count() << "ms suspend, defer "
+              << cold_sensors.size() << " cold sensors";
+}
+
+void ThermalHelperImpl::addSensorToPrefetch(size_t sensor_index, bool force_no_cache,
+                                            boot_clock::time_point now,
+                                            std::set<std::string> *prefetch_sensors) {
+    const auto &sensor_info = *plan_sensor_info_[sensor_index];
+    const auto &sensor_status = *plan_sensor_status_[sensor_index];
+    {
+        std::shared_lock<std::shared_mutex> _lock(sensor_status_map_mutex_);
+        if (sensor_status.override_status.emul_temp != nullptr) {
+            return;
+        }
+    }
+
+    if (sensor_info.virtual_sensor_info != nullptr) {
+        for (const size_t linked_sensor : control_plan_.sensors[sensor_index].linked_sensors) {
+            addSensorToPrefetch(linked_sensor, force_no_cache, now, prefetch_sensors);
+        }
+        return;
+    }
+
+    // Same cache check as readThermalSensor, a cached sensor is not read
+    if (!force_no_cache &&
+        sensor_status.thermal_cached.timestamp != boot_clock::time_point::min() &&
+        now - sensor_status.thermal_cached.timestamp < sensor_info.time_resolution &&
+        !isnan(sensor_status.thermal_cached.temp)) {
+        return;
+    }
+    prefetch_sensors->emplace(control_plan_.sensor_names[sensor_index]);
+}
+
+void ThermalHelperImpl::prefetchSensorReadings(const std::set<std::string> &uevent_sensors,
+                                               boot_clock::time_point now) {
+    const bool is_batch_read = thermal_sensors_.isBatchReadEnabled();
+    if (!thermal_executor_.isEnabled() && !is_batch_read) {
+        return;
+    }
+
+    // Same due check as the watcher loop, a sensor missed here is read serially
+    std::set<std::string> prefetch_sensors;
+    for (const size_t sensor_index : control_plan_.sensor_order) {
+        const auto &sensor_name = control_plan_.sensor_names[sensor_index];
+        const auto &sensor_info = *plan_sensor_info_[sensor_index];
+        const auto &sensor_status = *plan_sensor_status_[sensor_index];
+        if (!sensor_info.is_watch) {
+            continue;
+        }
+        const auto sleep_ms = getPollingDelay(sensor_name, sensor_info, sensor_status.severity);
+        bool is_due = false;
+        bool force_no_cache = false;
+        if (sensor_status.last_update_time == boot_clock::time_point::min()) {
+            is_due = true;
+        } else if (uevent_sensors.size()) {
+            if (sensor_info.virtual_sensor_info != nullptr) {
+                for (const size_t trigger_sensor :
+                     control_plan_.sensors[sensor_index].trigger_sensors) {
+                    is_due |= uevent_sensors.count(control_plan_.sensor_names[trigger_sensor]) > 0;
+                }
+            } else if (uevent_sensors.count(sensor_name)) {
+                is_due = true;
+                force_no_cache = true;
+            }
+        } else {
+            is_due = std::chrono::ceil<std::chrono::milliseconds>(
+                             now - sensor_status.last_update_time) >= sleep_ms;
+        }
+        if (now < resume_deferred_until_[sensor_index] && uevent_sensors.empty()) {
+            is_due = false;
+        }
+        if (is_due) {
+            addSensorToPrefetch(sensor_index, force_no_cache, now, &prefetch_sensors);
+        }
+    }
+    if (prefetch_sensors.size() < (is_batch_read ? kMinBatchReadings : kMinParallelReadings)) {
+        return;
+    }
+
+    ATRACE_CALL();
+    std::vector<std::string_view> sensor_names(prefetch_sensors.begin(), prefetch_sensors.end());
+    std::vector<std::string> file_readings;
+    if (is_batch_read) {
+        // A single submission reads all of the files, no worker is needed
+        thermal_sensors_.readThermalFiles(sensor_names, &file_readings);
+    } else {
+        // Each task only writes its own slot, the map is filled after all of them are done
+        file_readings.assign(sensor_names.size(), std::string());
+        std::vector<std::function<void()>> tasks;
+        tasks.reserve(sensor_names.size());
+        for (size_t i = 0; i < sensor_names.size(); ++i) {
+            tasks.emplace_back([this, &sensor_names, &file_readings, i] {
+                thermal_sensors_.readThermalFile(sensor_names[i], &file_readings[i]);
+            });
+        }
+        thermal_executor_.run(&tasks);
+    }
+
+    std::lock_guard<std::mutex> _lock(prefetched_reading_mutex_);
+    for (size_t i = 0; i < sensor_names.size(); ++i) {
+        if (!file_readings[i].empty()) {
+            prefetched_reading_map_.emplace(sensor_names[i], std::move(file_readings[i]));
+        }
+    }
+}
+
 // This is called in the different thread context and will update sensor_status
 // uevent_sensors is the set of sensors which trigger uevent from thermal core driver.
 std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
@@ -1085,66 +1784,75 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
     std::vector<Temperature> temps;
     std::vector<std::string> cooling_devices_to_update;
     boot_clock::time_point now = boot_clock::now();
-    auto min_sleep_ms = std::chrono::milliseconds::max();
+    thermal_profiler_.beginTick();
+    applyConfigReload();
+    // Wake up for the next scenario event if a scenario is playing
+    auto min_sleep_ms = applyScenarioEvents(now);
     bool power_data_is_updated = false;
+    checkResume(now);
+    {
+        ScopedProfileStage read_stage(&thermal_profiler_, ProfileStage::READ);
+        prefetchSensorReadings(uevent_sensors, now);
+    }
 
     ATRACE_CALL();
-    for (auto &name_status_pair : sensor_status_map_) {
+    // The due sensors are read first and their readings classified in one batch, the inputs of
+    // a virtual sensor are read before it
+    const size_t severity_sensor_count = severity_classifier_.getSensorCount();
+    severity_batch_.values.assign(severity_sensor_count, NAN);
+    severity_batch_.prev_hot_severities.assign(severity_sensor_count, ThrottlingSeverity::NONE);
+    severity_batch_.prev_cold_severities.assign(severity_sensor_count, ThrottlingSeverity::NONE);
+    watcher_readings_.clear();
+    for (const size_t sensor_index : control_plan_.sensor_order) {
         bool force_update = false;
         bool force_no_cache = false;
         Temperature temp;
         TemperatureThreshold threshold;
-        SensorStatus &sensor_status = name_status_pair.second;
-        const SensorInfo &sensor_info = sensor_info_map_.at(name_status_pair.first);
+        const std::string &sensor_name = control_plan_.sensor_names[sensor_index];
+        SensorStatus &sensor_status = *plan_sensor_status_[sensor_index];
+        const SensorInfo &sensor_info = *plan_sensor_info_[sensor_index];
         bool max_throttling = false;
+        bool override_pending = false;
 
         // Only handle the sensors in allow list
         if (!sensor_info.is_watch) {
             continue;
         }
 
-        ATRACE_NAME(StringPrintf("ThermalHelper::thermalWatcherCallbackFunc - %s",
-                                 name_status_pair.first.data())
-                            .c_str());
+        ATRACE_NAME(
+                StringPrintf("ThermalHelper::thermalWatcherCallbackFunc - %s", sensor_name.data())
+                        .c_str());
 
         std::chrono::milliseconds time_elapsed_ms = std::chrono::milliseconds::zero();
-        auto sleep_ms = (sensor_status.severity != ThrottlingSeverity::NONE)
-                                ? sensor_info.passive_delay
-                                : sensor_info.polling_delay;
-
-        if (sensor_info.virtual_sensor_info != nullptr &&
-            !sensor_info.virtual_sensor_info->trigger_sensors.empty()) {
-            for (size_t i = 0; i < sensor_info.virtual_sensor_info->trigger_sensors.size(); i++) {
-                const auto &trigger_sensor_status =
-                        sensor_status_map_.at(sensor_info.virtual_sensor_info->trigger_sensors[i]);
-                if (trigger_sensor_status.severity != ThrottlingSeverity::NONE) {
-                    sleep_ms = sensor_info.passive_delay;
-                    break;
-                }
+        auto sleep_ms = getPollingDelay(sensor_name, sensor_info, sensor_status.severity);
+
+        const auto &trigger_sensors = control_plan_.sensors[sensor_index].trigger_sensors;
+        for (const size_t trigger_sensor : trigger_sensors) {
+            if (plan_sensor_status_[trigger_sensor]->severity != ThrottlingSeverity::NONE) {
+                sleep_ms = sensor_info.passive_delay;
+                break;
             }
         }
         // Check if the sensor need to be updated
         if (sensor_status.last_update_time == boot_clock::time_point::min()) {
             force_update = true;
         } else {
-            time_elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            // Rounded up, the watcher timer fires at the deadline with sub-ms precision
+            time_elapsed_ms = std::chrono::ceil<std::chrono::milliseconds>(
                     now - sensor_status.last_update_time);
             if (uevent_sensors.size()) {
                 if (sensor_info.virtual_sensor_info != nullptr) {
-                    for (size_t i = 0; i < sensor_info.virtual_sensor_info->trigger_sensors.size();
-                         i++) {
-                        if (uevent_sensors.find(
-                                    sensor_info.virtual_sensor_info->trigger_sensors[i]) !=
-                            uevent_sensors.end()) {
+                    for (const size_t trigger_sensor : trigger_sensors) {
+                        if (uevent_sensors.count(control_plan_.sensor_names[trigger_sensor])) {
                             force_update = true;
                             break;
                         }
                     }
-                } else if (uevent_sensors.find(name_status_pair.first) != uevent_sensors.end()) {
+                } else if (uevent_sensors.find(sensor_name) != uevent_sensors.end()) {
                     force_update = true;
                     force_no_cache = true;
                 }
-            } else if (time_elapsed_ms > sleep_ms) {
+            } else if (time_elapsed_ms >= sleep_ms) {
                 force_update = true;
             }
         }
@@ -1153,88 +1861,175 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
             max_throttling = sensor_status.override_status.max_throttling;
             if (sensor_status.override_status.pending_update) {
                 force_update = sensor_status.override_status.pending_update;
+                override_pending = true;
                 sensor_status.override_status.pending_update = false;
             }
         }
-        LOG(VERBOSE) << "sensor " << name_status_pair.first
-                     << ": time_elapsed=" << time_elapsed_ms.count()
+        // A sensor deferred after resume waits for its turn unless an event targets it
+        auto &resume_deferred_until = resume_deferred_until_[sensor_index];
+        if (resume_deferred_until != boot_clock::time_point::min()) {
+            if (now < resume_deferred_until && !override_pending && uevent_sensors.empty()) {
+                const auto deferred_ms = std::chrono::ceil<std::chrono::milliseconds>(
+                        resume_deferred_until - now);
+                min_sleep_ms = std::min(min_sleep_ms, deferred_ms);
+                continue;
+            }
+            resume_deferred_until = boot_clock::time_point::min();
+        }
+        LOG(VERBOSE) << "sensor " << sensor_name << ": time_elapsed=" << time_elapsed_ms.count()
                      << ", sleep_ms=" << sleep_ms.count() << ", force_update = " << force_update
                      << ", force_no_cache = " << force_no_cache;
 
         if (!force_update) {
             auto timeout_remaining = sleep_ms - time_elapsed_ms;
-            if (min_sleep_ms > timeout_remaining) {
-                min_sleep_ms = timeout_remaining;
+            // Wake up as late as the slack allows, the sensors due by then share the wakeup
+            if (sleep_ms != std::chrono::milliseconds::max() &&
+                min_sleep_ms > timeout_remaining + sensor_info.polling_slack) {
+                min_sleep_ms = timeout_remaining + sensor_info.polling_slack;
             }
-            LOG(VERBOSE) << "sensor " << name_status_pair.first
+            LOG(VERBOSE) << "sensor " << sensor_name
                          << ": timeout_remaining=" << timeout_remaining.count();
             continue;
         }
 
-        std::pair<ThrottlingSeverity, ThrottlingSeverity> throttling_status;
-        if (!readTemperature(name_status_pair.first, &temp, &throttling_status, force_no_cache)) {
-            LOG(ERROR) << __func__
-                       << ": error reading temperature for sensor: " << name_status_pair.first;
-            continue;
-        }
-        if (!readTemperatureThreshold(name_status_pair.first, &threshold)) {
-            LOG(ERROR) << __func__ << ": error reading temperature threshold for sensor: "
-                       << name_status_pair.first;
-            continue;
+        {
+            ScopedProfileStage read_stage(&thermal_profiler_, ProfileStage::READ);
+            // The needed power rails are refreshed once per pass, before a virtual sensor
+            // fuses them
+            if (!power_data_is_updated) {
+                power_files_.refreshPowerStatus();
+                power_data_is_updated = true;
+            }
+            if (!readSensorTemperature(sensor_name, &temp, force_no_cache)) {
+                LOG(ERROR) << __func__
+                           << ": error reading temperature for sensor: " << sensor_name;
+                thermal_forecaster_.clearForecast(sensor_name);
+                continue;
+            }
+            if (!readTemperatureThreshold(sensor_name, &threshold)) {
+                LOG(ERROR) << __func__ << ": error reading temperature threshold for sensor: "
+                           << sensor_name;
+                continue;
+            }
         }
+        const size_t severity_index = sensor_status.severity_index;
+        severity_batch_.values[severity_index] = temp.value;
+        severity_batch_.prev_hot_severities[severity_index] = sensor_status.prev_hot_severity;
+        severity_batch_.prev_cold_severities[severity_index] = sensor_status.prev_cold_severity;
+        watcher_readings_.push_back({
+                .sensor_index = sensor_index,
+                .temp = std::move(temp),
+                .time_elapsed_ms = time_elapsed_ms,
+                .sleep_ms = sleep_ms,
+                .max_throttling = max_throttling,
+                .override_pending = override_pending,
+        });
+    }
+
+    {
+        ScopedProfileStage severity_stage(&thermal_profiler_, ProfileStage::SEVERITY);
+        severity_classifier_.classifyBatch(severity_batch_, &severities_,
+                                           &severity_changed_mask_);
+    }
 
+    for (auto &reading : watcher_readings_) {
+        const std::string &sensor_name = control_plan_.sensor_names[reading.sensor_index];
+        SensorStatus &sensor_status = *plan_sensor_status_[reading.sensor_index];
+        const SensorInfo &sensor_info = *plan_sensor_info_[reading.sensor_index];
+        Temperature &temp = reading.temp;
+        auto sleep_ms = reading.sleep_ms;
+        const size_t severity_index = sensor_status.severity_index;
+        const auto &throttling_status = severities_[severity_index];
+        applyTemperatureSeverity(sensor_name, throttling_status, &temp);
+
+        // The severity dependent work only runs for the sensors whose classified or emulated
+        // severity changed in this tick
+        const bool severity_changed =
+                ((severity_changed_mask_[severity_index / 64] >> (severity_index % 64)) & 1) ||
+                temp.throttlingStatus != sensor_status.severity;
+        const bool is_first_update =
+                sensor_status.last_update_time == boot_clock::time_point::min();
         {
-            // writer lock
-            std::unique_lock<std::shared_mutex> _lock(sensor_status_map_mutex_);
-            if (throttling_status.first != sensor_status.prev_hot_severity) {
+            ScopedProfileStage severity_stage(&thermal_profiler_, ProfileStage::SEVERITY);
+            const bool hot_severity_changed =
+                    throttling_status.first != sensor_status.prev_hot_severity;
+            if (severity_changed) {
+                // Only the watcher writes the severities, the writer lock is only taken on change
+                std::lock_guard<std::shared_mutex> _lock(sensor_status_map_mutex_);
                 sensor_status.prev_hot_severity = throttling_status.first;
-            }
-            if (throttling_status.second != sensor_status.prev_cold_severity) {
                 sensor_status.prev_cold_severity = throttling_status.second;
+                if (temp.throttlingStatus != sensor_status.severity) {
+                    temps.push_back(temp);
+                    sensor_status.severity = temp.throttlingStatus;
+                    sleep_ms = getPollingDelay(sensor_name, sensor_info, sensor_status.severity);
+                }
             }
-            if (temp.throttlingStatus != sensor_status.severity) {
-                temps.push_back(temp);
-                sensor_status.severity = temp.throttlingStatus;
-                sleep_ms = (sensor_status.severity != ThrottlingSeverity::NONE)
-                                   ? sensor_info.passive_delay
-                                   : sensor_info.polling_delay;
+            if (severity_changed || is_first_update) {
+                // The throttling power rails are sampled from the next pass while it throttles
+                power_files_.setPowerRailDemand(
+                        sensor_name, sensor_status.severity != ThrottlingSeverity::NONE);
             }
-        }
 
-        if (!power_data_is_updated) {
-            power_files_.refreshPowerStatus();
-            power_data_is_updated = true;
+            // Move the trip points around the new hot severity, or retry a failed programming
+            const auto trip_it = trip_point_map_.find(sensor_name);
+            if (trip_it != trip_point_map_.end() &&
+                (hot_severity_changed || !trip_it->second.is_armed)) {
+                armTripPoints(sensor_name, sensor_status.prev_hot_severity);
+                sleep_ms = getPollingDelay(sensor_name, sensor_info, sensor_status.severity);
+            }
         }
 
-        if (sensor_status.severity == ThrottlingSeverity::NONE) {
-            thermal_throttling_.clearThrottlingData(name_status_pair.first, sensor_info);
-        } else {
-            // update thermal throttling request
-            thermal_throttling_.thermalThrottlingUpdate(
-                    temp, sensor_info, sensor_status.severity, time_elapsed_ms,
-                    power_files_.GetPowerStatusMap(), cooling_device_info_map_, max_throttling);
+        {
+            ScopedProfileStage throttling_stage(&thermal_profiler_, ProfileStage::THROTTLING);
+            thermal_forecaster_.updateForecast(sensor_name, sensor_info, temp.value, now,
+                                               power_files_.GetPowerStatusMap());
+
+            if (sensor_status.severity != ThrottlingSeverity::NONE) {
+                // The PID integral moves on every reading, a throttling sensor is always updated
+                SensorForecast forecast;
+                const bool has_forecast = thermal_forecaster_.getForecast(sensor_name, &forecast);
+                thermal_throttling_.thermalThrottlingUpdate(
+                        temp, sensor_info, sensor_status.severity, reading.time_elapsed_ms,
+                        power_files_.GetPowerStatusMap(), cooling_device_info_map_,
+                        reading.max_throttling, has_forecast ? &forecast : nullptr);
+                thermal_throttling_.computeCoolingDevicesRequest(sensor_name, sensor_info,
+                                                                 sensor_status.severity,
+                                                                 &cooling_devices_to_update,
+                                                                 &thermal_stats_helper_);
+            } else if (severity_changed || is_first_update || reading.override_pending) {
+                // A sensor staying at NONE keeps its cleared throttling and requests
+                thermal_throttling_.clearThrottlingData(sensor_name, sensor_info);
+                thermal_throttling_.computeCoolingDevicesRequest(sensor_name, sensor_info,
+                                                                 sensor_status.severity,
+                                                                 &cooling_devices_to_update,
+                                                                 &thermal_stats_helper_);
+            }
         }
-
-        thermal_throttling_.computeCoolingDevicesRequest(
-                name_status_pair.first, sensor_info, sensor_status.severity,
-                &cooling_devices_to_update, &thermal_stats_helper_);
-        if (min_sleep_ms > sleep_ms) {
-            min_sleep_ms = sleep_ms;
+        if (sleep_ms != std::chrono::milliseconds::max() &&
+            min_sleep_ms > sleep_ms + sensor_info.polling_slack) {
+            min_sleep_ms = sleep_ms + sensor_info.polling_slack;
         }
 
-        LOG(VERBOSE) << "Sensor " << name_status_pair.first << ": sleep_ms=" << sleep_ms.count()
+        LOG(VERBOSE) << "Sensor " << sensor_name << ": sleep_ms=" << sleep_ms.count()
                      << ", min_sleep_ms voting result=" << min_sleep_ms.count();
         sensor_status.last_update_time = now;
     }
 
     if (!cooling_devices_to_update.empty()) {
+        ScopedProfileStage actuation_stage(&thermal_profiler_, ProfileStage::ACTUATION);
         updateCoolingDevices(cooling_devices_to_update);
     }
 
     if (!temps.empty()) {
+        ScopedProfileStage callback_stage(&thermal_profiler_, ProfileStage::CALLBACK);
         for (const auto &t : temps) {
             if (sensor_info_map_.at(t.name).send_cb && cb_) {
+                const auto cb_start_time = boot_clock::now();
                 cb_(t);
+                thermal_scenario_.recordCallback(
+                        t.name, cb_start_time,
+                        std::chrono::duration_cast<std::chrono::microseconds>(
+                                boot_clock::now() - cb_start_time));
             }
 
             if (sensor_info_map_.at(t.name).send_powerhint) {
@@ -1243,17 +2038,31 @@ std::chrono::milliseconds ThermalHelperImpl::thermalWatcherCallbackFunc(
         }
     }
 
-    int count_failed_reporting = thermal_stats_helper_.reportStats();
-    if (count_failed_reporting != 0) {
-        LOG(ERROR) << "Failed to report " << count_failed_reporting << " thermal stats";
-    }
+    {
+        ScopedProfileStage stats_stage(&thermal_profiler_, ProfileStage::STATS);
+        int count_failed_reporting = thermal_stats_helper_.reportStats();
+        if (count_failed_reporting != 0) {
+            LOG(ERROR) << "Failed to report " << count_failed_reporting << " thermal stats";
+        }
 
-    const auto since_last_power_log_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now - power_files_.GetPrevPowerLogTime());
-    if (since_last_power_log_ms >= kPowerLogIntervalMs) {
-        power_files_.logPowerStatus(now);
+        for (auto &[cdev_name, freq_cdev] : freq_cdev_map_) {
+            freq_cdev->sampleCurFreq();
+        }
+
+        const auto since_last_power_log_ms =
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                        now - power_files_.GetPrevPowerLogTime());
+        if (since_last_power_log_ms >= kPowerLogIntervalMs) {
+            power_files_.logPowerStatus(now);
+        }
     }
 
+    {
+        // Drop the readings of the sensors which turned out not to be read
+        std::lock_guard<std::mutex> _lock(prefetched_reading_mutex_);
+        prefetched_reading_map_.clear();
+    }
+    thermal_profiler_.endTick();
     return min_sleep_ms;
 }
 
@@ -9,9 +9,13 @@
 #include <aidl/android/hardware/thermal/IThermal.h>
 
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <future>
 #include <map>
 #include <mutex>
+#include <optional>
+#include <set>
 #include <shared_mutex>
 #include <string>
 #include <string_view>
@@ -21,8 +25,18 @@
 
 #include "utils/power_files.h"
 #include "utils/powerhal_helper.h"
+#include "utils/thermal_executor.h"
 #include "utils/thermal_files.h"
+#include "utils/thermal_forecast.h"
+#include "utils/thermal_freq_cdev.h"
+#include "utils/thermal_config_reload.h"
+#include "utils/thermal_config_schema.h"
 #include "utils/thermal_info.h"
+#include "utils/thermal_plan.h"
+#include "utils/thermal_profiler.h"
+#include "utils/thermal_sample_log.h"
+#include "utils/thermal_scenario.h"
+#include "utils/thermal_severity.h"
 #include "utils/thermal_stats_helper.h"
 #include "utils/thermal_throttling.h"
 #include "utils/thermal_watcher.h"
@@ -63,6 +77,30 @@ struct SensorStatus {
     boot_clock::time_point last_update_time;
     ThermalSample thermal_cached;
     OverrideStatus override_status;
+    // Index of the sensor and of its linked sources in the sample log
+    size_t log_index;
+    std::vector<size_t> linked_log_indices;
+    std::vector<size_t> coefficient_log_indices;
+    // Index of the sensor in the severity classifier
+    size_t severity_index;
+};
+
+// The kernel trip points of a thermal zone, programmed around the hot severity of the sensor
+struct TripPointStatus {
+    std::string tz_path;
+    // Whether trip_point_1 is also writable, to be notified when the severity drops
+    bool has_low_trip;
+    ThrottlingSeverity armed_severity;
+    // False if the last programming failed, the sensor is then polled until it succeeds
+    bool is_armed;
+};
+
+// A copy of the published sensor status, safe to use without holding the status lock
+struct SensorStatusSnapshot {
+    ThrottlingSeverity severity;
+    ThermalSample thermal_cached;
+    std::optional<EmulTemp> emul_temp;
+    bool max_throttling;
 };
 
 class ThermalHelper {
@@ -74,12 +112,20 @@ class ThermalHelper {
                                            std::vector<TemperatureThreshold> *thresholds) const = 0;
     virtual bool fillCurrentCoolingDevices(bool filterType, CoolingType type,
                                            std::vector<CoolingDevice> *coolingdevices) const = 0;
+    virtual std::vector<CoolingDevice> GetCoolingDeviceSnapshot() const = 0;
     virtual bool emulTemp(std::string_view target_sensor, const float temp,
                           const bool max_throttling) = 0;
     virtual bool emulSeverity(std::string_view target_sensor, const int severity,
                               const bool max_throttling) = 0;
     virtual bool emulClear(std::string_view target_sensor) = 0;
+    virtual bool startScenario(std::string_view source, const bool loop, const float speed) = 0;
+    virtual void stopScenario() = 0;
+    virtual bool reloadConfig(std::string_view config_file, std::string *result) = 0;
+    virtual void dumpScenario(std::ostringstream *dump_buf) const = 0;
+    virtual void dumpProfile(std::ostringstream *dump_buf) const = 0;
+    virtual void dumpFreqCoolingDevices(std::ostringstream *dump_buf) const = 0;
     virtual bool isInitializedOk() const = 0;
+    virtual std::shared_lock<std::shared_mutex> LockConfigShared() const = 0;
     virtual bool readTemperature(
             std::string_view sensor_name, Temperature *out,
             std::pair<ThrottlingSeverity, ThrottlingSeverity> *throtting_status = nullptr,
@@ -90,14 +136,24 @@ class ThermalHelper {
     virtual const std::unordered_map<std::string, SensorInfo> &GetSensorInfoMap() const = 0;
     virtual const std::unordered_map<std::string, CdevInfo> &GetCdevInfoMap() const = 0;
     virtual const std::unordered_map<std::string, SensorStatus> &GetSensorStatusMap() const = 0;
+    virtual std::unordered_map<std::string, SensorStatusSnapshot> GetSensorStatusSnapshot()
+            const = 0;
     virtual const std::unordered_map<std::string, ThermalThrottlingStatus> &
     GetThermalThrottlingStatusMap() const = 0;
+    virtual std::unordered_map<std::string, ThermalThrottlingStatus>
+    GetThermalThrottlingStatusSnapshot() const = 0;
     virtual const std::unordered_map<std::string, PowerRailInfo> &GetPowerRailInfoMap() const = 0;
     virtual const std::unordered_map<std::string, PowerStatus> &GetPowerStatusMap() const = 0;
+    virtual std::unordered_map<std::string, PowerStatus> GetPowerStatusSnapshot() const = 0;
     virtual const std::unordered_map<std::string, SensorTempStats> GetSensorTempStatsSnapshot() = 0;
     virtual const std::unordered_map<std::string,
                                      std::unordered_map<std::string, ThermalStats<int>>>
     GetSensorCoolingDeviceRequestStatsSnapshot() = 0;
+    virtual ThermalHistogramsSnapshot GetThermalHistogramsSnapshot() const = 0;
+    virtual std::unordered_map<std::string, SensorForecast> GetSensorForecastSnapshot() const = 0;
+    virtual std::chrono::milliseconds GetForecastHorizon() const = 0;
+    virtual void dumpSampleLog(std::ostringstream *dump_buf,
+                               std::string_view sensor_filter) const = 0;
     virtual bool isAidlPowerHalExist() = 0;
     virtual bool isPowerHalConnected() = 0;
     virtual bool isPowerHalExtConnected() = 0;
@@ -106,7 +162,7 @@ class ThermalHelper {
 class ThermalHelperImpl : public ThermalHelper {
   public:
     explicit ThermalHelperImpl(const NotificationCallback &cb);
-    ~ThermalHelperImpl() override = default;
+    ~ThermalHelperImpl() override;
 
     bool fillCurrentTemperatures(bool filterType, bool filterCallback, TemperatureType type,
                                  std::vector<Temperature> *temperatures) override;
@@ -114,6 +170,8 @@ class ThermalHelperImpl : public ThermalHelper {
                                    std::vector<TemperatureThreshold> *thresholds) const override;
     bool fillCurrentCoolingDevices(bool filterType, CoolingType type,
                                    std::vector<CoolingDevice> *coolingdevices) const override;
+    // Get the states last requested to the cooling devices, without reading them
+    std::vector<CoolingDevice> GetCoolingDeviceSnapshot() const override;
     bool emulTemp(std::string_view target_sensor, const float temp,
                   const bool max_throttling) override;
     bool emulSeverity(std::string_view target_sensor, const int severity,
@@ -125,6 +183,11 @@ class ThermalHelperImpl : public ThermalHelper {
     void operator=(const ThermalHelperImpl &) = delete;
 
     bool isInitializedOk() const override { return is_initialized_; }
+    // Held by the readers of the tunables a config reload updates in place, on other threads
+    // than the watcher: the AIDL getters reading the sensor info, and the dump
+    std::shared_lock<std::shared_mutex> LockConfigShared() const override {
+        return std::shared_lock<std::shared_mutex>(config_mutex_);
+    }
 
     // Read the temperature of a single sensor.
     bool readTemperature(
@@ -149,11 +212,19 @@ class ThermalHelperImpl : public ThermalHelper {
         std::shared_lock<std::shared_mutex> _lock(sensor_status_map_mutex_);
         return sensor_status_map_;
     }
+    // Get a copy of the published sensor status
+    std::unordered_map<std::string, SensorStatusSnapshot> GetSensorStatusSnapshot()
+            const override;
     // Get ThermalThrottling Map
     const std::unordered_map<std::string, ThermalThrottlingStatus> &GetThermalThrottlingStatusMap()
             const override {
         return thermal_throttling_.GetThermalThrottlingStatusMap();
     }
+    // Get a copy of the throttling status
+    std::unordered_map<std::string, ThermalThrottlingStatus> GetThermalThrottlingStatusSnapshot()
+            const override {
+        return thermal_throttling_.GetThermalThrottlingStatusSnapshot();
+    }
     // Get PowerRailInfo Map
     const std::unordered_map<std::string, PowerRailInfo> &GetPowerRailInfoMap() const override {
         return power_files_.GetPowerRailInfoMap();
@@ -163,6 +234,10 @@ class ThermalHelperImpl : public ThermalHelper {
     const std::unordered_map<std::string, PowerStatus> &GetPowerStatusMap() const override {
         return power_files_.GetPowerStatusMap();
     }
+    // Get a copy of the power status
+    std::unordered_map<std::string, PowerStatus> GetPowerStatusSnapshot() const override {
+        return power_files_.GetPowerStatusSnapshot();
+    }
 
     // Get Thermal Stats Sensor Map
     const std::unordered_map<std::string, SensorTempStats> GetSensorTempStatsSnapshot() override {
@@ -173,6 +248,38 @@ class ThermalHelperImpl : public ThermalHelper {
     GetSensorCoolingDeviceRequestStatsSnapshot() override {
         return thermal_stats_helper_.GetSensorCoolingDeviceRequestStatsSnapshot();
     }
+    // Get the temperature, time to mitigate and cdev dwell distributions
+    ThermalHistogramsSnapshot GetThermalHistogramsSnapshot() const override {
+        return thermal_stats_helper_.GetThermalHistogramsSnapshot();
+    }
+    // Get the latest headroom forecast of the monitored sensors
+    std::unordered_map<std::string, SensorForecast> GetSensorForecastSnapshot() const override {
+        return thermal_forecaster_.GetForecastSnapshot();
+    }
+    std::chrono::milliseconds GetForecastHorizon() const override {
+        return thermal_forecaster_.getHorizon();
+    }
+    // Dump the recent samples of the watched sensors
+    void dumpSampleLog(std::ostringstream *dump_buf,
+                       std::string_view sensor_filter) const override {
+        sample_log_.dump(dump_buf, sensor_filter);
+    }
+
+    // Play back a scripted scenario through the emulation overrides
+    bool startScenario(std::string_view source, const bool loop, const float speed) override;
+    void stopScenario() override;
+    // Reload the tunables of the config, the current config if no file is given. A config
+    // changing the structure is rejected, the result tells what was applied or why not.
+    bool reloadConfig(std::string_view config_file, std::string *result) override;
+    void dumpScenario(std::ostringstream *dump_buf) const override {
+        thermal_scenario_.dump(dump_buf);
+    }
+    // Dump the cost of the thermal watcher ticks
+    void dumpProfile(std::ostringstream *dump_buf) const override {
+        thermal_profiler_.dump(dump_buf);
+    }
+    // Dump the cap and the achieved frequency of the frequency domain cdevs
+    void dumpFreqCoolingDevices(std::ostringstream *dump_buf) const override;
 
     bool isAidlPowerHalExist() override { return power_hal_service_.isAidlPowerHalExist(); }
     bool isPowerHalConnected() override { return power_hal_service_.isPowerHalConnected(); }
@@ -185,30 +292,56 @@ class ThermalHelperImpl : public ThermalHelper {
     void setMinTimeout(SensorInfo *sensor_info);
     void initializeTrip(const std::unordered_map<std::string, std::string> &path_map,
                         std::set<std::string> *monitored_sensors, bool thermal_genl_enabled);
+    // Program the trip points of the sensor around the hot severity: the next hot threshold
+    // above, and the current threshold whose hysteresis drops the severity
+    bool armTripPoints(std::string_view sensor_name, ThrottlingSeverity severity);
+    // The polling interval of the sensor at the severity, none while its trip points cover it
+    std::chrono::milliseconds getPollingDelay(std::string_view sensor_name,
+                                              const SensorInfo &sensor_info,
+                                              ThrottlingSeverity severity) const;
     void clearAllThrottling();
     // For thermal_watcher_'s polling thread, return the sleep interval
     std::chrono::milliseconds thermalWatcherCallbackFunc(
             const std::set<std::string> &uevent_sensors);
-    // Return hot and cold severity status as std::pair
-    std::pair<ThrottlingSeverity, ThrottlingSeverity> getSeverityFromThresholds(
-            const ThrottlingArray &hot_thresholds, const ThrottlingArray &cold_thresholds,
-            const ThrottlingArray &hot_hysteresis, const ThrottlingArray &cold_hysteresis,
-            ThrottlingSeverity prev_hot_severity, ThrottlingSeverity prev_cold_severity,
-            float value) const;
     // Read sensor data according to the type
     bool readDataByType(std::string_view sensor_data, float *reading_value,
                         const SensorFusionType type, const bool force_no_cache,
-                        std::map<std::string, float> *sensor_log_map);
+                        size_t log_index);
     // Read temperature data according to thermal sensor's info
-    bool readThermalSensor(std::string_view sensor_name, float *temp, const bool force_sysfs,
-                           std::map<std::string, float> *sensor_log_map);
+    bool readThermalSensor(std::string_view sensor_name, float *temp, const bool force_sysfs);
+    // Read the temperature of a sensor without classifying it
+    bool readSensorTemperature(std::string_view sensor_name, Temperature *out,
+                               const bool force_no_cache);
+    // Set the throttling status of a reading from its hot and cold severity, or from the
+    // emulated severity, and record it for a monitored sensor
+    void applyTemperatureSeverity(std::string_view sensor_name, const SeverityPair &status,
+                                  Temperature *out);
     float runVirtualTempEstimator(std::string_view sensor_name,
-                                  std::map<std::string, float> *sensor_log_map);
+                                  const std::vector<float> &sensor_readings);
+    // Assign the sample log indices and the captured inputs of each sensor
+    void initializeSampleLog();
     void updateCoolingDevices(const std::vector<std::string> &cooling_devices_to_update);
+    // Write a cdev state to its frequency domain or its sysfs node
+    bool writeCoolingDevice(std::string_view cdev, int state);
     // Check the max CDEV state for cdev_ceiling
     void maxCoolingRequestCheck(
             std::unordered_map<std::string, BindedCdevInfo> *binded_cdev_info_map);
     void checkUpdateSensorForEmul(std::string_view target_sensor, const bool max_throttling);
+    // Apply the due scenario events, return the time until the next one
+    std::chrono::milliseconds applyScenarioEvents(boot_clock::time_point now);
+    // Start the resume phase if the watcher slept through a system suspend
+    void checkResume(boot_clock::time_point now);
+    // Reload the config on each change of the reload property, on its own thread
+    void configReloadRequestLoop();
+    // Apply the pending config reload, on the watcher thread
+    void applyConfigReload();
+    // Read the physical sensors due in this tick in parallel, including the ones linked by the
+    // due virtual sensors
+    void prefetchSensorReadings(const std::set<std::string> &uevent_sensors,
+                                boot_clock::time_point now);
+    // Add the physical sensors the reading of the sensor depends on to the prefetch list
+    void addSensorToPrefetch(size_t sensor_index, bool force_no_cache, boot_clock::time_point now,
+                             std::set<std::string> *prefetch_sensors);
     sp<ThermalWatcher> thermal_watcher_;
     PowerFiles power_files_;
     ThermalFiles thermal_sensors_;
@@ -217,11 +350,68 @@ class ThermalHelperImpl : public ThermalHelper {
     bool is_initialized_;
     const NotificationCallback cb_;
     std::unordered_map<std::string, CdevInfo> cooling_device_info_map_;
+    std::unordered_map<std::string, std::unique_ptr<FreqCoolingDevice>> freq_cdev_map_;
+    // The state last written to each cooling device, for the dump
+    mutable std::mutex cdev_state_map_mutex_;
+    std::unordered_map<std::string, int> cdev_state_map_;
     std::unordered_map<std::string, SensorInfo> sensor_info_map_;
     std::unordered_map<std::string, std::unordered_map<ThrottlingSeverity, ThrottlingSeverity>>
             supported_powerhint_map_;
     PowerHalService power_hal_service_;
     ThermalStatsHelper thermal_stats_helper_;
+    ThermalForecaster thermal_forecaster_;
+    ThermalSampleLog sample_log_;
+    ThermalScenario thermal_scenario_;
+    ThermalProfiler thermal_profiler_;
+    ThermalExecutor thermal_executor_;
+    SeverityClassifier severity_classifier_;
+    // Raw readings of the physical sensors prefetched for the current tick, consumed once
+    std::unordered_map<std::string, std::string> prefetched_reading_map_;
+    std::mutex prefetched_reading_mutex_;
+    // Boot and monotonic time of the last watcher tick, their drift is the time suspended
+    boot_clock::time_point last_tick_boot_time_ = boot_clock::time_point::min();
+    std::chrono::steady_clock::time_point last_tick_steady_time_ =
+            std::chrono::steady_clock::time_point::min();
+    // A sensor read in the watcher tick, evaluated once the readings of the tick are classified
+    struct WatcherReading {
+        size_t sensor_index;
+        Temperature temp;
+        std::chrono::milliseconds time_elapsed_ms;
+        std::chrono::milliseconds sleep_ms;
+        bool max_throttling;
+        bool override_pending;
+    };
+    // Only used by the watcher, kept across the ticks to reuse their storage
+    std::vector<WatcherReading> watcher_readings_;
+    SeverityBatch severity_batch_;
+    std::vector<SeverityPair> severities_;
+    std::vector<uint64_t> severity_changed_mask_;
+    // The plan of the init config, its sensor indices address the runtime tables below
+    ControlPlan control_plan_;
+    std::vector<const SensorInfo *> plan_sensor_info_;
+    std::vector<SensorStatus *> plan_sensor_status_;
+    // The time the cold sensors deferred after resume are read at, min() if not deferred
+    std::vector<boot_clock::time_point> resume_deferred_until_;
+    // The sensors whose thermal zone notifies its trip points, only used by the watcher
+    std::unordered_map<std::string, TripPointStatus> trip_point_map_;
+    struct PendingConfigReload {
+        ConfigReload reload;
+        std::promise<std::string> result;
+    };
+    // The config of the live entities, a reload is diffed against it
+    Json::Value live_config_;
+    // A reloaded config is validated against it before it is parsed, null if the schema could
+    // not be read
+    Json::Value config_schema_;
+    // Held for a whole reload, the reloaded config is parsed by the caller and applied by the
+    // watcher thread
+    std::mutex config_reload_mutex_;
+    // Held exclusively while a reload updates the live tunables, taken before the sensor status
+    mutable std::shared_mutex config_mutex_;
+    std::mutex pending_config_reload_mutex_;
+    std::unique_ptr<PendingConfigReload> pending_config_reload_;
+    std::atomic<bool> config_reload_aborted_ = false;
+    std::thread config_reload_thread_;
     mutable std::shared_mutex sensor_status_map_mutex_;
     std::unordered_map<std::string, SensorStatus> sensor_status_map_;
 };
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Tool checking thermal configs before they are shipped: the config is validated against the
+// schema, parsed as the HAL does, and compiled into its control plan. Every error is printed,
+// and the exit status is non-zero if any config fails.
+
+#include <android-base/logging.h>
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/thermal_config_schema.h"
+#include "utils/thermal_info.h"
+#include "utils/thermal_plan.h"
+
+using ::aidl::android::hardware::thermal::implementation::CdevInfo;
+using ::aidl::android::hardware::thermal::implementation::CompileControlPlan;
+using ::aidl::android::hardware::thermal::implementation::ControlPlan;
+using ::aidl::android::hardware::thermal::implementation::DumpControlPlan;
+using ::aidl::android::hardware::thermal::implementation::GetControlPlanSize;
+using ::aidl::android::hardware::thermal::implementation::ParseCoolingDevice;
+using ::aidl::android::hardware::thermal::implementation::ParsePowerRailInfo;
+using ::aidl::android::hardware::thermal::implementation::ParseSensorInfo;
+using ::aidl::android::hardware::thermal::implementation::ParseThermalConfig;
+using ::aidl::android::hardware::thermal::implementation::PowerRailInfo;
+using ::aidl::android::hardware::thermal::implementation::SensorInfo;
+using ::aidl::android::hardware::thermal::implementation::ValidateThermalConfigSchema;
+
+namespace {
+
+void PrintUsage(const char *name) {
+    std::cerr << "Usage: " << name << " [--schema <config_schema.json>] [--dump] [--verbose]"
+              << " <thermal_info_config.json>..." << std::endl;
+}
+
+bool CompileConfig(std::string_view config_path, const Json::Value *schema, const bool dump) {
+    std::vector<std::string> errors;
+    Json::Value config;
+    if (!ParseThermalConfig(config_path, &config)) {
+        std::cerr << config_path << ": could not be read" << std::endl;
+        return false;
+    }
+    // The parser aborts on some mistyped values, so it only runs on a valid config
+    if (schema != nullptr && !ValidateThermalConfigSchema(*schema, config, &errors)) {
+        for (const auto &error : errors) {
+            std::cerr << config_path << ": " << error << std::endl;
+        }
+        return false;
+    }
+
+    // Keep parsing after a failure, so that all the sections report their errors
+    std::unordered_map<std::string, CdevInfo> cooling_device_info_map;
+    std::unordered_map<std::string, SensorInfo> sensor_info_map;
+    std::unordered_map<std::string, PowerRailInfo> power_rail_info_map;
+    bool parsed = true;
+    if (!ParseCoolingDevice(config, &cooling_device_info_map)) {
+        errors.emplace_back("failed to parse CoolingDevices");
+        parsed = false;
+    }
+    if (!ParseSensorInfo(config, &sensor_info_map)) {
+        errors.emplace_back("failed to parse Sensors");
+        parsed = false;
+    }
+    if (!ParsePowerRailInfo(config, &power_rail_info_map)) {
+        errors.emplace_back("failed to parse PowerRails");
+        parsed = false;
+    }
+
+    ControlPlan plan;
+    if (parsed) {
+        CompileControlPlan(sensor_info_map, cooling_device_info_map, power_rail_info_map, &plan,
+                           &errors);
+    }
+    for (const auto &error : errors) {
+        std::cerr << config_path << ": " << error << std::endl;
+    }
+    if (!errors.empty()) {
+        return false;
+    }
+
+    if (dump) {
+        DumpControlPlan(plan, &std::cout);
+    } else {
+        std::cout << config_path << ": " << plan.sensors.size() << " sensors, "
+                  << plan.cdev_names.size() << " cdevs, " << plan.power_rails.size()
+                  << " power rails, plan size " << GetControlPlanSize(plan) << std::endl;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    ::android::base::InitLogging(argv, &::android::base::StderrLogger);
+    ::android::base::SetMinimumLogSeverity(::android::base::ERROR);
+
+    std::string schema_path;
+    bool dump = false;
+    std::vector<std::string> config_paths;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg(argv[i]);
+        if (arg == "--schema" && i + 1 < argc) {
+            schema_path = argv[++i];
+        } else if (arg == "--dump") {
+            dump = true;
+        } else if (arg == "--verbose") {
+            ::android::base::SetMinimumLogSeverity(::android::base::VERBOSE);
+        } else if (arg.starts_with("--")) {
+            PrintUsage(argv[0]);
+            return 1;
+        } else {
+            config_paths.emplace_back(arg);
+        }
+    }
+    if (config_paths.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    Json::Value schema;
+    if (!schema_path.empty() && !ParseThermalConfig(schema_path, &schema)) {
+        std::cerr << schema_path << ": could not be read" << std::endl;
+        return 1;
+    }
+
+    bool ret = true;
+    for (const auto &config_path : config_paths) {
+        if (!CompileConfig(config_path, schema_path.empty() ? nullptr : &schema, dump)) {
+            ret = false;
+        }
+    }
+    return ret ? 0 : 1;
+}
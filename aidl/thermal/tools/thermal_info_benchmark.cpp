@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Micro-benchmarks of the thermal config parsing on the HAL startup path. The configs are
+// generated with a growing number of sensors, each with PID throttling on its own cooling
+// device and a stats threshold. Besides the time, each benchmark reports the heap allocations
+// of a parse.
+
+#include <android-base/logging.h>
+#include <benchmark/benchmark.h>
+#include <json/reader.h>
+#include <json/writer.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <unordered_map>
+
+#include "utils/thermal_info.h"
+
+using ::aidl::android::hardware::thermal::implementation::AbnormalStatsInfo;
+using ::aidl::android::hardware::thermal::implementation::CdevInfo;
+using ::aidl::android::hardware::thermal::implementation::kThrottlingSeverityCount;
+using ::aidl::android::hardware::thermal::implementation::ParseCoolingDevice;
+using ::aidl::android::hardware::thermal::implementation::ParseCoolingDeviceStatsConfig;
+using ::aidl::android::hardware::thermal::implementation::ParsePowerRailInfo;
+using ::aidl::android::hardware::thermal::implementation::ParseSensorInfo;
+using ::aidl::android::hardware::thermal::implementation::ParseSensorStatsConfig;
+using ::aidl::android::hardware::thermal::implementation::PowerRailInfo;
+using ::aidl::android::hardware::thermal::implementation::SensorInfo;
+using ::aidl::android::hardware::thermal::implementation::StatsInfo;
+
+namespace {
+
+std::atomic<size_t> allocation_count(0);
+
+}  // namespace
+
+void *operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = std::malloc(size ? size : 1);
+    if (ptr == nullptr) {
+        std::abort();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t /*size*/) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+
+Json::Value SeverityArray(float none, float step) {
+    Json::Value values(Json::arrayValue);
+    for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
+        values.append(none + step * i);
+    }
+    return values;
+}
+
+Json::Value GenerateConfig(int sensor_count) {
+    Json::Value config;
+    Json::Value &sensors = config["Sensors"];
+    Json::Value &cooling_devices = config["CoolingDevices"];
+    Json::Value &power_rails = config["PowerRails"];
+    Json::Value &stats_thresholds = config["Stats"]["Sensors"]["RecordWithThreshold"];
+    for (int i = 0; i < sensor_count; ++i) {
+        const std::string name = "sensor" + std::to_string(i);
+        const std::string cdev_name = "cdev" + std::to_string(i);
+        const std::string rail_name = "rail" + std::to_string(i);
+
+        Json::Value sensor;
+        sensor["Name"] = name;
+        sensor["Type"] = "CPU";
+        sensor["HotThreshold"] = SeverityArray(40, 10);
+        sensor["HotThreshold"][0] = "NAN";
+        sensor["HotHysteresis"] = SeverityArray(1, 0);
+        sensor["VrThreshold"] = "NAN";
+        sensor["Multiplier"] = 0.001;
+        sensor["PollingDelay"] = 300000;
+        sensor["PassiveDelay"] = 7000;
+        Json::Value &pid_info = sensor["PIDInfo"];
+        pid_info["K_Po"] = SeverityArray(5, 0);
+        pid_info["K_Pu"] = SeverityArray(10, 0);
+        pid_info["K_I"] = SeverityArray(2, 0);
+        pid_info["K_D"] = SeverityArray(0, 0);
+        pid_info["I_Max"] = SeverityArray(3000, 0);
+        pid_info["MaxAllocPower"] = SeverityArray(8000, -1000);
+        pid_info["MinAllocPower"] = SeverityArray(1000, -100);
+        pid_info["S_Power"] = SeverityArray(3000, -100);
+        pid_info["I_Cutoff"] = SeverityArray(30, 0);
+        Json::Value binded_cdev;
+        binded_cdev["CdevRequest"] = cdev_name;
+        binded_cdev["CdevWeightForPID"] = SeverityArray(1, 0);
+        binded_cdev["LimitInfo"] = SeverityArray(0, 1);
+        binded_cdev["PowerRail"] = rail_name;
+        sensor["BindedCdevInfo"].append(binded_cdev);
+        sensors.append(sensor);
+
+        Json::Value cooling_device;
+        cooling_device["Name"] = cdev_name;
+        cooling_device["Type"] = "CPU";
+        for (int state = 0; state < 16; ++state) {
+            cooling_device["State2Power"].append(3000 - state * 150);
+        }
+        cooling_devices.append(cooling_device);
+
+        Json::Value power_rail;
+        power_rail["Name"] = rail_name;
+        power_rail["PowerSampleCount"] = 1;
+        power_rail["PowerSampleDelay"] = 1000;
+        power_rails.append(power_rail);
+
+        Json::Value stats_threshold;
+        stats_threshold["Name"] = name;
+        stats_threshold["Thresholds"] = SeverityArray(40, 10);
+        stats_thresholds.append(stats_threshold);
+    }
+    return config;
+}
+
+void SetAllocationCounter(benchmark::State &state, size_t allocations) {
+    state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocations),
+                                                  benchmark::Counter::kAvgIterations);
+}
+
+void BM_ReadConfig(benchmark::State &state) {
+    const Json::Value config = GenerateConfig(static_cast<int>(state.range(0)));
+    const std::string json_doc = Json::writeString(Json::StreamWriterBuilder(), config);
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    const size_t allocation_start = allocation_count.load();
+    for (auto _ : state) {
+        Json::Value config;
+        std::string error_message;
+        if (!reader->parse(json_doc.data(), json_doc.data() + json_doc.size(), &config,
+                           &error_message)) {
+            state.SkipWithError(error_message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(config);
+    }
+    SetAllocationCounter(state, allocation_count.load() - allocation_start);
+    state.SetBytesProcessed(state.iterations() * json_doc.size());
+}
+
+void BM_ParseSensorInfo(benchmark::State &state) {
+    const Json::Value config = GenerateConfig(static_cast<int>(state.range(0)));
+    const size_t allocation_start = allocation_count.load();
+    for (auto _ : state) {
+        std::unordered_map<std::string, SensorInfo> sensor_info_map;
+        if (!ParseSensorInfo(config, &sensor_info_map)) {
+            state.SkipWithError("Failed to parse Sensors");
+            break;
+        }
+        benchmark::DoNotOptimize(sensor_info_map);
+    }
+    SetAllocationCounter(state, allocation_count.load() - allocation_start);
+}
+
+void BM_ParseCoolingDevice(benchmark::State &state) {
+    const Json::Value config = GenerateConfig(static_cast<int>(state.range(0)));
+    const size_t allocation_start = allocation_count.load();
+    for (auto _ : state) {
+        std::unordered_map<std::string, CdevInfo> cooling_device_info_map;
+        if (!ParseCoolingDevice(config, &cooling_device_info_map)) {
+            state.SkipWithError("Failed to parse CoolingDevices");
+            break;
+        }
+        benchmark::DoNotOptimize(cooling_device_info_map);
+    }
+    SetAllocationCounter(state, allocation_count.load() - allocation_start);
+}
+
+void BM_ParsePowerRailInfo(benchmark::State &state) {
+    const Json::Value config = GenerateConfig(static_cast<int>(state.range(0)));
+    const size_t allocation_start = allocation_count.load();
+    for (auto _ : state) {
+        std::unordered_map<std::string, PowerRailInfo> power_rail_info_map;
+        if (!ParsePowerRailInfo(config, &power_rail_info_map)) {
+            state.SkipWithError("Failed to parse PowerRails");
+            break;
+        }
+        benchmark::DoNotOptimize(power_rail_info_map);
+    }
+    SetAllocationCounter(state, allocation_count.load() - allocation_start);
+}
+
+void BM_ParseStatsConfig(benchmark::State &state) {
+    const Json::Value config = GenerateConfig(static_cast<int>(state.range(0)));
+    std::unordered_map<std::string, SensorInfo> sensor_info_map;
+    std::unordered_map<std::string, CdevInfo> cooling_device_info_map;
+    if (!ParseSensorInfo(config, &sensor_info_map) ||
+        !ParseCoolingDevice(config, &cooling_device_info_map)) {
+        state.SkipWithError("Failed to parse the entities of the stats");
+        return;
+    }
+    const size_t allocation_start = allocation_count.load();
+    for (auto _ : state) {
+        StatsInfo<float> sensor_stats_info;
+        AbnormalStatsInfo abnormal_stats_info;
+        StatsInfo<int> cooling_device_request_info;
+        if (!ParseSensorStatsConfig(config, sensor_info_map, &sensor_stats_info,
+                                    &abnormal_stats_info) ||
+            !ParseCoolingDeviceStatsConfig(config, cooling_device_info_map,
+                                           &cooling_device_request_info)) {
+            state.SkipWithError("Failed to parse Stats");
+            break;
+        }
+        benchmark::DoNotOptimize(sensor_stats_info);
+    }
+    SetAllocationCounter(state, allocation_count.load() - allocation_start);
+}
+
+// From a small device to a config past the size of the current ones
+void ConfigSizes(benchmark::internal::Benchmark *benchmark) {
+    benchmark->Arg(10)->Arg(50)->Arg(100)->Arg(200)->Arg(400);
+}
+
+BENCHMARK(BM_ReadConfig)->Apply(ConfigSizes);
+BENCHMARK(BM_ParseSensorInfo)->Apply(ConfigSizes);
+BENCHMARK(BM_ParseCoolingDevice)->Apply(ConfigSizes);
+BENCHMARK(BM_ParsePowerRailInfo)->Apply(ConfigSizes);
+BENCHMARK(BM_ParseStatsConfig)->Apply(ConfigSizes);
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    ::android::base::InitLogging(argv, &::android::base::StderrLogger);
+    // The parsers log every value they read, which is not the parsing cost
+    ::android::base::SetMinimumLogSeverity(::android::base::ERROR);
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
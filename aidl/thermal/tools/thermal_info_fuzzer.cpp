@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// libFuzzer target for the thermal config parsers. The input is read as a JSON config and, when
+// valid against the schema, parsed into the sensors, cooling devices, power rails and stats as
+// the HAL does at init and on reload, which reject a config the schema does not accept.
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <json/reader.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/thermal_config_schema.h"
+#include "utils/thermal_info.h"
+
+using ::aidl::android::hardware::thermal::implementation::AbnormalStatsInfo;
+using ::aidl::android::hardware::thermal::implementation::CdevInfo;
+using ::aidl::android::hardware::thermal::implementation::ParseCoolingDevice;
+using ::aidl::android::hardware::thermal::implementation::ParseCoolingDeviceStatsConfig;
+using ::aidl::android::hardware::thermal::implementation::ParsePowerRailInfo;
+using ::aidl::android::hardware::thermal::implementation::ParseSensorInfo;
+using ::aidl::android::hardware::thermal::implementation::ParseSensorStatsConfig;
+using ::aidl::android::hardware::thermal::implementation::ParseThermalConfig;
+using ::aidl::android::hardware::thermal::implementation::PowerRailInfo;
+using ::aidl::android::hardware::thermal::implementation::SensorInfo;
+using ::aidl::android::hardware::thermal::implementation::StatsInfo;
+using ::aidl::android::hardware::thermal::implementation::ValidateThermalConfigSchema;
+
+namespace {
+
+// Installed with the fuzzer as its data
+constexpr std::string_view kSchemaPath("data/utils/config_schema.json");
+
+Json::Value schema;
+
+}  // namespace
+
+extern "C" int LLVMFuzzerInitialize(int * /*argc*/, char ***argv) {
+    ::android::base::InitLogging(*argv, &::android::base::StderrLogger);
+    const std::string schema_path =
+            ::android::base::GetExecutableDirectory() + "/" + std::string(kSchemaPath);
+    if (!ParseThermalConfig(schema_path, &schema)) {
+        LOG(FATAL) << "Could not read the config schema " << schema_path;
+    }
+    // The parsers log every value they read
+    ::android::base::SetMinimumLogSeverity(::android::base::FATAL);
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    const char *doc = reinterpret_cast<const char *>(data);
+    Json::Value config;
+    std::string error_message;
+    if (!reader->parse(doc, doc + size, &config, &error_message)) {
+        return 0;
+    }
+    // As in the HAL, the parsers only run on a config the schema accepts
+    std::vector<std::string> errors;
+    if (!ValidateThermalConfigSchema(schema, config, &errors)) {
+        return 0;
+    }
+
+    std::unordered_map<std::string, CdevInfo> cooling_device_info_map;
+    std::unordered_map<std::string, SensorInfo> sensor_info_map;
+    std::unordered_map<std::string, PowerRailInfo> power_rail_info_map;
+    if (!ParseCoolingDevice(config, &cooling_device_info_map) ||
+        !ParseSensorInfo(config, &sensor_info_map)) {
+        return 0;
+    }
+    ParsePowerRailInfo(config, &power_rail_info_map);
+
+    StatsInfo<float> sensor_stats_info;
+    AbnormalStatsInfo abnormal_stats_info;
+    StatsInfo<int> cooling_device_request_info;
+    ParseSensorStatsConfig(config, sensor_info_map, &sensor_stats_info, &abnormal_stats_info);
+    ParseCoolingDeviceStatsConfig(config, cooling_device_info_map, &cooling_device_request_info);
+    return 0;
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define ATRACE_TAG (ATRACE_TAG_THERMAL | ATRACE_TAG_HAL)
+
+#include "io_uring_reader.h"
+
+#include <android-base/logging.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+namespace {
+
+constexpr unsigned int kMaxRingDepth = 64;
+constexpr size_t kPreadChunkSize = 4096;
+
+int IoUringSetup(unsigned int entries, io_uring_params *params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ring_fd, unsigned int to_submit, unsigned int min_complete,
+                 unsigned int flags) {
+    return static_cast<int>(
+            syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int IoUringRegister(int ring_fd, unsigned int opcode, const void *arg, unsigned int nr_args) {
+    return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args));
+}
+
+template <typename T>
+T *RingPointer(void *ring, uint32_t offset) {
+    return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+
+}  // namespace
+
+bool PreadFile(int fd, std::string *content) {
+    content->clear();
+    char buf[kPreadChunkSize];
+    off_t offset = 0;
+    while (true) {
+        const ssize_t len = TEMP_FAILURE_RETRY(pread(fd, buf, sizeof(buf), offset));
+        if (len < 0) {
+            return false;
+        }
+        if (len == 0) {
+            return true;
+        }
+        content->append(buf, len);
+        offset += len;
+    }
+}
+
+IoUringReader::~IoUringReader() {
+    release();
+}
+
+bool IoUringReader::init(const std::vector<int> &fds, size_t read_size) {
+    std::lock_guard<std::mutex> _lock(mutex_);
+    release();
+    if (fds.empty() || !read_size) {
+        return false;
+    }
+
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    const unsigned int entries =
+            std::min(static_cast<unsigned int>(fds.size()), kMaxRingDepth);
+    ring_fd_ = IoUringSetup(entries, &params);
+    if (ring_fd_ < 0) {
+        PLOG(WARNING) << "io_uring is not available";
+        ring_fd_ = -1;
+        return false;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        PLOG(ERROR) << "Failed to map the io_uring submission ring";
+        release();
+        return false;
+    }
+    if (single_mmap) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring_fd_, IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            PLOG(ERROR) << "Failed to map the io_uring completion ring";
+            release();
+            return false;
+        }
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        PLOG(ERROR) << "Failed to map the io_uring submission entries";
+        release();
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+    sq_tail_ = RingPointer<unsigned int>(sq_ring_, params.sq_off.tail);
+    sq_mask_ = *RingPointer<unsigned int>(sq_ring_, params.sq_off.ring_mask);
+    sq_array_ = RingPointer<unsigned int>(sq_ring_, params.sq_off.array);
+    cq_head_ = RingPointer<unsigned int>(cq_ring_, params.cq_off.head);
+    cq_tail_ = RingPointer<unsigned int>(cq_ring_, params.cq_off.tail);
+    cq_mask_ = *RingPointer<unsigned int>(cq_ring_, params.cq_off.ring_mask);
+    cqes_ = RingPointer<io_uring_cqe>(cq_ring_, params.cq_off.cqes);
+    depth_ = std::min(params.sq_entries, params.cq_entries);
+
+    if (IoUringRegister(ring_fd_, IORING_REGISTER_FILES, fds.data(), fds.size()) < 0) {
+        PLOG(ERROR) << "Failed to register " << fds.size() << " files to io_uring";
+        release();
+        return false;
+    }
+    buffer_.assign(read_size * depth_, 0);
+    const iovec iov = {.iov_base = buffer_.data(), .iov_len = buffer_.size()};
+    if (IoUringRegister(ring_fd_, IORING_REGISTER_BUFFERS, &iov, 1) < 0) {
+        PLOG(ERROR) << "Failed to register the io_uring read buffer";
+        release();
+        return false;
+    }
+    file_count_ = fds.size();
+    read_size_ = read_size;
+    LOG(INFO) << "io_uring reader registered " << file_count_ << " files, depth " << depth_;
+    return true;
+}
+
+void IoUringReader::release() {
+    if (sqes_ != nullptr) {
+        munmap(sqes_, sqes_size_);
+        sqes_ = nullptr;
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    cq_ring_ = nullptr;
+    if (sq_ring_ != nullptr) {
+        munmap(sq_ring_, sq_ring_size_);
+        sq_ring_ = nullptr;
+    }
+    if (ring_fd_ != -1) {
+        close(ring_fd_);
+        ring_fd_ = -1;
+    }
+    buffer_.clear();
+    file_count_ = 0;
+    depth_ = 0;
+}
+
+bool IoUringReader::read(const std::vector<size_t> &file_indices,
+                         std::vector<std::string> *contents) {
+    std::lock_guard<std::mutex> _lock(mutex_);
+    contents->assign(file_indices.size(), std::string());
+    if (ring_fd_ == -1) {
+        return false;
+    }
+    for (const auto file_index : file_indices) {
+        if (file_index >= file_count_) {
+            LOG(ERROR) << "Invalid io_uring file index " << file_index;
+            return false;
+        }
+    }
+
+    ATRACE_CALL();
+    for (size_t batch_start = 0; batch_start < file_indices.size(); batch_start += depth_) {
+        const unsigned int count = static_cast<unsigned int>(
+                std::min<size_t>(depth_, file_indices.size() - batch_start));
+        unsigned int tail = *sq_tail_;
+        for (unsigned int slot = 0; slot < count; ++slot) {
+            const size_t file_index = file_indices[batch_start + slot];
+            const unsigned int sq_index = tail & sq_mask_;
+            io_uring_sqe *sqe = &sqes_[sq_index];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_READ_FIXED;
+            sqe->flags = IOSQE_FIXED_FILE;
+            sqe->fd = static_cast<int>(file_index);
+            sqe->addr = reinterpret_cast<uint64_t>(buffer_.data() + slot * read_size_);
+            sqe->len = static_cast<uint32_t>(read_size_);
+            sqe->off = 0;
+            sqe->buf_index = 0;
+            sqe->user_data = slot;
+            sq_array_[sq_index] = sq_index;
+            tail++;
+        }
+        // Publish the entries before the kernel reads the tail
+        __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+        if (!submitAndWait(count)) {
+            // The ring state is unknown, the files are read with pread from now on
+            release();
+            return false;
+        }
+
+        unsigned int head = *cq_head_;
+        const unsigned int cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        for (; head != cq_tail; ++head) {
+            const io_uring_cqe &cqe = cqes_[head & cq_mask_];
+            const size_t slot = static_cast<size_t>(cqe.user_data);
+            // A full buffer may be a truncated read, left to pread
+            if (slot < count && cqe.res > 0 && static_cast<size_t>(cqe.res) < read_size_) {
+                (*contents)[batch_start + slot].assign(buffer_.data() + slot * read_size_,
+                                                       cqe.res);
+            }
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+bool IoUringReader::submitAndWait(unsigned int count) {
+    // Usually a single syscall submits the batch and waits for all of its completions
+    unsigned int submitted = 0;
+    while (true) {
+        const unsigned int ready = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE) - *cq_head_;
+        if (submitted == count && ready >= count) {
+            return true;
+        }
+        const int ret = IoUringEnter(ring_fd_, count - submitted, count - ready,
+                                     IORING_ENTER_GETEVENTS);
+        if (ret < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            PLOG(ERROR) << "Failed to run the io_uring reads";
+            return false;
+        }
+        submitted += ret;
+    }
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <linux/io_uring.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+// Read a whole file from offset 0 with pread, the file stays open between reads
+bool PreadFile(int fd, std::string *content);
+
+// Batched reads of a fixed set of files through io_uring. The files and the read buffers are
+// registered to the ring once, so a batch is a single submission with no per file setup. The
+// ring is driven with raw syscalls, liburing is not available to vendor.
+class IoUringReader {
+  public:
+    IoUringReader() = default;
+    ~IoUringReader();
+    // Disallow copy and assign
+    IoUringReader(const IoUringReader &) = delete;
+    void operator=(const IoUringReader &) = delete;
+
+    // Set up the ring for the files, each read up to read_size bytes. Return false if io_uring
+    // is not available, the reader then stays disabled.
+    bool init(const std::vector<int> &fds, size_t read_size);
+    bool isEnabled() const { return ring_fd_ != -1; }
+    // Read the files of the given registration indices from offset 0. A read which failed or
+    // filled its whole buffer leaves its content empty, for the caller to read it again with
+    // pread. Return false if the batch could not be run at all.
+    bool read(const std::vector<size_t> &file_indices, std::vector<std::string> *contents);
+
+  private:
+    void release();
+    // Submit the prepared entries and wait for all of their completions
+    bool submitAndWait(unsigned int count);
+
+    std::mutex mutex_;
+    int ring_fd_ = -1;
+    size_t file_count_ = 0;
+    size_t read_size_ = 0;
+    unsigned int depth_ = 0;
+    // The mapped rings, the completion ring may share the submission ring mapping
+    void *sq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    void *cq_ring_ = nullptr;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe *sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+    unsigned int *sq_tail_ = nullptr;
+    unsigned int sq_mask_ = 0;
+    unsigned int *sq_array_ = nullptr;
+    unsigned int *cq_head_ = nullptr;
+    unsigned int *cq_tail_ = nullptr;
+    unsigned int cq_mask_ = 0;
+    io_uring_cqe *cqes_ = nullptr;
+    // One read_size_ slot per ring entry, registered as a single fixed buffer
+    std::vector<char> buffer_;
+};
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -14,8 +14,13 @@
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <utils/Trace.h>
 
+#include <cmath>
+#include <functional>
+#include <iterator>
+
 namespace aidl {
 namespace android {
 namespace hardware {
@@ -25,6 +30,8 @@ namespace implementation {
 constexpr std::string_view kDeviceType("iio:device");
 constexpr std::string_view kIioRootDir("/sys/bus/iio/devices");
 constexpr std::string_view kEnergyValueNode("energy_value");
+// Largest energy source content read in a batch, a longer one is read again with pread
+constexpr size_t kEnergyBatchReadSize = 4096;
 
 using ::android::base::ReadFileToString;
 using ::android::base::StringPrintf;
@@ -67,7 +74,7 @@ bool PowerFiles::registerPowerRailsToWatch(const Json::Value &config) {
         return false;
     }
 
-    if (!energy_info_map_.size() && !updateEnergyValues()) {
+    if (!energy_info_map_.size() && !updateEnergyValues(energy_path_set_)) {
         LOG(ERROR) << "Faield to update energy info";
         return false;
     }
@@ -79,33 +86,32 @@ bool PowerFiles::registerPowerRailsToWatch(const Json::Value &config) {
             continue;
         }
 
-        PowerSample power_sample = {
-                .energy_counter = 0,
-                .duration = 0,
-        };
-
         if (power_rail_info_pair.second.virtual_power_rail_info != nullptr &&
             power_rail_info_pair.second.virtual_power_rail_info->linked_power_rails.size()) {
             for (size_t i = 0;
                  i < power_rail_info_pair.second.virtual_power_rail_info->linked_power_rails.size();
                  ++i) {
-                if (!energy_info_map_.count(power_rail_info_pair.second.virtual_power_rail_info
-                                                    ->linked_power_rails[i])) {
-                    LOG(ERROR) << " Could not find energy source "
-                               << power_rail_info_pair.second.virtual_power_rail_info
-                                          ->linked_power_rails[i];
+                const auto &linked_power_rail =
+                        power_rail_info_pair.second.virtual_power_rail_info->linked_power_rails[i];
+                power_history.emplace_back(std::queue<PowerSample>());
+                // A linked power rail shares its own history and average power
+                if (power_rail_info_map_.count(linked_power_rail)) {
+                    continue;
+                }
+                if (!energy_info_map_.count(linked_power_rail)) {
+                    LOG(ERROR) << " Could not find energy source " << linked_power_rail;
                     return false;
                 }
-                power_history.emplace_back(std::queue<PowerSample>());
+                // Seeded with the current reading, the first refresh already averages the power
                 for (int j = 0; j < power_rail_info_pair.second.power_sample_count; j++) {
-                    power_history[i].emplace(power_sample);
+                    power_history[i].emplace(energy_info_map_.at(linked_power_rail));
                 }
             }
         } else {
             if (energy_info_map_.count(power_rail_info_pair.first)) {
                 power_history.emplace_back(std::queue<PowerSample>());
                 for (int j = 0; j < power_rail_info_pair.second.power_sample_count; j++) {
-                    power_history[0].emplace(power_sample);
+                    power_history[0].emplace(energy_info_map_.at(power_rail_info_pair.first));
                 }
             } else {
                 LOG(ERROR) << "Could not find energy source " << power_rail_info_pair.first;
@@ -126,11 +132,231 @@ bool PowerFiles::registerPowerRailsToWatch(const Json::Value &config) {
         LOG(INFO) << "Successfully to register power rail " << power_rail_info_pair.first;
     }
 
+    if (!computePowerRailUpdateOrder()) {
+        LOG(ERROR) << "Failed to order the power rails";
+        return false;
+    }
+
     power_status_log_ = {.prev_log_time = boot_clock::now(),
                          .prev_energy_info_map = energy_info_map_};
     return true;
 }
 
+void PowerFiles::registerPowerRailConsumers(
+        const std::unordered_map<std::string, SensorInfo> &sensor_info_map) {
+    permanent_power_rail_set_.clear();
+    power_rail_consumer_map_.clear();
+    for (const auto &[sensor_name, sensor_info] : sensor_info_map) {
+        // A virtual sensor fusing ODPM reads the power of its rails on each of its updates
+        if (sensor_info.virtual_sensor_info != nullptr) {
+            const auto &virtual_sensor_info = *sensor_info.virtual_sensor_info;
+            for (size_t i = 0; i < virtual_sensor_info.linked_sensors.size(); ++i) {
+                if (virtual_sensor_info.linked_sensors_type[i] == SensorFusionType::ODPM &&
+                    power_status_map_.count(virtual_sensor_info.linked_sensors[i])) {
+                    permanent_power_rail_set_.insert(virtual_sensor_info.linked_sensors[i]);
+                }
+                if (virtual_sensor_info.coefficients_type[i] == SensorFusionType::ODPM &&
+                    power_status_map_.count(virtual_sensor_info.coefficients[i])) {
+                    permanent_power_rail_set_.insert(virtual_sensor_info.coefficients[i]);
+                }
+            }
+        }
+        if (sensor_info.throttling_info == nullptr) {
+            continue;
+        }
+        std::unordered_set<std::string> power_rails;
+        bool is_predictive = false;
+        for (const auto &excluded_power_info_pair :
+             sensor_info.throttling_info->excluded_power_info_map) {
+            power_rails.insert(excluded_power_info_pair.first);
+        }
+        for (const auto &binded_cdev_info_pair :
+             sensor_info.throttling_info->binded_cdev_info_map) {
+            power_rails.insert(binded_cdev_info_pair.second.power_rail);
+            is_predictive |=
+                    binded_cdev_info_pair.second.release_logic == ReleaseLogic::PREDICTIVE;
+        }
+        for (const auto &[profile, binded_cdev_info_map] :
+             sensor_info.throttling_info->profile_map) {
+            for (const auto &binded_cdev_info_pair : binded_cdev_info_map) {
+                is_predictive |=
+                        binded_cdev_info_pair.second.release_logic == ReleaseLogic::PREDICTIVE;
+            }
+        }
+        for (const auto &power_rail : power_rails) {
+            if (!power_status_map_.count(power_rail)) {
+                continue;
+            }
+            // The forecast a PREDICTIVE release follows needs the power trend before throttling
+            if (is_predictive) {
+                permanent_power_rail_set_.insert(power_rail);
+            } else {
+                power_rail_consumer_map_[sensor_name].push_back(power_rail);
+            }
+        }
+    }
+    // A reload keeps the demand of the sensors still consuming power rails
+    for (auto it = power_rail_demand_set_.begin(); it != power_rail_demand_set_.end();) {
+        it = power_rail_consumer_map_.count(*it) ? std::next(it) : power_rail_demand_set_.erase(it);
+    }
+    updatePowerRailDemand();
+    LOG(INFO) << "Power rails sampled permanently: " << permanent_power_rail_set_.size()
+              << ", on throttling: " << power_rail_consumer_map_.size() << " sensors";
+}
+
+void PowerFiles::setPowerRailDemand(std::string_view sensor_name, bool needed) {
+    if (!power_rail_consumer_map_.count(sensor_name.data())) {
+        return;
+    }
+    const bool changed = needed ? power_rail_demand_set_.emplace(sensor_name).second
+                                : power_rail_demand_set_.erase(sensor_name.data()) > 0;
+    if (changed) {
+        updatePowerRailDemand();
+    }
+}
+
+void PowerFiles::updatePowerRailDemand(void) {
+    std::unordered_set<std::string> power_rails;
+    std::unordered_set<std::string> energy_paths;
+    for (const auto &power_rail : permanent_power_rail_set_) {
+        addPowerRailDemand(power_rail, &power_rails, &energy_paths);
+    }
+    for (const auto &sensor_name : power_rail_demand_set_) {
+        for (const auto &power_rail : power_rail_consumer_map_.at(sensor_name)) {
+            addPowerRailDemand(power_rail, &power_rails, &energy_paths);
+        }
+    }
+
+    // The samples of an idle power rail are stale, its history restarts once needed again and
+    // its power is unknown meanwhile
+    {
+        std::unique_lock<std::shared_mutex> _lock(power_status_map_mutex_);
+        for (const auto &power_rail : demanded_power_rail_set_) {
+            if (!power_rails.count(power_rail)) {
+                power_status_map_.at(power_rail).last_updated_avg_power = NAN;
+                power_rail_reset_set_.erase(power_rail);
+            }
+        }
+    }
+    for (const auto &power_rail : power_rails) {
+        if (!demanded_power_rail_set_.count(power_rail)) {
+            power_rail_reset_set_.insert(power_rail);
+        }
+    }
+    LOG(VERBOSE) << "Power rails needed: " << power_rails.size()
+                 << ", energy sources: " << energy_paths.size();
+    demanded_power_rail_set_ = std::move(power_rails);
+    demanded_energy_path_set_ = std::move(energy_paths);
+}
+
+void PowerFiles::resetPowerStatus(void) {
+    const auto now = boot_clock::now();
+    std::unique_lock<std::shared_mutex> _lock(power_status_map_mutex_);
+    for (const auto &power_rail : power_rail_reset_set_) {
+        const auto &power_rail_info = power_rail_info_map_.at(power_rail);
+        auto &power_status = power_status_map_.at(power_rail);
+        for (size_t i = 0; i < power_status.power_history.size(); ++i) {
+            // A linked power rail keeps an empty queue
+            if (power_status.power_history[i].empty()) {
+                continue;
+            }
+            const auto &energy_channel =
+                    (power_rail_info.virtual_power_rail_info == nullptr)
+                            ? power_rail
+                            : power_rail_info.virtual_power_rail_info->linked_power_rails[i];
+            const auto energy_info_it = energy_info_map_.find(energy_channel);
+            if (energy_info_it == energy_info_map_.end()) {
+                continue;
+            }
+            power_status.power_history[i] = std::queue<PowerSample>();
+            for (int j = 0; j < power_rail_info.power_sample_count; j++) {
+                power_status.power_history[i].emplace(energy_info_it->second);
+            }
+        }
+        // Averaged from the fresh samples once the sample delay has passed
+        power_status.last_update_time = now;
+        power_status.last_updated_avg_power = NAN;
+    }
+    power_rail_reset_set_.clear();
+}
+
+void PowerFiles::addPowerRailDemand(const std::string &power_rail,
+                                    std::unordered_set<std::string> *power_rails,
+                                    std::unordered_set<std::string> *energy_paths) const {
+    if (!power_rails->insert(power_rail).second) {
+        return;
+    }
+    const auto &power_rail_info = power_rail_info_map_.at(power_rail);
+    std::vector<std::string> energy_channels;
+    if (power_rail_info.virtual_power_rail_info == nullptr) {
+        energy_channels.push_back(power_rail);
+    } else {
+        for (const auto &linked_power_rail :
+             power_rail_info.virtual_power_rail_info->linked_power_rails) {
+            if (power_status_map_.count(linked_power_rail)) {
+                addPowerRailDemand(linked_power_rail, power_rails, energy_paths);
+            } else {
+                energy_channels.push_back(linked_power_rail);
+            }
+        }
+    }
+    for (const auto &energy_channel : energy_channels) {
+        const auto energy_source_it = energy_source_map_.find(energy_channel);
+        if (energy_source_it != energy_source_map_.end()) {
+            energy_paths->insert(energy_source_it->second);
+        }
+    }
+}
+
+bool PowerFiles::computePowerRailUpdateOrder(void) {
+    enum class VisitState { VISITING, VISITED };
+    std::unordered_map<std::string, VisitState> visit_state_map;
+    power_rail_update_order_.clear();
+
+    // Depth first post order, a linked rail is appended before the rails linking it
+    std::function<bool(const std::string &)> visit = [&](const std::string &power_rail) {
+        const auto it = visit_state_map.find(power_rail);
+        if (it != visit_state_map.end()) {
+            if (it->second == VisitState::VISITING) {
+                LOG(ERROR) << "Power rail " << power_rail << " is linked in a cycle";
+                return false;
+            }
+            return true;
+        }
+        visit_state_map[power_rail] = VisitState::VISITING;
+        const auto &power_rail_info = power_rail_info_map_.at(power_rail);
+        if (power_rail_info.virtual_power_rail_info != nullptr) {
+            for (const auto &linked_power_rail :
+                 power_rail_info.virtual_power_rail_info->linked_power_rails) {
+                if (!power_rail_info_map_.count(linked_power_rail)) {
+                    continue;
+                }
+                if (!power_status_map_.count(linked_power_rail)) {
+                    LOG(ERROR) << "Power rail " << power_rail << " links " << linked_power_rail
+                               << " which is not watched";
+                    return false;
+                }
+                if (!visit(linked_power_rail)) {
+                    return false;
+                }
+            }
+        }
+        visit_state_map[power_rail] = VisitState::VISITED;
+        if (power_status_map_.count(power_rail)) {
+            power_rail_update_order_.emplace_back(power_rail);
+        }
+        return true;
+    };
+
+    for (const auto &power_rail_info_pair : power_rail_info_map_) {
+        if (!visit(power_rail_info_pair.first)) {
+            power_rail_update_order_.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
 bool PowerFiles::findEnergySourceToWatch(void) {
     std::string devicePath;
 
@@ -154,8 +380,14 @@ bool PowerFiles::findEnergySourceToWatch(void) {
             if (!ReadFileToString(StringPrintf("%s/%s", devicePath.data(), kEnergyValueNode.data()),
                                   &deviceEnergyContent)) {
             } else if (deviceEnergyContent.size()) {
-                energy_path_set_.emplace(
-                        StringPrintf("%s/%s", devicePath.data(), kEnergyValueNode.data()));
+                const auto energy_path =
+                        StringPrintf("%s/%s", devicePath.data(), kEnergyValueNode.data());
+                energy_path_set_.emplace(energy_path);
+                ::android::base::unique_fd fd(
+                        TEMP_FAILURE_RETRY(open(energy_path.c_str(), O_RDONLY | O_CLOEXEC)));
+                if (fd != -1) {
+                    energy_fd_map_.emplace(energy_path, std::move(fd));
+                }
             }
         }
     }
@@ -167,58 +399,112 @@ bool PowerFiles::findEnergySourceToWatch(void) {
     return true;
 }
 
-bool PowerFiles::updateEnergyValues(void) {
-    std::string deviceEnergyContent;
-    std::string deviceEnergyContents;
-    std::string line;
+bool PowerFiles::enableBatchRead(void) {
+    std::vector<int> fds;
+    fds.reserve(energy_fd_map_.size());
+    energy_batch_index_map_.clear();
+    for (const auto &[path, fd] : energy_fd_map_) {
+        energy_batch_index_map_.emplace(path, fds.size());
+        fds.emplace_back(fd.get());
+    }
+    if (!energy_reader_.init(fds, kEnergyBatchReadSize)) {
+        energy_batch_index_map_.clear();
+        return false;
+    }
+    return true;
+}
 
-    ATRACE_CALL();
-    for (const auto &path : energy_path_set_) {
-        if (!::android::base::ReadFileToString(path, &deviceEnergyContent)) {
+bool PowerFiles::readEnergyContents(const std::unordered_set<std::string> &energy_paths,
+                                    std::vector<std::string> *contents) {
+    contents->assign(energy_paths.size(), std::string());
+    std::vector<size_t> batch_indices;
+    std::vector<size_t> batch_slots;
+    size_t slot = 0;
+    for (const auto &path : energy_paths) {
+        const auto index_it = energy_batch_index_map_.find(path);
+        if (index_it != energy_batch_index_map_.end()) {
+            batch_indices.emplace_back(index_it->second);
+            batch_slots.emplace_back(slot);
+        }
+        slot++;
+    }
+    std::vector<std::string> batch_contents;
+    if (batch_indices.size() && energy_reader_.read(batch_indices, &batch_contents)) {
+        for (size_t i = 0; i < batch_slots.size(); ++i) {
+            (*contents)[batch_slots[i]] = std::move(batch_contents[i]);
+            countSysfsOp();
+        }
+    }
+
+    // The sources out of the batch, or whose batch read failed
+    slot = 0;
+    for (const auto &path : energy_paths) {
+        auto &content = (*contents)[slot++];
+        if (content.size()) {
+            continue;
+        }
+        const auto fd_it = energy_fd_map_.find(path);
+        countSysfsOp();
+        const bool is_read = (fd_it != energy_fd_map_.end())
+                                     ? PreadFile(fd_it->second.get(), &content)
+                                     : ReadFileToString(path, &content);
+        if (!is_read) {
             LOG(ERROR) << "Failed to read energy content from " << path;
             return false;
-        } else {
-            deviceEnergyContents.append(deviceEnergyContent);
         }
     }
+    return true;
+}
 
-    std::istringstream energyData(deviceEnergyContents);
+bool PowerFiles::updateEnergyValues(const std::unordered_set<std::string> &energy_paths) {
+    std::vector<std::string> energy_contents;
+    std::string line;
 
-    while (std::getline(energyData, line)) {
-        /* Read rail energy */
-        uint64_t energy_counter = 0;
-        uint64_t duration = 0;
+    ATRACE_CALL();
+    if (!readEnergyContents(energy_paths, &energy_contents)) {
+        return false;
+    }
+    size_t slot = 0;
+    for (const auto &path : energy_paths) {
+        std::istringstream energyData(energy_contents[slot++]);
+
+        while (std::getline(energyData, line)) {
+            /* Read rail energy */
+            uint64_t energy_counter = 0;
+            uint64_t duration = 0;
+
+            /* Format example: CH3(T=358356)[S2M_VDD_CPUCL2], 761330 */
+            auto start_pos = line.find("T=");
+            auto end_pos = line.find(')');
+            if (start_pos != std::string::npos) {
+                duration = strtoul(line.substr(start_pos + 2, end_pos - start_pos - 2).c_str(),
+                                   NULL, 10);
+            } else {
+                continue;
+            }
 
-        /* Format example: CH3(T=358356)[S2M_VDD_CPUCL2], 761330 */
-        auto start_pos = line.find("T=");
-        auto end_pos = line.find(')');
-        if (start_pos != std::string::npos) {
-            duration =
-                    strtoul(line.substr(start_pos + 2, end_pos - start_pos - 2).c_str(), NULL, 10);
-        } else {
-            continue;
-        }
+            start_pos = line.find(")[");
+            end_pos = line.find(']');
+            std::string railName;
+            if (start_pos != std::string::npos) {
+                railName = line.substr(start_pos + 2, end_pos - start_pos - 2);
+            } else {
+                continue;
+            }
 
-        start_pos = line.find(")[");
-        end_pos = line.find(']');
-        std::string railName;
-        if (start_pos != std::string::npos) {
-            railName = line.substr(start_pos + 2, end_pos - start_pos - 2);
-        } else {
-            continue;
-        }
+            start_pos = line.find("],");
+            if (start_pos != std::string::npos) {
+                energy_counter = strtoul(line.substr(start_pos + 2).c_str(), NULL, 10);
+            } else {
+                continue;
+            }
 
-        start_pos = line.find("],");
-        if (start_pos != std::string::npos) {
-            energy_counter = strtoul(line.substr(start_pos + 2).c_str(), NULL, 10);
-        } else {
-            continue;
+            energy_info_map_[railName] = {
+                    .energy_counter = energy_counter,
+                    .duration = duration,
+            };
+            energy_source_map_[railName] = path;
         }
-
-        energy_info_map_[railName] = {
-                .energy_counter = energy_counter,
-                .duration = duration,
-        };
     }
 
     return true;
@@ -263,7 +549,7 @@ float PowerFiles::updatePowerRail(std::string_view power_rail) {
         return power_status.last_updated_avg_power;
     }
 
-    if (!energy_info_map_.size() && !updateEnergyValues()) {
+    if (!energy_info_map_.size() && !updateEnergyValues(energy_path_set_)) {
         LOG(ERROR) << "Failed to update energy values";
         return avg_power;
     }
@@ -276,9 +562,15 @@ float PowerFiles::updatePowerRail(std::string_view power_rail) {
         for (size_t i = 0; i < power_rail_info.virtual_power_rail_info->linked_power_rails.size();
              i++) {
             float coefficient = power_rail_info.virtual_power_rail_info->coefficients[i];
-            float avg_power_number = updateAveragePower(
-                    power_rail_info.virtual_power_rail_info->linked_power_rails[i],
-                    &power_status.power_history[i]);
+            const auto &linked_power_rail =
+                    power_rail_info.virtual_power_rail_info->linked_power_rails[i];
+            // A linked power rail has been updated earlier in this refresh
+            const auto linked_power_status_it = power_status_map_.find(linked_power_rail);
+            float avg_power_number =
+                    (linked_power_status_it != power_status_map_.end())
+                            ? linked_power_status_it->second.last_updated_avg_power
+                            : updateAveragePower(linked_power_rail,
+                                                 &power_status.power_history[i]);
 
             switch (power_rail_info.virtual_power_rail_info->formula) {
                 case FormulaOption::COUNT_THRESHOLD:
@@ -321,14 +613,39 @@ float PowerFiles::updatePowerRail(std::string_view power_rail) {
     return avg_power;
 }
 
+void PowerFiles::applyPowerRailTunables(
+        const std::unordered_map<std::string, PowerRailInfo> &power_rail_info_map) {
+    for (const auto &[power_rail, power_rail_info] : power_rail_info_map) {
+        auto it = power_rail_info_map_.find(power_rail);
+        if (it == power_rail_info_map_.end() || it->second.virtual_power_rail_info == nullptr ||
+            power_rail_info.virtual_power_rail_info == nullptr) {
+            continue;
+        }
+        auto &virtual_power_rail_info = *it->second.virtual_power_rail_info;
+        virtual_power_rail_info.coefficients =
+                power_rail_info.virtual_power_rail_info->coefficients;
+        virtual_power_rail_info.offset = power_rail_info.virtual_power_rail_info->offset;
+        virtual_power_rail_info.formula = power_rail_info.virtual_power_rail_info->formula;
+    }
+}
+
 bool PowerFiles::refreshPowerStatus(void) {
-    if (!updateEnergyValues()) {
+    // Only the iio devices hosting the needed power rails are read, none while nothing needs
+    // power
+    if (demanded_power_rail_set_.empty()) {
+        return true;
+    }
+
+    if (!updateEnergyValues(demanded_energy_path_set_)) {
         LOG(ERROR) << "Failed to update energy values";
         return false;
     }
+    resetPowerStatus();
 
-    for (const auto &power_status_pair : power_status_map_) {
-        updatePowerRail(power_status_pair.first);
+    for (const auto &power_rail : power_rail_update_order_) {
+        if (demanded_power_rail_set_.count(power_rail)) {
+            updatePowerRail(power_rail);
+        }
     }
     return true;
 }
@@ -339,6 +656,10 @@ void PowerFiles::logPowerStatus(const boot_clock::time_point &now) {
     uint64_t max_duration = 0;
     float tot_power = 0.0;
     std::string out;
+    // The refresh only samples the needed power rails, read all of them for the log
+    if (!updateEnergyValues(energy_path_set_)) {
+        LOG(ERROR) << "Failed to update energy values";
+    }
     for (const auto &energy_info_pair : energy_info_map_) {
         const auto &rail = energy_info_pair.first;
         if (!power_status_log_.prev_energy_info_map.count(rail)) {
@@ -346,8 +667,13 @@ void PowerFiles::logPowerStatus(const boot_clock::time_point &now) {
         }
         const auto &last_sample = power_status_log_.prev_energy_info_map.at(rail);
         const auto &curr_sample = energy_info_pair.second;
+        // The channel has not been sampled since the last log
+        if (curr_sample.duration == last_sample.duration) {
+            continue;
+        }
         float avg_power = NAN;
-        if (calculateAvgPower(rail, last_sample, curr_sample, &avg_power) && avg_power != NAN) {
+        if (calculateAvgPower(rail, last_sample, curr_sample, &avg_power) &&
+            !std::isnan(avg_power)) {
             // start of new line
             if (power_rail_log_cnt % kMaxPowerLogPerLine == 0) {
                 if (power_rail_log_cnt != 0) {
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <android-base/chrono_utils.h>
+#include <android-base/unique_fd.h>
 
 #include <chrono>
 #include <queue>
@@ -15,7 +16,9 @@
 #include <unordered_map>
 #include <unordered_set>
 
+#include "io_uring_reader.h"
 #include "thermal_info.h"
+#include "thermal_profiler.h"
 
 namespace aidl {
 namespace android {
@@ -32,7 +35,8 @@ struct PowerSample {
 
 struct PowerStatus {
     boot_clock::time_point last_update_time;
-    // A vector to record the queues of power sample history.
+    // A vector to record the queues of power sample history, per linked energy channel. The
+    // queue is empty for a linked power rail, whose average power is shared.
     std::vector<std::queue<PowerSample>> power_history;
     float last_updated_avg_power;
 };
@@ -51,8 +55,19 @@ class PowerFiles {
     // Disallow copy and assign.
     PowerFiles(const PowerFiles &) = delete;
     void operator=(const PowerFiles &) = delete;
+    // Count the energy source reads in the profile of the watcher ticks
+    void setProfiler(ThermalProfiler *profiler) { profiler_ = profiler; }
     bool registerPowerRailsToWatch(const Json::Value &config);
-    // Update the power data from ODPM sysfs
+    // Read the energy sources in one io_uring batch, return false if io_uring is not available
+    bool enableBatchRead(void);
+    // Register the watched power rails the sensors consume. The rails fused by virtual sensors,
+    // and the throttling rails of the sensors whose release follows the forecast, are always
+    // sampled. The other throttling rails are only sampled while their sensor needs them.
+    void registerPowerRailConsumers(
+            const std::unordered_map<std::string, SensorInfo> &sensor_info_map);
+    // Set whether the sensor needs its throttling power rails, i.e. it is throttling
+    void setPowerRailDemand(std::string_view sensor_name, bool needed);
+    // Update the power data of the needed power rails from ODPM sysfs
     bool refreshPowerStatus(void);
     // Log the power data for the duration
     void logPowerStatus(const boot_clock::time_point &now);
@@ -65,20 +80,48 @@ class PowerFiles {
         std::shared_lock<std::shared_mutex> _lock(power_status_map_mutex_);
         return power_status_map_;
     }
+    // Get a copy of the power status map
+    std::unordered_map<std::string, PowerStatus> GetPowerStatusSnapshot() const {
+        std::shared_lock<std::shared_mutex> _lock(power_status_map_mutex_);
+        return power_status_map_;
+    }
+    // Update the formula, coefficients and offset of the reloaded virtual power rails
+    void applyPowerRailTunables(
+            const std::unordered_map<std::string, PowerRailInfo> &power_rail_info_map);
     // Get power rail info map
     const std::unordered_map<std::string, PowerRailInfo> &GetPowerRailInfoMap() const {
         return power_rail_info_map_;
     }
 
   private:
-    // Update energy value to energy_info_map_, return false if the value is failed to update.
-    bool updateEnergyValues(void);
+    void countSysfsOp() const {
+        if (profiler_ != nullptr) {
+            profiler_->countSysfsOp();
+        }
+    }
+    // Read the content of the energy source paths, in the order of the set
+    bool readEnergyContents(const std::unordered_set<std::string> &energy_paths,
+                            std::vector<std::string> *contents);
+    // Update energy value to energy_info_map_ from the energy source paths, return false if the
+    // value is failed to update.
+    bool updateEnergyValues(const std::unordered_set<std::string> &energy_paths);
+    // Recompute the needed power rails and energy source paths from the consumers
+    void updatePowerRailDemand(void);
+    // Restart the sample history of the power rails which became needed again, from the
+    // energy just read
+    void resetPowerStatus(void);
+    // Add the power rail and the power rails and energy sources it links to the needed sets
+    void addPowerRailDemand(const std::string &power_rail,
+                            std::unordered_set<std::string> *power_rails,
+                            std::unordered_set<std::string> *energy_paths) const;
     // Compute the average power for physical power rail.
     float updateAveragePower(std::string_view power_rail, std::queue<PowerSample> *power_history);
     // Update the power data for the target power rail.
     float updatePowerRail(std::string_view power_rail);
     // Find the energy source path, return false if no energy source found.
     bool findEnergySourceToWatch(void);
+    // Order the power rails so that linked power rails come first, return false on a cycle.
+    bool computePowerRailUpdateOrder(void);
     // The map to record the energy counter for each power rail.
     std::unordered_map<std::string, PowerSample> energy_info_map_;
     // The map to record the power data for each thermal sensor.
@@ -86,9 +129,29 @@ class PowerFiles {
     mutable std::shared_mutex power_status_map_mutex_;
     // The map to record the power rail information from thermal config
     std::unordered_map<std::string, PowerRailInfo> power_rail_info_map_;
+    // The watched power rails in topological order, each rail is updated once per refresh
+    // after the power rails it links
+    std::vector<std::string> power_rail_update_order_;
     // The set to store the energy source paths
     std::unordered_set<std::string> energy_path_set_;
+    // The energy sources stay open between reads, and their io_uring registration index
+    std::unordered_map<std::string, ::android::base::unique_fd> energy_fd_map_;
+    std::unordered_map<std::string, size_t> energy_batch_index_map_;
+    IoUringReader energy_reader_;
+    // The map to record the energy source path of each energy channel
+    std::unordered_map<std::string, std::string> energy_source_map_;
+    // The power rails sampled whatever the severity
+    std::unordered_set<std::string> permanent_power_rail_set_;
+    // The throttling power rails of each sensor, and the sensors currently needing them
+    std::unordered_map<std::string, std::vector<std::string>> power_rail_consumer_map_;
+    std::unordered_set<std::string> power_rail_demand_set_;
+    // The needed power rails whose samples are stale, restarted on the next refresh
+    std::unordered_set<std::string> power_rail_reset_set_;
+    // The needed power rails and energy source paths, sampled on refresh
+    std::unordered_set<std::string> demanded_power_rail_set_;
+    std::unordered_set<std::string> demanded_energy_path_set_;
     PowerStatusLog power_status_log_;
+    ThermalProfiler *profiler_ = nullptr;
 };
 
 }  // namespace implementation
@@ -32,8 +32,24 @@ namespace implementation {
 using ::android::base::StringPrintf;
 
 PowerHalService::PowerHalService()
-    : power_hal_aidl_exist_(true), power_hal_aidl_(nullptr), power_hal_ext_aidl_(nullptr) {
+    : power_hal_aidl_exist_(true),
+      power_hal_aidl_(nullptr),
+      power_hal_ext_aidl_(nullptr),
+      pending_resend_(false),
+      hint_sender_aborted_(false) {
     connect();
+    hint_sender_thread_ = std::thread([this] { hintSenderLoop(); });
+}
+
+PowerHalService::~PowerHalService() {
+    {
+        std::lock_guard<std::mutex> lock(pending_hint_mutex_);
+        hint_sender_aborted_ = true;
+    }
+    pending_hint_cv_.notify_all();
+    if (hint_sender_thread_.joinable()) {
+        hint_sender_thread_.join();
+    }
 }
 
 bool PowerHalService::connect() {
@@ -95,6 +111,15 @@ bool PowerHalService::connect() {
 }
 
 void PowerHalService::reconnect() {
+    // Reconnecting blocks until power HAL is back, leave it to the sender thread
+    {
+        std::lock_guard<std::mutex> lock(pending_hint_mutex_);
+        pending_resend_ = true;
+    }
+    pending_hint_cv_.notify_all();
+}
+
+void PowerHalService::resendPowerExtHints() {
     ATRACE_CALL();
     if (!connect()) {
         LOG(ERROR) << " Failed to reconnect power_hal_ext";
@@ -103,13 +128,14 @@ void PowerHalService::reconnect() {
 
     LOG(INFO) << "Resend the power hints when power_hal_ext is reconnected";
     std::lock_guard<std::shared_mutex> _lock(powerhint_status_mutex_);
-    for (const auto &[sensor_name, supported_powerhint] : supported_powerhint_map_) {
+    for (auto &[sensor_name, supported_powerhint] : supported_powerhint_map_) {
         std::stringstream log_buf;
         for (const auto &severity : ::ndk::enum_range<ThrottlingSeverity>()) {
             bool mode = severity <= supported_powerhint.prev_hint_severity;
             setMode(sensor_name, severity, mode);
             log_buf << toString(severity).c_str() << ":" << mode << " ";
         }
+        supported_powerhint.is_synced = true;
 
         LOG(INFO) << sensor_name << " send powerhint: " << log_buf.str();
         log_buf.clear();
@@ -119,6 +145,8 @@ void PowerHalService::reconnect() {
 
 void PowerHalService::updateSupportedPowerHints(
         const std::unordered_map<std::string, SensorInfo> &sensor_info_map_) {
+    // The sender thread is already running
+    std::lock_guard<std::shared_mutex> _lock(powerhint_status_mutex_);
     for (auto const &name_status_pair : sensor_info_map_) {
         if (!(name_status_pair.second.send_powerhint)) {
             continue;
@@ -147,41 +175,95 @@ void PowerHalService::updateSupportedPowerHints(
 
 void PowerHalService::sendPowerExtHint(const Temperature &t) {
     ATRACE_CALL();
-    std::lock_guard<std::shared_mutex> _lock(powerhint_status_mutex_);
-    ThrottlingSeverity prev_hint_severity = supported_powerhint_map_[t.name].prev_hint_severity;
-    ThrottlingSeverity current_hint_severity =
-            supported_powerhint_map_[t.name].hint_severity_map[t.throttlingStatus];
-    std::stringstream log_buf;
+    {
+        std::lock_guard<std::mutex> lock(pending_hint_mutex_);
+        pending_hint_map_[t.name] = t.throttlingStatus;
+    }
+    pending_hint_cv_.notify_all();
+}
+
+void PowerHalService::hintSenderLoop() {
+    while (true) {
+        std::unordered_map<std::string, ThrottlingSeverity> hints;
+        bool resend = false;
+        {
+            std::unique_lock<std::mutex> lock(pending_hint_mutex_);
+            pending_hint_cv_.wait(lock, [this] {
+                return hint_sender_aborted_ || pending_resend_ || !pending_hint_map_.empty();
+            });
+            // Let the severity settle, only the latest one of each sensor will be sent
+            pending_hint_cv_.wait_for(lock, kPowerHintCoalesceWindowMs,
+                                      [this] { return hint_sender_aborted_; });
+            if (hint_sender_aborted_) {
+                return;
+            }
+            hints.swap(pending_hint_map_);
+            std::swap(resend, pending_resend_);
+        }
 
+        if (resend) {
+            resendPowerExtHints();
+        }
+        for (const auto &[sensor_name, severity] : hints) {
+            updatePowerExtHint(sensor_name, severity);
+        }
+    }
+}
+
+void PowerHalService::updatePowerExtHint(std::string_view sensor_name,
+                                         const ThrottlingSeverity severity) {
+    ATRACE_CALL();
+    std::lock_guard<std::shared_mutex> _lock(powerhint_status_mutex_);
     if (!power_hal_aidl_exist_) {
         LOG(ERROR) << "power_hal_aidl is not exist";
         return;
     }
 
-    if (prev_hint_severity == current_hint_severity) {
+    if (!supported_powerhint_map_.count(sensor_name.data())) {
+        return;
+    }
+
+    auto &powerhint_status = supported_powerhint_map_[sensor_name.data()];
+    const ThrottlingSeverity prev_hint_severity = powerhint_status.prev_hint_severity;
+    const ThrottlingSeverity current_hint_severity =
+            powerhint_status.hint_severity_map[severity];
+    std::stringstream log_buf;
+
+    if (powerhint_status.is_synced && prev_hint_severity == current_hint_severity) {
         return;
     }
 
-    for (const auto &severity : ::ndk::enum_range<ThrottlingSeverity>()) {
-        if (severity != supported_powerhint_map_[t.name].hint_severity_map[severity]) {
+    // Only the modes which flip are sent once the power HAL state is in sync
+    for (const auto &hint_severity : ::ndk::enum_range<ThrottlingSeverity>()) {
+        if (hint_severity != powerhint_status.hint_severity_map[hint_severity]) {
+            continue;
+        }
+        bool mode = hint_severity <= current_hint_severity;
+        if (powerhint_status.is_synced && mode == (hint_severity <= prev_hint_severity)) {
             continue;
         }
-        bool mode = severity <= current_hint_severity;
-        setMode(t.name, severity, mode);
-        log_buf << toString(severity).c_str() << ":" << mode << " ";
+        setMode(sensor_name.data(), hint_severity, mode);
+        log_buf << toString(hint_severity).c_str() << ":" << mode << " ";
     }
 
-    LOG(INFO) << t.name << " send powerhint: " << log_buf.str();
+    LOG(INFO) << sensor_name << " send powerhint: " << log_buf.str();
 
-    supported_powerhint_map_[t.name].prev_hint_severity = current_hint_severity;
+    powerhint_status.prev_hint_severity = current_hint_severity;
+    powerhint_status.is_synced = true;
 }
 
 bool PowerHalService::isModeSupported(const std::string &type, const ThrottlingSeverity &t) {
     bool isSupported = false;
+    std::string power_hint = StringPrintf("THERMAL_%s_%s", type.c_str(), toString(t).c_str());
+    {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (mode_supported_cache_.count(power_hint)) {
+            return mode_supported_cache_.at(power_hint);
+        }
+    }
     if (!connect()) {
         return false;
     }
-    std::string power_hint = StringPrintf("THERMAL_%s_%s", type.c_str(), toString(t).c_str());
     lock_.lock();
     if (!power_hal_ext_aidl_->isModeSupported(power_hint, &isSupported).isOk()) {
         LOG(ERROR) << "Fail to check supported mode, Hint: " << power_hint;
@@ -190,6 +272,7 @@ bool PowerHalService::isModeSupported(const std::string &type, const ThrottlingS
         lock_.unlock();
         return false;
     }
+    mode_supported_cache_[power_hint] = isSupported;
     lock_.unlock();
     return isSupported;
 }
@@ -12,9 +12,11 @@
 #include <aidl/google/hardware/power/extension/pixel/IPowerExt.h>
 #include <utils/Trace.h>
 
+#include <condition_variable>
 #include <queue>
 #include <shared_mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -31,15 +33,23 @@ using ::aidl::google::hardware::power::extension::pixel::IPowerExt;
 
 using CdevRequestStatus = std::unordered_map<std::string, int>;
 
+// Window to collapse the hint changes of the same sensor before sending them to power HAL
+constexpr std::chrono::milliseconds kPowerHintCoalesceWindowMs = std::chrono::milliseconds(100);
+
 struct PowerHintstatus {
     std::unordered_map<ThrottlingSeverity, ThrottlingSeverity> hint_severity_map;
     ThrottlingSeverity prev_hint_severity;
+    // Whether power HAL has received the full state of the hints
+    bool is_synced;
 };
 
 class PowerHalService {
   public:
     PowerHalService();
-    ~PowerHalService() = default;
+    ~PowerHalService();
+    // Disallow copy and assign.
+    PowerHalService(const PowerHalService &) = delete;
+    void operator=(const PowerHalService &) = delete;
     bool connect();
     void reconnect();
     bool isAidlPowerHalExist() { return power_hal_aidl_exist_; }
@@ -50,9 +60,16 @@ class PowerHalService {
                  const bool error_on_exit = false);
     void updateSupportedPowerHints(
             const std::unordered_map<std::string, SensorInfo> &sensor_info_map_);
+    // Queue the latest severity of the sensor, the hint is sent from the sender thread
     void sendPowerExtHint(const Temperature &t);
 
   private:
+    // Loop of the sender thread which delivers the queued hints to power HAL
+    void hintSenderLoop();
+    // Send the mode changes between the previous and the current hint severity
+    void updatePowerExtHint(std::string_view sensor_name, const ThrottlingSeverity severity);
+    // Resend all the hints after power HAL is reconnected
+    void resendPowerExtHints();
     ndk::ScopedAIBinder_DeathRecipient power_hal_ext_aidl_death_recipient_;
     static void onPowerHalExtAidlBinderDied(void *cookie) {
         if (cookie) {
@@ -72,6 +89,15 @@ class PowerHalService {
     std::mutex lock_;
     std::unordered_map<std::string, PowerHintstatus> supported_powerhint_map_;
     mutable std::shared_mutex powerhint_status_mutex_;
+    // The mode support result of each power hint from the first query
+    std::unordered_map<std::string, bool> mode_supported_cache_;
+    // The latest severity of each sensor which is not sent yet
+    std::unordered_map<std::string, ThrottlingSeverity> pending_hint_map_;
+    bool pending_resend_;
+    bool hint_sender_aborted_;
+    std::mutex pending_hint_mutex_;
+    std::condition_variable pending_hint_cv_;
+    std::thread hint_sender_thread_;
 };
 
 }  // namespace implementation
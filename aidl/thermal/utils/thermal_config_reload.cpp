@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "thermal_config_reload.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <tuple>
+
+#include "thermal_plan.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+namespace {
+
+constexpr std::string_view kSensorsSection("Sensors");
+constexpr std::string_view kCoolingDevicesSection("CoolingDevices");
+constexpr std::string_view kPowerRailsSection("PowerRails");
+
+using JsonIndex = std::unordered_map<std::string, const Json::Value *>;
+
+JsonIndex IndexSection(const Json::Value &config, std::string_view section) {
+    JsonIndex index;
+    const Json::Value &values = config[section.data()];
+    for (Json::Value::ArrayIndex i = 0; i < values.size(); ++i) {
+        index[values[i]["Name"].asString()] = &values[i];
+    }
+    return index;
+}
+
+template <typename T, typename U>
+bool HasSameKeys(const std::unordered_map<std::string, T> &a,
+                 const std::unordered_map<std::string, U> &b) {
+    return a.size() == b.size() && std::all_of(a.begin(), a.end(), [&b](const auto &pair) {
+               return b.count(pair.first);
+           });
+}
+
+// The throttling maps registered for a binding at init
+auto GetBindingRegistration(const BindedCdevInfo &binded_cdev_info) {
+    const bool has_pid = std::any_of(binded_cdev_info.cdev_weight_for_pid.begin(),
+                                     binded_cdev_info.cdev_weight_for_pid.end(),
+                                     [](float weight) { return !std::isnan(weight); });
+    const bool has_hard_limit =
+            std::any_of(binded_cdev_info.limit_info.begin(), binded_cdev_info.limit_info.end(),
+                        [](int limit) { return limit > 0; });
+    const bool has_release =
+            !binded_cdev_info.power_rail.empty() &&
+            std::any_of(binded_cdev_info.power_thresholds.begin(),
+                        binded_cdev_info.power_thresholds.end(),
+                        [](float threshold) { return !std::isnan(threshold); });
+    return std::make_tuple(has_pid, has_hard_limit, has_release);
+}
+
+void CheckBindingStructure(const std::string &prefix,
+                           const std::unordered_map<std::string, BindedCdevInfo> &live,
+                           const std::unordered_map<std::string, BindedCdevInfo> &reloaded,
+                           const bool check_registration, std::vector<std::string> *errors) {
+    if (!HasSameKeys(live, reloaded)) {
+        errors->push_back(prefix + "binded CDEVs changed");
+        return;
+    }
+    for (const auto &[cdev_name, binded_cdev_info] : live) {
+        const auto &reloaded_binded_cdev_info = reloaded.at(cdev_name);
+        if (binded_cdev_info.power_rail != reloaded_binded_cdev_info.power_rail) {
+            errors->push_back(prefix + "binded CDEV " + cdev_name + "'s power rail changed");
+        }
+        if (check_registration && GetBindingRegistration(binded_cdev_info) !=
+                                          GetBindingRegistration(reloaded_binded_cdev_info)) {
+            errors->push_back(prefix + "binded CDEV " + cdev_name +
+                              " enabled or disabled a throttling algorithm");
+        }
+    }
+}
+
+void CheckSensorStructure(const std::string &name, const SensorInfo &live,
+                          const SensorInfo &reloaded, std::vector<std::string> *errors) {
+    const std::string prefix = "Sensor[" + name + "]'s ";
+    if (live.type != reloaded.type) {
+        errors->push_back(prefix + "Type changed");
+    }
+    if (live.temp_path != reloaded.temp_path || live.zone_name != reloaded.zone_name) {
+        errors->push_back(prefix + "TempPath or ZoneName changed");
+    }
+    if (live.is_watch != reloaded.is_watch) {
+        errors->push_back(prefix + "monitoring changed");
+    }
+    if (live.send_powerhint != reloaded.send_powerhint) {
+        errors->push_back(prefix + "SendPowerHint changed");
+    }
+
+    if ((live.virtual_sensor_info == nullptr) != (reloaded.virtual_sensor_info == nullptr)) {
+        errors->push_back(prefix + "VirtualSensor changed");
+    } else if (live.virtual_sensor_info != nullptr) {
+        const auto &virtual_sensor_info = *live.virtual_sensor_info;
+        const auto &reloaded_virtual_sensor_info = *reloaded.virtual_sensor_info;
+        if (virtual_sensor_info.linked_sensors != reloaded_virtual_sensor_info.linked_sensors ||
+            virtual_sensor_info.linked_sensors_type !=
+                    reloaded_virtual_sensor_info.linked_sensors_type) {
+            errors->push_back(prefix + "Combination changed");
+        }
+        // A non constant coefficient is the name of the sensor or rail it is read from
+        bool same_coefficient_links = virtual_sensor_info.coefficients_type ==
+                                      reloaded_virtual_sensor_info.coefficients_type;
+        for (size_t i = 0; same_coefficient_links && i < virtual_sensor_info.coefficients.size();
+             ++i) {
+            same_coefficient_links =
+                    virtual_sensor_info.coefficients_type[i] == SensorFusionType::CONSTANT ||
+                    virtual_sensor_info.coefficients[i] ==
+                            reloaded_virtual_sensor_info.coefficients[i];
+        }
+        if (!same_coefficient_links) {
+            errors->push_back(prefix + "Coefficient links changed");
+        }
+        if (virtual_sensor_info.trigger_sensors != reloaded_virtual_sensor_info.trigger_sensors) {
+            errors->push_back(prefix + "TriggerSensor changed");
+        }
+        if (virtual_sensor_info.formula != reloaded_virtual_sensor_info.formula ||
+            virtual_sensor_info.vt_estimator_model_file !=
+                    reloaded_virtual_sensor_info.vt_estimator_model_file) {
+            errors->push_back(prefix + "Formula or ModelPath changed");
+        }
+    }
+
+    if ((live.throttling_info == nullptr) != (reloaded.throttling_info == nullptr)) {
+        errors->push_back(prefix + "throttling was enabled or disabled");
+    } else if (live.throttling_info != nullptr) {
+        const auto &throttling_info = *live.throttling_info;
+        const auto &reloaded_throttling_info = *reloaded.throttling_info;
+        CheckBindingStructure(prefix, throttling_info.binded_cdev_info_map,
+                              reloaded_throttling_info.binded_cdev_info_map, true, errors);
+        if (!HasSameKeys(throttling_info.excluded_power_info_map,
+                         reloaded_throttling_info.excluded_power_info_map)) {
+            errors->push_back(prefix + "excluded power rails changed");
+        }
+        if (!HasSameKeys(throttling_info.profile_map, reloaded_throttling_info.profile_map)) {
+            errors->push_back(prefix + "profiles changed");
+        } else {
+            for (const auto &[profile, binded_cdev_info_map] : throttling_info.profile_map) {
+                CheckBindingStructure(prefix + "profile " + profile + " ", binded_cdev_info_map,
+                                      reloaded_throttling_info.profile_map.at(profile), false,
+                                      errors);
+            }
+        }
+    }
+}
+
+void CheckCdevStructure(const std::string &name, const CdevInfo &live, const CdevInfo &reloaded,
+                        std::vector<std::string> *errors) {
+    const std::string prefix = "CoolingDevice[" + name + "]'s ";
+    if (live.type != reloaded.type) {
+        errors->push_back(prefix + "Type changed");
+    }
+    if (live.read_path != reloaded.read_path || live.write_path != reloaded.write_path ||
+        live.freq_domain != reloaded.freq_domain || live.hal_owned != reloaded.hal_owned) {
+        errors->push_back(prefix + "paths or HalOwned changed");
+    }
+    // The table size is checked against the max state of the device at init
+    if (live.state2power.size() != reloaded.state2power.size()) {
+        errors->push_back(prefix + "State2Power size changed");
+    }
+}
+
+void CheckPowerRailStructure(const std::string &name, const PowerRailInfo &live,
+                             const PowerRailInfo &reloaded, std::vector<std::string> *errors) {
+    const std::string prefix = "PowerRail[" + name + "]'s ";
+    if (live.power_sample_count != reloaded.power_sample_count ||
+        live.power_sample_delay != reloaded.power_sample_delay) {
+        errors->push_back(prefix + "power sampling changed");
+    }
+    if ((live.virtual_power_rail_info == nullptr) !=
+                (reloaded.virtual_power_rail_info == nullptr) ||
+        (live.virtual_power_rail_info != nullptr &&
+         live.virtual_power_rail_info->linked_power_rails !=
+                 reloaded.virtual_power_rail_info->linked_power_rails)) {
+        errors->push_back(prefix + "Combination changed");
+    }
+}
+
+// Move the entities whose config changed into the reload, after checking their structure
+template <typename T>
+void DiffSection(const Json::Value &live_config, const Json::Value &config,
+                 std::string_view section, const std::unordered_map<std::string, T> &live,
+                 std::unordered_map<std::string, T> *reloaded,
+                 void (*check_structure)(const std::string &, const T &, const T &,
+                                         std::vector<std::string> *),
+                 std::unordered_map<std::string, T> *changed, std::vector<std::string> *errors) {
+    if (!HasSameKeys(live, *reloaded)) {
+        errors->push_back(std::string(section) + " were added or removed");
+        return;
+    }
+    const auto live_index = IndexSection(live_config, section);
+    const auto index = IndexSection(config, section);
+    for (auto &[name, info] : *reloaded) {
+        const auto live_it = live_index.find(name);
+        const auto it = index.find(name);
+        if (live_it != live_index.end() && it != index.end() && *live_it->second == *it->second) {
+            continue;
+        }
+        const size_t error_count = errors->size();
+        check_structure(name, live.at(name), info, errors);
+        if (errors->size() == error_count) {
+            (*changed)[name] = std::move(info);
+        }
+    }
+}
+
+}  // namespace
+
+bool PrepareConfigReload(const Json::Value &live_config, const Json::Value &config,
+                         const std::unordered_map<std::string, SensorInfo> &sensor_info_map,
+                         const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map,
+                         const std::unordered_map<std::string, PowerRailInfo> &power_rail_info_map,
+                         ConfigReload *reload, std::vector<std::string> *errors) {
+    const size_t error_count = errors->size();
+    std::set<std::string> sections;
+    for (const auto &section : live_config.getMemberNames()) {
+        sections.insert(section);
+    }
+    for (const auto &section : config.getMemberNames()) {
+        sections.insert(section);
+    }
+    for (const auto &section : sections) {
+        if (section != kSensorsSection && section != kCoolingDevicesSection &&
+            section != kPowerRailsSection && live_config[section] != config[section]) {
+            errors->push_back(section + " changed");
+        }
+    }
+
+    const size_t parse_error_count = errors->size();
+    std::unordered_map<std::string, SensorInfo> reloaded_sensor_info_map;
+    std::unordered_map<std::string, CdevInfo> reloaded_cooling_device_info_map;
+    std::unordered_map<std::string, PowerRailInfo> reloaded_power_rail_info_map;
+    if (!ParseCoolingDevice(config, &reloaded_cooling_device_info_map)) {
+        errors->push_back("Failed to parse CoolingDevices");
+    }
+    if (!ParseSensorInfo(config, &reloaded_sensor_info_map)) {
+        errors->push_back("Failed to parse Sensors");
+    }
+    if (!ParsePowerRailInfo(config, &reloaded_power_rail_info_map)) {
+        errors->push_back("Failed to parse PowerRails");
+    }
+    if (errors->size() != parse_error_count) {
+        return false;
+    }
+    ControlPlan plan;
+    if (!CompileControlPlan(reloaded_sensor_info_map, reloaded_cooling_device_info_map,
+                            reloaded_power_rail_info_map, &plan, errors)) {
+        return false;
+    }
+    // The trigger sensors of the watched sensors are watched, as at init
+    for (const auto &[name, sensor_info] : reloaded_sensor_info_map) {
+        if (sensor_info.virtual_sensor_info == nullptr || !sensor_info.is_watch) {
+            continue;
+        }
+        for (const auto &trigger_sensor : sensor_info.virtual_sensor_info->trigger_sensors) {
+            reloaded_sensor_info_map.at(trigger_sensor).is_watch = true;
+        }
+    }
+
+    *reload = {};
+    DiffSection(live_config, config, kSensorsSection, sensor_info_map, &reloaded_sensor_info_map,
+                &CheckSensorStructure, &reload->sensor_info_map, errors);
+    DiffSection(live_config, config, kCoolingDevicesSection, cooling_device_info_map,
+                &reloaded_cooling_device_info_map, &CheckCdevStructure,
+                &reload->cooling_device_info_map, errors);
+    DiffSection(live_config, config, kPowerRailsSection, power_rail_info_map,
+                &reloaded_power_rail_info_map, &CheckPowerRailStructure,
+                &reload->power_rail_info_map, errors);
+    return errors->size() == error_count;
+}
+
+void ApplySensorTunables(const SensorInfo &reloaded, SensorInfo *sensor_info) {
+    sensor_info->hot_thresholds = reloaded.hot_thresholds;
+    sensor_info->cold_thresholds = reloaded.cold_thresholds;
+    sensor_info->hot_hysteresis = reloaded.hot_hysteresis;
+    sensor_info->cold_hysteresis = reloaded.cold_hysteresis;
+    sensor_info->vr_threshold = reloaded.vr_threshold;
+    sensor_info->multiplier = reloaded.multiplier;
+    sensor_info->polling_delay = reloaded.polling_delay;
+    sensor_info->passive_delay = reloaded.passive_delay;
+    sensor_info->polling_slack = reloaded.polling_slack;
+    sensor_info->time_resolution = reloaded.time_resolution;
+    sensor_info->step_ratio = reloaded.step_ratio;
+    sensor_info->change_epsilon = reloaded.change_epsilon;
+    sensor_info->send_cb = reloaded.send_cb;
+    sensor_info->is_hidden = reloaded.is_hidden;
+    if (sensor_info->virtual_sensor_info != nullptr) {
+        // The links and the estimator model are kept
+        sensor_info->virtual_sensor_info->coefficients = reloaded.virtual_sensor_info->coefficients;
+        sensor_info->virtual_sensor_info->offset = reloaded.virtual_sensor_info->offset;
+    }
+    if (sensor_info->throttling_info != nullptr) {
+        // The throttling info is shared, it is updated in place
+        *sensor_info->throttling_info = *reloaded.throttling_info;
+    }
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <json/value.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "thermal_info.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+// The entities of a new config which changed from the live config, parsed and ready to be
+// applied. Only their tunables differ from the live entities.
+struct ConfigReload {
+    std::unordered_map<std::string, SensorInfo> sensor_info_map;
+    std::unordered_map<std::string, CdevInfo> cooling_device_info_map;
+    std::unordered_map<std::string, PowerRailInfo> power_rail_info_map;
+};
+
+// Parse the new config and diff it against the live config. Fail with all the reasons if the
+// new config is invalid or changes its structure, which needs a restart of the HAL: entities
+// added or removed, paths, links, bindings, or any section other than the sensors, cooling
+// devices and power rails.
+bool PrepareConfigReload(const Json::Value &live_config, const Json::Value &config,
+                         const std::unordered_map<std::string, SensorInfo> &sensor_info_map,
+                         const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map,
+                         const std::unordered_map<std::string, PowerRailInfo> &power_rail_info_map,
+                         ConfigReload *reload, std::vector<std::string> *errors);
+// Copy the tunables of a reloaded sensor into the live sensor
+void ApplySensorTunables(const SensorInfo &reloaded, SensorInfo *sensor_info);
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "thermal_config_schema.h"
+
+#include <regex>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+namespace {
+
+bool MatchesType(const Json::Value &value, const std::string &type) {
+    if (type == "object") {
+        return value.isObject();
+    } else if (type == "array") {
+        return value.isArray();
+    } else if (type == "string") {
+        return value.isString();
+    } else if (type == "number") {
+        return value.isNumeric() && !value.isBool();
+    } else if (type == "integer") {
+        return value.isIntegral() && !value.isBool();
+    } else if (type == "boolean") {
+        return value.isBool();
+    } else if (type == "null") {
+        return value.isNull();
+    }
+    return false;
+}
+
+bool MatchesTypes(const Json::Value &value, const Json::Value &types) {
+    if (types.isString()) {
+        return MatchesType(value, types.asString());
+    }
+    for (Json::Value::ArrayIndex i = 0; i < types.size(); ++i) {
+        if (MatchesType(value, types[i].asString())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ValidateValue(const Json::Value &schema, const Json::Value &value, const std::string &path,
+                   std::vector<std::string> *errors) {
+    if (schema.isMember("type") && !MatchesTypes(value, schema["type"])) {
+        errors->push_back(path + ": expected type " +
+                          (schema["type"].isString() ? schema["type"].asString()
+                                                     : schema["type"].toStyledString()));
+        // The other keywords do not apply to a value of the wrong type
+        return;
+    }
+
+    if (schema.isMember("enum")) {
+        bool found = false;
+        for (Json::Value::ArrayIndex i = 0; i < schema["enum"].size() && !found; ++i) {
+            found = (schema["enum"][i] == value);
+        }
+        if (!found) {
+            errors->push_back(path + ": value is not one of the enum values");
+        }
+    }
+
+    if (value.isNumeric() && !value.isBool()) {
+        const double number = value.asDouble();
+        if (schema.isMember("minimum") && number < schema["minimum"].asDouble()) {
+            errors->push_back(path + ": " + value.asString() + " is below minimum " +
+                              schema["minimum"].asString());
+        }
+        if (schema.isMember("maximum") && number > schema["maximum"].asDouble()) {
+            errors->push_back(path + ": " + value.asString() + " is above maximum " +
+                              schema["maximum"].asString());
+        }
+        if (schema.isMember("exclusiveMinimum") &&
+            number <= schema["exclusiveMinimum"].asDouble()) {
+            errors->push_back(path + ": " + value.asString() + " is not above " +
+                              schema["exclusiveMinimum"].asString());
+        }
+        if (schema.isMember("exclusiveMaximum") &&
+            number >= schema["exclusiveMaximum"].asDouble()) {
+            errors->push_back(path + ": " + value.asString() + " is not below " +
+                              schema["exclusiveMaximum"].asString());
+        }
+    }
+
+    if (value.isString() && schema.isMember("pattern")) {
+        if (!std::regex_search(value.asString(), std::regex(schema["pattern"].asString()))) {
+            errors->push_back(path + ": \"" + value.asString() + "\" does not match " +
+                              schema["pattern"].asString());
+        }
+    }
+
+    if (value.isArray()) {
+        if (schema.isMember("minItems") && value.size() < schema["minItems"].asUInt()) {
+            errors->push_back(path + ": expected at least " + schema["minItems"].asString() +
+                              " items");
+        }
+        if (schema.isMember("maxItems") && value.size() > schema["maxItems"].asUInt()) {
+            errors->push_back(path + ": expected at most " + schema["maxItems"].asString() +
+                              " items");
+        }
+        if (schema["items"].isObject()) {
+            for (Json::Value::ArrayIndex i = 0; i < value.size(); ++i) {
+                ValidateValue(schema["items"], value[i], path + "[" + std::to_string(i) + "]",
+                              errors);
+            }
+        }
+    }
+
+    if (value.isObject()) {
+        const Json::Value &required = schema["required"];
+        for (Json::Value::ArrayIndex i = 0; i < required.size(); ++i) {
+            if (!value.isMember(required[i].asString())) {
+                errors->push_back(path + ": missing required " + required[i].asString());
+            }
+        }
+        const Json::Value &properties = schema["properties"];
+        if (properties.isObject()) {
+            for (const auto &name : properties.getMemberNames()) {
+                if (value.isMember(name)) {
+                    ValidateValue(properties[name], value[name], path + "/" + name, errors);
+                }
+            }
+        }
+    }
+}
+
+}  // namespace
+
+bool ValidateThermalConfigSchema(const Json::Value &schema, const Json::Value &config,
+                                 std::vector<std::string> *errors) {
+    const size_t error_count = errors->size();
+    ValidateValue(schema, config, "config", errors);
+    return errors->size() == error_count;
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <json/value.h>
+
+#include <string>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+// Validate a thermal config against config_schema.json. Only the keywords used by the schema
+// are supported: type, required, properties, items, minItems, maxItems, minimum, maximum,
+// exclusiveMinimum, exclusiveMaximum, enum and pattern. All the violations are collected with
+// the JSON path of the offending value. Return false on any violation.
+bool ValidateThermalConfigSchema(const Json::Value &schema, const Json::Value &config,
+                                 std::vector<std::string> *errors);
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
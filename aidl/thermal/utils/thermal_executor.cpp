@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define ATRACE_TAG (ATRACE_TAG_THERMAL | ATRACE_TAG_HAL)
+
+#include "thermal_executor.h"
+
+#include <android-base/logging.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+ThermalExecutor::~ThermalExecutor() {
+    stop();
+}
+
+void ThermalExecutor::start(size_t worker_count) {
+    stop();
+    worker_count = std::min(worker_count, kMaxExecutorWorkers);
+    if (!worker_count) {
+        return;
+    }
+
+    stopping_ = false;
+    for (size_t i = 0; i <= worker_count; ++i) {
+        queues_.emplace_back(std::make_unique<WorkQueue>());
+    }
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+    LOG(INFO) << "Thermal executor started with " << worker_count << " workers";
+}
+
+void ThermalExecutor::stop() {
+    if (workers_.empty()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> _lock(mutex_);
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    queues_.clear();
+}
+
+void ThermalExecutor::run(std::vector<std::function<void()>> *tasks) {
+    if (tasks->empty()) {
+        return;
+    }
+    if (workers_.empty()) {
+        for (auto &task : *tasks) {
+            task();
+        }
+        return;
+    }
+
+    ATRACE_CALL();
+    // Deal the tasks round robin, stealing evens out the slow reads
+    pending_tasks_.store(tasks->size(), std::memory_order_relaxed);
+    for (size_t i = 0; i < tasks->size(); ++i) {
+        auto &queue = *queues_[i % queues_.size()];
+        std::lock_guard<std::mutex> _lock(queue.mutex);
+        queue.tasks.push_back(&(*tasks)[i]);
+    }
+    {
+        std::lock_guard<std::mutex> _lock(mutex_);
+        generation_++;
+    }
+    work_cv_.notify_all();
+
+    drain(queues_.size() - 1);
+    std::unique_lock<std::mutex> _lock(mutex_);
+    done_cv_.wait(_lock, [this] { return pending_tasks_.load(std::memory_order_acquire) == 0; });
+}
+
+void ThermalExecutor::workerLoop(size_t index) {
+    uint64_t generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> _lock(mutex_);
+            work_cv_.wait(_lock, [this, generation] {
+                return stopping_ || generation_ != generation;
+            });
+            if (stopping_) {
+                return;
+            }
+            generation = generation_;
+        }
+        drain(index);
+    }
+}
+
+void ThermalExecutor::drain(size_t index) {
+    while (auto *task = popTask(index)) {
+        (*task)();
+        if (pending_tasks_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> _lock(mutex_);
+            done_cv_.notify_all();
+        }
+    }
+}
+
+std::function<void()> *ThermalExecutor::popTask(size_t index) {
+    {
+        auto &queue = *queues_[index];
+        std::lock_guard<std::mutex> _lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            auto *task = queue.tasks.front();
+            queue.tasks.pop_front();
+            return task;
+        }
+    }
+    for (size_t i = 1; i < queues_.size(); ++i) {
+        auto &queue = *queues_[(index + i) % queues_.size()];
+        std::lock_guard<std::mutex> _lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            auto *task = queue.tasks.back();
+            queue.tasks.pop_back();
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
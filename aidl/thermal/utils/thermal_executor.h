@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+constexpr size_t kMaxExecutorWorkers = 8;
+
+// A small work-stealing executor for the independent reads of a watcher tick. Each worker
+// drains its own queue from the front and steals from the back of the others. The caller of
+// run() works as well and returns once every task is done.
+class ThermalExecutor {
+  public:
+    ThermalExecutor() = default;
+    ~ThermalExecutor();
+    // Disallow copy and assign
+    ThermalExecutor(const ThermalExecutor &) = delete;
+    void operator=(const ThermalExecutor &) = delete;
+
+    // Start the worker threads, 0 worker stops the executor
+    void start(size_t worker_count);
+    void stop();
+    size_t getWorkerCount() const { return workers_.size(); }
+    bool isEnabled() const { return !workers_.empty(); }
+    // Run the tasks and wait for all of them, only called from one thread at a time
+    void run(std::vector<std::function<void()>> *tasks);
+
+  private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()> *> tasks;
+    };
+
+    void workerLoop(size_t index);
+    // Run the tasks of the queue then steal from the others, until no task is left
+    void drain(size_t index);
+    std::function<void()> *popTask(size_t index);
+
+    // One queue per worker, the last one belongs to the caller of run()
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    uint64_t generation_ = 0;
+    bool stopping_ = false;
+    std::atomic<size_t> pending_tasks_ = 0;
+};
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
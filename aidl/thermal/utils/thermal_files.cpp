@@ -12,6 +12,7 @@
 #include <android-base/logging.h>
 #include <android-base/stringprintf.h>
 #include <android-base/strings.h>
+#include <fcntl.h>
 #include <utils/Trace.h>
 
 #include <algorithm>
@@ -25,6 +26,43 @@ namespace implementation {
 
 using ::android::base::StringPrintf;
 
+namespace {
+
+// Largest sysfs attribute read in a batch, a longer one is read again with pread
+constexpr size_t kBatchReadSize = 128;
+
+bool CheckReading(std::string_view thermal_name, const std::string &reading, std::string *data) {
+    if (reading.size() <= 1) {
+        LOG(ERROR) << thermal_name << "'s return size:" << reading.size() << " is invalid";
+        return false;
+    }
+
+    // Strip the newline.
+    *data = ::android::base::Trim(reading);
+    return true;
+}
+
+}  // namespace
+
+bool ReadStaticThermalFile(std::string_view path, std::string *data) {
+    static std::mutex static_content_mutex;
+    static std::unordered_map<std::string, std::string> static_content_map;
+    std::lock_guard<std::mutex> _lock(static_content_mutex);
+    const auto content_it = static_content_map.find(std::string(path));
+    if (content_it != static_content_map.end()) {
+        *data = content_it->second;
+        return true;
+    }
+
+    std::string content;
+    if (!::android::base::ReadFileToString(std::string(path), &content)) {
+        return false;
+    }
+    *data = ::android::base::Trim(content);
+    static_content_map.emplace(path, *data);
+    return true;
+}
+
 std::string ThermalFiles::getThermalFilePath(std::string_view thermal_name) const {
     auto sensor_itr = thermal_name_to_path_map_.find(thermal_name.data());
     if (sensor_itr == thermal_name_to_path_map_.end()) {
@@ -33,8 +71,21 @@ std::string ThermalFiles::getThermalFilePath(std::string_view thermal_name) cons
     return sensor_itr->second;
 }
 
-bool ThermalFiles::addThermalFile(std::string_view thermal_name, std::string_view path) {
-    return thermal_name_to_path_map_.emplace(thermal_name, path).second;
+bool ThermalFiles::addThermalFile(std::string_view thermal_name, std::string_view path,
+                                  bool is_owned) {
+    if (!thermal_name_to_path_map_.emplace(thermal_name, path).second) {
+        return false;
+    }
+    if (is_owned) {
+        owned_files_.emplace(thermal_name);
+    }
+    // A file which cannot be opened for read, like a cdev write file, is accessed by path
+    ::android::base::unique_fd fd(
+            TEMP_FAILURE_RETRY(open(std::string(path).c_str(), O_RDONLY | O_CLOEXEC)));
+    if (fd != -1) {
+        thermal_name_to_fd_map_.emplace(thermal_name, std::move(fd));
+    }
+    return true;
 }
 
 bool ThermalFiles::readThermalFile(std::string_view thermal_name, std::string *data) const {
@@ -48,31 +99,110 @@ bool ThermalFiles::readThermalFile(std::string_view thermal_name, std::string *d
         return false;
     }
 
-    if (!::android::base::ReadFileToString(file_path, &sensor_reading)) {
+    const bool is_owned = owned_files_.count(std::string(thermal_name)) > 0;
+    if (is_owned) {
+        std::lock_guard<std::mutex> _lock(owned_content_mutex_);
+        const auto content_it = owned_content_map_.find(std::string(thermal_name));
+        if (content_it != owned_content_map_.end()) {
+            *data = content_it->second;
+            return true;
+        }
+    }
+
+    const auto fd_it = thermal_name_to_fd_map_.find(std::string(thermal_name));
+    countSysfsOp();
+    const bool is_read = (fd_it != thermal_name_to_fd_map_.end())
+                                 ? PreadFile(fd_it->second.get(), &sensor_reading)
+                                 : ::android::base::ReadFileToString(file_path, &sensor_reading);
+    if (!is_read) {
         PLOG(WARNING) << "Failed to read sensor: " << thermal_name;
         return false;
     }
 
-    if (sensor_reading.size() <= 1) {
-        LOG(ERROR) << thermal_name << "'s return size:" << sensor_reading.size() << " is invalid";
+    if (!CheckReading(thermal_name, sensor_reading, data)) {
         return false;
     }
+    if (is_owned) {
+        std::lock_guard<std::mutex> _lock(owned_content_mutex_);
+        owned_content_map_[std::string(thermal_name)] = *data;
+    }
+    return true;
+}
 
-    // Strip the newline.
-    *data = ::android::base::Trim(sensor_reading);
+bool ThermalFiles::enableBatchRead() {
+    std::vector<int> fds;
+    fds.reserve(thermal_name_to_fd_map_.size());
+    thermal_name_to_batch_index_map_.clear();
+    for (const auto &[thermal_name, fd] : thermal_name_to_fd_map_) {
+        thermal_name_to_batch_index_map_.emplace(thermal_name, fds.size());
+        fds.emplace_back(fd.get());
+    }
+    if (!batch_reader_.init(fds, kBatchReadSize)) {
+        thermal_name_to_batch_index_map_.clear();
+        return false;
+    }
     return true;
 }
 
+void ThermalFiles::readThermalFiles(const std::vector<std::string_view> &thermal_names,
+                                    std::vector<std::string> *data) const {
+    data->assign(thermal_names.size(), std::string());
+    std::vector<size_t> batch_indices;
+    std::vector<size_t> batch_slots;
+    for (size_t i = 0; i < thermal_names.size(); ++i) {
+        const auto index_it = thermal_name_to_batch_index_map_.find(std::string(thermal_names[i]));
+        if (index_it != thermal_name_to_batch_index_map_.end()) {
+            batch_indices.emplace_back(index_it->second);
+            batch_slots.emplace_back(i);
+        }
+    }
+
+    ATRACE_NAME(StringPrintf("ThermalFiles::readThermalFiles - %zu", thermal_names.size()).c_str());
+    std::vector<bool> is_read(thermal_names.size(), false);
+    std::vector<std::string> batch_readings;
+    if (batch_indices.size() && batch_reader_.read(batch_indices, &batch_readings)) {
+        // One submission, but still one read per file
+        for (size_t i = 0; i < batch_indices.size(); ++i) {
+            countSysfsOp();
+        }
+        for (size_t i = 0; i < batch_slots.size(); ++i) {
+            const auto slot = batch_slots[i];
+            if (batch_readings[i].empty()) {
+                continue;
+            }
+            is_read[slot] = true;
+            CheckReading(thermal_names[slot], batch_readings[i], &(*data)[slot]);
+        }
+    }
+    // The files out of the batch, or whose batch read failed
+    for (size_t i = 0; i < thermal_names.size(); ++i) {
+        if (!is_read[i]) {
+            readThermalFile(thermal_names[i], &(*data)[i]);
+        }
+    }
+}
+
 bool ThermalFiles::writeCdevFile(std::string_view cdev_name, std::string_view data) {
     std::string file_path =
             getThermalFilePath(::android::base::StringPrintf("%s_%s", cdev_name.data(), "w"));
 
     ATRACE_NAME(StringPrintf("ThermalFiles::writeCdevFile - %s", cdev_name.data()).c_str());
+    const bool is_owned = owned_files_.count(std::string(cdev_name)) > 0;
+    countSysfsOp();
     if (!::android::base::WriteStringToFile(data.data(), file_path)) {
         PLOG(WARNING) << "Failed to write cdev: " << cdev_name << " to " << data.data();
+        // The state the driver kept is unknown, it is read again
+        if (is_owned) {
+            std::lock_guard<std::mutex> _lock(owned_content_mutex_);
+            owned_content_map_.erase(std::string(cdev_name));
+        }
         return false;
     }
 
+    if (is_owned) {
+        std::lock_guard<std::mutex> _lock(owned_content_mutex_);
+        owned_content_map_[std::string(cdev_name)] = std::string(data);
+    }
     return true;
 }
 
@@ -6,8 +6,16 @@
 
 #pragma once
 
+#include <android-base/unique_fd.h>
+
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "io_uring_reader.h"
+#include "thermal_profiler.h"
 
 namespace aidl {
 namespace android {
@@ -15,6 +23,10 @@ namespace hardware {
 namespace thermal {
 namespace implementation {
 
+// Read a sysfs attribute which does not change while the device is up, like a zone type, a
+// policy or a cdev max_state and state2power_table. The trimmed content is cached by path.
+bool ReadStaticThermalFile(std::string_view path, std::string *data);
+
 class ThermalFiles {
   public:
     ThermalFiles() = default;
@@ -22,18 +34,46 @@ class ThermalFiles {
     ThermalFiles(const ThermalFiles &) = delete;
     void operator=(const ThermalFiles &) = delete;
 
+    // Count the sysfs reads and writes of the files in the profile of the watcher ticks
+    void setProfiler(ThermalProfiler *profiler) { profiler_ = profiler; }
     std::string getThermalFilePath(std::string_view thermal_name) const;
-    // Returns true if add was successful, false otherwise.
-    bool addThermalFile(std::string_view thermal_name, std::string_view path);
+    // Returns true if add was successful, false otherwise. An owned file is only written by the
+    // HAL through writeCdevFile, its content is cached write-through.
+    bool addThermalFile(std::string_view thermal_name, std::string_view path,
+                        bool is_owned = false);
     // If thermal_name is not found in the thermal names to path map, this will set
     // data to empty and return false. If the thermal_name is found and its content
     // is read, this function will fill in data accordingly then return true.
     bool readThermalFile(std::string_view thermal_name, std::string *data) const;
+    // Register the opened files to an io_uring reader, return false if io_uring is not available
+    bool enableBatchRead();
+    bool isBatchReadEnabled() const { return batch_reader_.isEnabled(); }
+    // Read several files in one batch, data is filled in the order of thermal_names and left
+    // empty for a file which could not be read. Fall back to readThermalFile per file if the
+    // batch read is not enabled.
+    void readThermalFiles(const std::vector<std::string_view> &thermal_names,
+                          std::vector<std::string> *data) const;
     bool writeCdevFile(std::string_view thermal_name, std::string_view data);
     size_t getNumThermalFiles() const { return thermal_name_to_path_map_.size(); }
 
   private:
+    void countSysfsOp() const {
+        if (profiler_ != nullptr) {
+            profiler_->countSysfsOp();
+        }
+    }
+
     std::unordered_map<std::string, std::string> thermal_name_to_path_map_;
+    // The readable files stay open, a sysfs attribute is read again with pread from offset 0
+    std::unordered_map<std::string, ::android::base::unique_fd> thermal_name_to_fd_map_;
+    // The io_uring registration index of the opened files
+    std::unordered_map<std::string, size_t> thermal_name_to_batch_index_map_;
+    mutable IoUringReader batch_reader_;
+    // The owned files and their last read or written content
+    std::unordered_set<std::string> owned_files_;
+    mutable std::mutex owned_content_mutex_;
+    mutable std::unordered_map<std::string, std::string> owned_content_map_;
+    ThermalProfiler *profiler_ = nullptr;
 };
 
 }  // namespace implementation
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#define ATRACE_TAG (ATRACE_TAG_THERMAL | ATRACE_TAG_HAL)
+
+#include "thermal_forecast.h"
+
+#include <android-base/logging.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+namespace {
+
+// Time constant of the trend filter, a larger value reacts slower to noise
+constexpr float kSlopeTimeConstantSec = 5.0;
+// History older than this is considered stale, e.g. after suspend
+constexpr std::chrono::milliseconds kMaxSampleGapMs = std::chrono::milliseconds(60000);
+// Bound of the power trend correction applied to the temperature trend
+constexpr float kMinPowerRatio = 0.5;
+constexpr float kMaxPowerRatio = 2.0;
+
+}  // namespace
+
+float ThermalForecaster::getLinkedPower(
+        const SensorInfo &sensor_info,
+        const std::unordered_map<std::string, PowerStatus> &power_status_map) const {
+    if (sensor_info.throttling_info == nullptr) {
+        return NAN;
+    }
+
+    std::unordered_set<std::string_view> power_rails;
+    for (const auto &excluded_power_info_pair :
+         sensor_info.throttling_info->excluded_power_info_map) {
+        power_rails.insert(excluded_power_info_pair.first);
+    }
+    for (const auto &binded_cdev_info_pair : sensor_info.throttling_info->binded_cdev_info_map) {
+        if (!binded_cdev_info_pair.second.power_rail.empty()) {
+            power_rails.insert(binded_cdev_info_pair.second.power_rail);
+        }
+    }
+
+    float power = NAN;
+    for (const auto &power_rail : power_rails) {
+        const auto power_status_it = power_status_map.find(power_rail.data());
+        if (power_status_it == power_status_map.end() ||
+            std::isnan(power_status_it->second.last_updated_avg_power)) {
+            continue;
+        }
+        power = (std::isnan(power) ? 0 : power) + power_status_it->second.last_updated_avg_power;
+    }
+    return power;
+}
+
+void ThermalForecaster::updateForecast(
+        std::string_view sensor_name, const SensorInfo &sensor_info, const float temp,
+        const boot_clock::time_point &now,
+        const std::unordered_map<std::string, PowerStatus> &power_status_map) {
+    ATRACE_CALL();
+    if (std::isnan(temp)) {
+        return;
+    }
+
+    const float power = getLinkedPower(sensor_info, power_status_map);
+    auto history_it = history_map_.find(sensor_name.data());
+    if (history_it == history_map_.end()) {
+        history_it = history_map_.emplace(sensor_name, ForecastHistory{temp, now, 0, power}).first;
+    }
+    auto &history = history_it->second;
+
+    // Update the temperature trend with an exponential filter weighted by the sample interval
+    const auto sample_gap =
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - history.prev_timestamp);
+    if (sample_gap > kMaxSampleGapMs) {
+        history.slope = 0;
+        history.avg_power = power;
+    } else if (sample_gap.count() > 0) {
+        const float dt_sec = sample_gap.count() / 1000.0;
+        const float alpha = 1 - std::exp(-dt_sec / kSlopeTimeConstantSec);
+        const float instant_slope = (temp - history.prev_temp) / dt_sec;
+        history.slope += alpha * (instant_slope - history.slope);
+        if (!std::isnan(power)) {
+            history.avg_power = std::isnan(history.avg_power)
+                                        ? power
+                                        : history.avg_power + alpha * (power - history.avg_power);
+        }
+    }
+    history.prev_temp = temp;
+    history.prev_timestamp = now;
+
+    // Recent power above the average means the trend is about to steepen, and vice versa
+    float slope = history.slope;
+    if (!std::isnan(power) && !std::isnan(history.avg_power) && history.avg_power > 0) {
+        const float power_ratio =
+                std::clamp(power / history.avg_power, kMinPowerRatio, kMaxPowerRatio);
+        slope = (slope >= 0) ? slope * power_ratio : slope / power_ratio;
+    }
+
+    SensorForecast forecast = {
+            .temp = temp,
+            .slope = slope,
+            .power = power,
+            .next_severity = ThrottlingSeverity::NONE,
+            .next_threshold = NAN,
+            .time_to_threshold = std::chrono::milliseconds::max(),
+            .predicted_temp = temp + slope * horizon_.count() / 1000,
+            .predicted_headroom = NAN,
+            .timestamp = now,
+    };
+
+    for (size_t i = static_cast<size_t>(ThrottlingSeverity::LIGHT); i < kThrottlingSeverityCount;
+         ++i) {
+        if (!std::isnan(sensor_info.hot_thresholds[i]) && sensor_info.hot_thresholds[i] > temp) {
+            forecast.next_severity = static_cast<ThrottlingSeverity>(i);
+            forecast.next_threshold = sensor_info.hot_thresholds[i];
+            break;
+        }
+    }
+    if (!std::isnan(forecast.next_threshold) && slope > 0) {
+        forecast.time_to_threshold = std::chrono::milliseconds(
+                static_cast<int64_t>((forecast.next_threshold - temp) / slope * 1000));
+    }
+
+    const float severe_threshold =
+            sensor_info.hot_thresholds[static_cast<size_t>(ThrottlingSeverity::SEVERE)];
+    if (!std::isnan(severe_threshold)) {
+        forecast.predicted_headroom =
+                (forecast.predicted_temp -
+                 (severe_threshold - kHeadroomDegreesBetweenZeroAndOne)) /
+                kHeadroomDegreesBetweenZeroAndOne;
+    }
+
+    LOG(VERBOSE) << sensor_name << " forecast: slope=" << slope << " power=" << power
+                 << " predicted_temp=" << forecast.predicted_temp
+                 << " time_to_threshold=" << forecast.time_to_threshold.count();
+
+    std::unique_lock<std::shared_mutex> _lock(forecast_map_mutex_);
+    forecast_map_[sensor_name.data()] = forecast;
+}
+
+void ThermalForecaster::clearForecast(std::string_view sensor_name) {
+    history_map_.erase(sensor_name.data());
+    std::unique_lock<std::shared_mutex> _lock(forecast_map_mutex_);
+    forecast_map_.erase(sensor_name.data());
+}
+
+bool ThermalForecaster::getForecast(std::string_view sensor_name, SensorForecast *forecast) const {
+    std::shared_lock<std::shared_mutex> _lock(forecast_map_mutex_);
+    const auto forecast_it = forecast_map_.find(sensor_name.data());
+    if (forecast_it == forecast_map_.end()) {
+        return false;
+    }
+    *forecast = forecast_it->second;
+    return true;
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android-base/chrono_utils.h>
+
+#include <chrono>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "power_files.h"
+#include "thermal_info.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+using ::android::base::boot_clock;
+
+// Same normalization the framework uses for thermal headroom: 1.0 at the SEVERE threshold.
+constexpr float kHeadroomDegreesBetweenZeroAndOne = 30.0;
+constexpr std::chrono::milliseconds kDefaultForecastHorizonMs = std::chrono::milliseconds(10000);
+
+struct SensorForecast {
+    // Latest temperature in the same unit as the thresholds
+    float temp;
+    // Smoothed temperature trend, degree per second
+    float slope;
+    // Sum of the ODPM rails linked to the sensor's throttling, NAN if not available
+    float power;
+    // The next hot severity above the latest temperature
+    ThrottlingSeverity next_severity;
+    float next_threshold;
+    // Estimated time to cross next_threshold, max() if the sensor is not heating up
+    std::chrono::milliseconds time_to_threshold;
+    // Predicted temperature and headroom at the forecast horizon
+    float predicted_temp;
+    float predicted_headroom;
+    boot_clock::time_point timestamp;
+};
+
+// A helper class to forecast the thermal headroom of each monitored sensor
+class ThermalForecaster {
+  public:
+    ThermalForecaster() = default;
+    ~ThermalForecaster() = default;
+    // Disallow copy and assign.
+    ThermalForecaster(const ThermalForecaster &) = delete;
+    void operator=(const ThermalForecaster &) = delete;
+
+    void setHorizon(std::chrono::milliseconds horizon) { horizon_ = horizon; }
+    std::chrono::milliseconds getHorizon() const { return horizon_; }
+    // Feed the latest reading of a sensor, called from the watcher thread only
+    void updateForecast(std::string_view sensor_name, const SensorInfo &sensor_info,
+                        const float temp, const boot_clock::time_point &now,
+                        const std::unordered_map<std::string, PowerStatus> &power_status_map);
+    // Drop the history of a sensor, e.g. when its reading is not valid anymore
+    void clearForecast(std::string_view sensor_name);
+    // Get the last forecast of the sensor, return false if there is none
+    bool getForecast(std::string_view sensor_name, SensorForecast *forecast) const;
+    // Copy of the latest forecast of all sensors
+    std::unordered_map<std::string, SensorForecast> GetForecastSnapshot() const {
+        std::shared_lock<std::shared_mutex> _lock(forecast_map_mutex_);
+        return forecast_map_;
+    }
+
+  private:
+    struct ForecastHistory {
+        float prev_temp;
+        boot_clock::time_point prev_timestamp;
+        float slope;
+        float avg_power;
+    };
+    // Return the sum of the power rails which the sensor's throttling depends on
+    float getLinkedPower(const SensorInfo &sensor_info,
+                         const std::unordered_map<std::string, PowerStatus> &power_status_map) const;
+    std::chrono::milliseconds horizon_ = kDefaultForecastHorizonMs;
+    // History is only touched by the watcher thread
+    std::unordered_map<std::string, ForecastHistory> history_map_;
+    mutable std::shared_mutex forecast_map_mutex_;
+    std::unordered_map<std::string, SensorForecast> forecast_map_;
+};
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define ATRACE_TAG (ATRACE_TAG_THERMAL | ATRACE_TAG_HAL)
+
+#include "thermal_freq_cdev.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/parseint.h>
+#include <android-base/strings.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <charconv>
+
+#include "thermal_files.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+namespace {
+
+// cpufreq policy nodes, and the devfreq nodes as fallback
+constexpr std::string_view kCpufreqAvailableFreqs("scaling_available_frequencies");
+constexpr std::string_view kCpufreqMaxFreq("scaling_max_freq");
+constexpr std::string_view kCpufreqCurFreq("scaling_cur_freq");
+constexpr std::string_view kDevfreqAvailableFreqs("available_frequencies");
+constexpr std::string_view kDevfreqMaxFreq("max_freq");
+constexpr std::string_view kDevfreqCurFreq("cur_freq");
+constexpr int64_t kKhzPerMhz = 1000;
+constexpr int64_t kHzPerMhz = 1000000;
+
+}  // namespace
+
+bool FreqCoolingDevice::init(std::string_view name, std::string_view domain_path,
+                             ThermalProfiler *profiler) {
+    name_ = name;
+    domain_path_ = domain_path;
+    profiler_ = profiler;
+
+    std::string available_freqs;
+    bool is_devfreq = false;
+    if (!ReadStaticThermalFile(domain_path_ + "/" + std::string(kCpufreqAvailableFreqs),
+                               &available_freqs)) {
+        if (!ReadStaticThermalFile(domain_path_ + "/" + std::string(kDevfreqAvailableFreqs),
+                                   &available_freqs)) {
+            LOG(ERROR) << "Could not read available frequencies of " << name << " in "
+                       << domain_path;
+            return false;
+        }
+        is_devfreq = true;
+    }
+    freq_unit_per_mhz_ = is_devfreq ? kHzPerMhz : kKhzPerMhz;
+
+    freqs_.clear();
+    for (const auto &freq_str : ::android::base::Split(available_freqs, " ")) {
+        int64_t freq;
+        if (freq_str.empty()) {
+            continue;
+        }
+        if (!::android::base::ParseInt(freq_str, &freq, int64_t(0))) {
+            LOG(ERROR) << "Invalid frequency " << freq_str << " of " << name;
+            return false;
+        }
+        freqs_.push_back(freq);
+    }
+    if (freqs_.empty()) {
+        LOG(ERROR) << "No available frequency of " << name;
+        return false;
+    }
+    std::sort(freqs_.begin(), freqs_.end(), std::greater<int64_t>());
+    freqs_.erase(std::unique(freqs_.begin(), freqs_.end()), freqs_.end());
+
+    const std::string max_freq_path =
+            domain_path_ + "/" + std::string(is_devfreq ? kDevfreqMaxFreq : kCpufreqMaxFreq);
+    max_freq_fd_.reset(TEMP_FAILURE_RETRY(open(max_freq_path.c_str(), O_WRONLY | O_CLOEXEC)));
+    if (max_freq_fd_ == -1) {
+        PLOG(ERROR) << "Could not open " << max_freq_path;
+        return false;
+    }
+    const std::string cur_freq_path =
+            domain_path_ + "/" + std::string(is_devfreq ? kDevfreqCurFreq : kCpufreqCurFreq);
+    cur_freq_fd_.reset(TEMP_FAILURE_RETRY(open(cur_freq_path.c_str(), O_RDONLY | O_CLOEXEC)));
+    if (cur_freq_fd_ == -1) {
+        PLOG(WARNING) << "Could not open " << cur_freq_path;
+    }
+    LOG(INFO) << "Freq cooling device " << name << " on " << domain_path
+              << " max state: " << getMaxState();
+    return true;
+}
+
+bool FreqCoolingDevice::setState(int state) {
+    state = std::clamp(state, 0, getMaxState());
+    ATRACE_NAME(("FreqCoolingDevice::setState - " + name_).c_str());
+    char buf[24];
+    const auto result = std::to_chars(buf, buf + sizeof(buf), freqs_[state]);
+    const ssize_t len = result.ptr - buf;
+    countSysfsOp();
+    if (TEMP_FAILURE_RETRY(pwrite(max_freq_fd_.get(), buf, len, 0)) != len) {
+        PLOG(WARNING) << "Failed to cap " << name_ << " to " << freqs_[state];
+        return false;
+    }
+    state_.store(state, std::memory_order_relaxed);
+    return true;
+}
+
+bool FreqCoolingDevice::readCurFreq(int64_t *freq) const {
+    if (cur_freq_fd_ == -1) {
+        return false;
+    }
+    char buf[24];
+    countSysfsOp();
+    const ssize_t len = TEMP_FAILURE_RETRY(pread(cur_freq_fd_.get(), buf, sizeof(buf) - 1, 0));
+    if (len <= 0) {
+        return false;
+    }
+    buf[len] = '\0';
+    return ::android::base::ParseInt(::android::base::Trim(buf), freq, int64_t(0));
+}
+
+void FreqCoolingDevice::sampleCurFreq() {
+    int64_t freq;
+    if (getState() == 0 || !readCurFreq(&freq)) {
+        return;
+    }
+    capped_freq_histogram_.record(freq / freq_unit_per_mhz_);
+}
+
+void FreqCoolingDevice::dump(std::ostringstream *dump_buf) const {
+    const int state = getState();
+    int64_t cur_freq = -1;
+    readCurFreq(&cur_freq);
+    *dump_buf << " Name: " << name_ << " Domain: " << domain_path_ << " State: " << state << "/"
+              << getMaxState() << " CapFreq: " << freqs_[state] << " CurFreq: " << cur_freq;
+    const auto histogram = capped_freq_histogram_.snapshot();
+    if (histogram.count) {
+        *dump_buf << " CappedCurFreq p50: " << histogram.getPercentile(50)
+                  << "MHz p95: " << histogram.getPercentile(95) << "MHz";
+    }
+    *dump_buf << std::endl;
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "thermal_profiler.h"
+#include "thermal_stats_helper.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+using ::android::base::unique_fd;
+
+// Achieved frequency in MHz
+using FreqHistogram = LogLinearHistogram<6, 14>;
+
+// A cooling device which caps a cpufreq policy or a devfreq device directly. State 0 is the
+// highest available frequency and each state steps down one available frequency.
+class FreqCoolingDevice {
+  public:
+    FreqCoolingDevice() = default;
+    ~FreqCoolingDevice() = default;
+    // Disallow copy and assign
+    FreqCoolingDevice(const FreqCoolingDevice &) = delete;
+    void operator=(const FreqCoolingDevice &) = delete;
+
+    // Resolve the states from the available frequencies of the domain and open its nodes. The
+    // profiler counts the reads and writes of the nodes, it may be null.
+    bool init(std::string_view name, std::string_view domain_path, ThermalProfiler *profiler);
+    int getMaxState() const { return static_cast<int>(freqs_.size()) - 1; }
+    int getState() const { return state_.load(std::memory_order_relaxed); }
+    // Cap the domain at the frequency of the state
+    bool setState(int state);
+    // Read the frequency the domain is running at
+    bool readCurFreq(int64_t *freq) const;
+    // Record the achieved frequency while the domain is capped
+    void sampleCurFreq();
+    void dump(std::ostringstream *dump_buf) const;
+
+  private:
+    void countSysfsOp() const {
+        if (profiler_ != nullptr) {
+            profiler_->countSysfsOp();
+        }
+    }
+
+    std::string name_;
+    std::string domain_path_;
+    // Descending available frequencies, in the unit of the domain nodes
+    std::vector<int64_t> freqs_;
+    // kHz for cpufreq, Hz for devfreq
+    int64_t freq_unit_per_mhz_ = 1000;
+    unique_fd max_freq_fd_;
+    unique_fd cur_freq_fd_;
+    std::atomic<int> state_ = 0;
+    FreqHistogram capped_freq_histogram_;
+    ThermalProfiler *profiler_ = nullptr;
+};
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -7,6 +7,8 @@
 
 #include <android-base/file.h>
 #include <android-base/logging.h>
+#include <android-base/parsedouble.h>
+#include <android-base/parseint.h>
 #include <android-base/properties.h>
 #include <android-base/strings.h>
 #include <json/reader.h>
@@ -37,21 +39,40 @@ bool getTypeFromString(std::string_view str, T *out) {
     return false;
 }
 
-float getFloatFromValue(const Json::Value &value) {
+// A string value is parsed, so that "NAN" reads as NAN. Return false on an invalid value.
+bool getFloatFromValue(const Json::Value &value, float *out) {
     if (value.isString()) {
-        return std::stof(value.asString());
-    } else {
-        return value.asFloat();
+        if (!::android::base::ParseFloat(value.asString(), out)) {
+            LOG(ERROR) << "Invalid float value: " << value.asString();
+            return false;
+        }
+        return true;
+    } else if (!value.isConvertibleTo(Json::realValue)) {
+        LOG(ERROR) << "Invalid float value: " << value.toStyledString();
+        return false;
     }
+    *out = value.asFloat();
+    return true;
 }
 
-int getIntFromValue(const Json::Value &value) {
+// A string value is parsed, "max" reads as the max int. Return false on an invalid value.
+bool getIntFromValue(const Json::Value &value, int *out) {
     if (value.isString()) {
-        return (value.asString() == "max") ? std::numeric_limits<int>::max()
-                                           : std::stoul(value.asString());
-    } else {
-        return value.asInt();
+        if (value.asString() == "max") {
+            *out = std::numeric_limits<int>::max();
+            return true;
+        }
+        if (!::android::base::ParseInt(value.asString(), out)) {
+            LOG(ERROR) << "Invalid int value: " << value.asString();
+            return false;
+        }
+        return true;
+    } else if (!value.isConvertibleTo(Json::intValue)) {
+        LOG(ERROR) << "Invalid int value: " << value.toStyledString();
+        return false;
     }
+    *out = value.asInt();
+    return true;
 }
 
 bool getIntFromJsonValues(const Json::Value &values, CdevArray *out, bool inc_check,
@@ -67,15 +88,17 @@ bool getIntFromJsonValues(const Json::Value &values, CdevArray *out, bool inc_ch
         LOG(ERROR) << "Values size is invalid";
         return false;
     } else {
-        int last;
+        int last = 0;
         for (Json::Value::ArrayIndex i = 0; i < kThrottlingSeverityCount; ++i) {
-            ret[i] = getIntFromValue(values[i]);
-            if (inc_check && ret[i] < last) {
-                LOG(FATAL) << "Invalid array[" << i << "]" << ret[i] << " min=" << last;
+            if (!getIntFromValue(values[i], &ret[i])) {
                 return false;
             }
-            if (dec_check && ret[i] > last) {
-                LOG(FATAL) << "Invalid array[" << i << "]" << ret[i] << " max=" << last;
+            if (inc_check && i > 0 && ret[i] < last) {
+                LOG(ERROR) << "Invalid array[" << i << "]" << ret[i] << " min=" << last;
+                return false;
+            }
+            if (dec_check && i > 0 && ret[i] > last) {
+                LOG(ERROR) << "Invalid array[" << i << "]" << ret[i] << " max=" << last;
                 return false;
             }
             last = ret[i];
@@ -102,13 +125,15 @@ bool getFloatFromJsonValues(const Json::Value &values, ThrottlingArray *out, boo
     } else {
         float last = std::nanf("");
         for (Json::Value::ArrayIndex i = 0; i < kThrottlingSeverityCount; ++i) {
-            ret[i] = getFloatFromValue(values[i]);
+            if (!getFloatFromValue(values[i], &ret[i])) {
+                return false;
+            }
             if (inc_check && !std::isnan(last) && !std::isnan(ret[i]) && ret[i] < last) {
-                LOG(FATAL) << "Invalid array[" << i << "]" << ret[i] << " min=" << last;
+                LOG(ERROR) << "Invalid array[" << i << "]" << ret[i] << " min=" << last;
                 return false;
             }
             if (dec_check && !std::isnan(last) && !std::isnan(ret[i]) && ret[i] > last) {
-                LOG(FATAL) << "Invalid array[" << i << "]" << ret[i] << " max=" << last;
+                LOG(ERROR) << "Invalid array[" << i << "]" << ret[i] << " max=" << last;
                 return false;
             }
             last = std::isnan(ret[i]) ? last : ret[i];
@@ -126,10 +151,10 @@ bool getTempRangeInfoFromJsonValues(const Json::Value &values, TempRangeInfo *te
         return false;
     }
 
-    float min_temp = getFloatFromValue(values[0]);
-    float max_temp = getFloatFromValue(values[1]);
-
-    if (std::isnan(min_temp) || std::isnan(max_temp)) {
+    float min_temp = NAN;
+    float max_temp = NAN;
+    if (!getFloatFromValue(values[0], &min_temp) || !getFloatFromValue(values[1], &max_temp) ||
+        std::isnan(min_temp) || std::isnan(max_temp)) {
         LOG(ERROR) << "Illegal temp range: thresholds not defined properly " << min_temp << " : "
                    << max_temp;
         return false;
@@ -152,8 +177,9 @@ bool getTempStuckInfoFromJsonValue(const Json::Value &values, TempStuckInfo *tem
         LOG(ERROR) << "Minimum stuck duration not present.";
         return false;
     }
-    int min_stuck_duration_int = getIntFromValue(values["MinStuckDuration"]);
-    if (min_stuck_duration_int <= 0) {
+    int min_stuck_duration_int = 0;
+    if (!getIntFromValue(values["MinStuckDuration"], &min_stuck_duration_int) ||
+        min_stuck_duration_int <= 0) {
         LOG(ERROR) << "Invalid Minimum stuck duration " << min_stuck_duration_int;
         return false;
     }
@@ -162,8 +188,9 @@ bool getTempStuckInfoFromJsonValue(const Json::Value &values, TempStuckInfo *tem
         LOG(ERROR) << "Minimum polling count not present.";
         return false;
     }
-    int min_polling_count = getIntFromValue(values["MinPollingCount"]);
-    if (min_polling_count <= 0) {
+    int min_polling_count = 0;
+    if (!getIntFromValue(values["MinPollingCount"], &min_polling_count) ||
+        min_polling_count <= 0) {
         LOG(ERROR) << "Invalid Minimum stuck duration " << min_polling_count;
         return false;
     }
@@ -427,8 +454,8 @@ bool ParseBindedCdevInfo(const Json::Value &values,
             }
 
             if (!values[j]["MaxReleaseStep"].empty()) {
-                max_release_step = getIntFromValue(values[j]["MaxReleaseStep"]);
-                if (max_release_step < 0) {
+                if (!getIntFromValue(values[j]["MaxReleaseStep"], &max_release_step) ||
+                    max_release_step < 0) {
                     LOG(ERROR) << cdev_name << " MaxReleaseStep: " << max_release_step;
                     binded_cdev_info_map->clear();
                     return false;
@@ -437,8 +464,8 @@ bool ParseBindedCdevInfo(const Json::Value &values,
                 }
             }
             if (!values[j]["MaxThrottleStep"].empty()) {
-                max_throttle_step = getIntFromValue(values[j]["MaxThrottleStep"]);
-                if (max_throttle_step < 0) {
+                if (!getIntFromValue(values[j]["MaxThrottleStep"], &max_throttle_step) ||
+                    max_throttle_step < 0) {
                     LOG(ERROR) << cdev_name << " MaxThrottleStep: " << max_throttle_step;
                     binded_cdev_info_map->clear();
                     return false;
@@ -452,6 +479,7 @@ bool ParseBindedCdevInfo(const Json::Value &values,
         ThrottlingArray power_thresholds;
         power_thresholds.fill(NAN);
         ReleaseLogic release_logic = ReleaseLogic::NONE;
+        int release_step_limit = std::numeric_limits<int>::max();
 
         sub_values = values[j]["LimitInfo"];
         if (sub_values.size()) {
@@ -516,6 +544,15 @@ bool ParseBindedCdevInfo(const Json::Value &values,
                 } else if (values[j]["ReleaseLogic"].asString() == "RELEASE_TO_FLOOR") {
                     release_logic = ReleaseLogic::RELEASE_TO_FLOOR;
                     LOG(INFO) << "Release logic: RELEASE_TO_FLOOR";
+                } else if (values[j]["ReleaseLogic"].asString() == "PREDICTIVE") {
+                    release_logic = ReleaseLogic::PREDICTIVE;
+                    LOG(INFO) << "Release logic: PREDICTIVE";
+                    if (high_power_check) {
+                        LOG(ERROR) << cdev_name << " PREDICTIVE release needs the power to stay "
+                                   << "under its threshold, HighPowerCheck is not supported";
+                        binded_cdev_info_map->clear();
+                        return false;
+                    }
                 } else {
                     LOG(ERROR) << "Release logic is invalid";
                     binded_cdev_info_map->clear();
@@ -523,6 +560,15 @@ bool ParseBindedCdevInfo(const Json::Value &values,
                 }
             }
         }
+        if (!values[j]["ReleaseStepLimit"].empty()) {
+            if (!getIntFromValue(values[j]["ReleaseStepLimit"], &release_step_limit) ||
+                release_step_limit <= 0) {
+                LOG(ERROR) << cdev_name << " ReleaseStepLimit: " << release_step_limit;
+                binded_cdev_info_map->clear();
+                return false;
+            }
+            LOG(INFO) << cdev_name << " ReleaseStepLimit: " << release_step_limit;
+        }
         if (values[j]["Disabled"].asBool()) {
             enabled = false;
         }
@@ -531,6 +577,7 @@ bool ParseBindedCdevInfo(const Json::Value &values,
                 .limit_info = limit_info,
                 .power_thresholds = power_thresholds,
                 .release_logic = release_logic,
+                .release_step_limit = release_step_limit,
                 .cdev_weight_for_pid = cdev_weight_for_pid,
                 .cdev_ceiling = cdev_ceiling,
                 .max_release_step = max_release_step,
@@ -636,10 +683,19 @@ bool ParseSensorThrottlingInfo(const std::string_view name, const Json::Value &s
             LOG(ERROR) << "Sensor[" << name << "]: Failed to parse I_Cutoff";
             return false;
         }
-        i_default = getFloatFromValue(sensor["PIDInfo"]["I_Default"]);
+        if (!getFloatFromValue(sensor["PIDInfo"]["I_Default"], &i_default)) {
+            LOG(ERROR) << "Sensor[" << name << "]: Failed to parse I_Default";
+            return false;
+        }
         LOG(INFO) << "Sensor[" << name << "]'s I_Default: " << i_default;
 
-        tran_cycle = getFloatFromValue(sensor["PIDInfo"]["TranCycle"]);
+        float tran_cycle_value = 0;
+        if (!getFloatFromValue(sensor["PIDInfo"]["TranCycle"], &tran_cycle_value) ||
+            std::isnan(tran_cycle_value)) {
+            LOG(ERROR) << "Sensor[" << name << "]: Failed to parse TranCycle";
+            return false;
+        }
+        tran_cycle = static_cast<int>(tran_cycle_value);
         LOG(INFO) << "Sensor[" << name << "]'s TranCycle: " << tran_cycle;
 
         // Confirm we have at least one valid PID combination
@@ -817,7 +873,11 @@ bool ParseSensorInfo(const Json::Value &config,
         } else {
             float min = std::numeric_limits<float>::min();
             for (Json::Value::ArrayIndex j = 0; j < kThrottlingSeverityCount; ++j) {
-                hot_thresholds[j] = getFloatFromValue(values[j]);
+                if (!getFloatFromValue(values[j], &hot_thresholds[j])) {
+                    LOG(ERROR) << "Invalid Sensor[" << name << "]'s HotThreshold[" << j << "]";
+                    sensors_parsed->clear();
+                    return false;
+                }
                 if (!std::isnan(hot_thresholds[j])) {
                     if (hot_thresholds[j] < min) {
                         LOG(ERROR) << "Invalid "
@@ -842,8 +902,8 @@ bool ParseSensorInfo(const Json::Value &config,
             return false;
         } else {
             for (Json::Value::ArrayIndex j = 0; j < kThrottlingSeverityCount; ++j) {
-                hot_hysteresis[j] = getFloatFromValue(values[j]);
-                if (std::isnan(hot_hysteresis[j])) {
+                if (!getFloatFromValue(values[j], &hot_hysteresis[j]) ||
+                    std::isnan(hot_hysteresis[j])) {
                     LOG(ERROR) << "Invalid Sensor[" << name
                                << "]'s HotHysteresis: " << hot_hysteresis[j];
                     sensors_parsed->clear();
@@ -882,7 +942,11 @@ bool ParseSensorInfo(const Json::Value &config,
         } else {
             float max = std::numeric_limits<float>::max();
             for (Json::Value::ArrayIndex j = 0; j < kThrottlingSeverityCount; ++j) {
-                cold_thresholds[j] = getFloatFromValue(values[j]);
+                if (!getFloatFromValue(values[j], &cold_thresholds[j])) {
+                    LOG(ERROR) << "Invalid Sensor[" << name << "]'s ColdThreshold[" << j << "]";
+                    sensors_parsed->clear();
+                    return false;
+                }
                 if (!std::isnan(cold_thresholds[j])) {
                     if (cold_thresholds[j] > max) {
                         LOG(ERROR) << "Invalid "
@@ -907,8 +971,8 @@ bool ParseSensorInfo(const Json::Value &config,
             return false;
         } else {
             for (Json::Value::ArrayIndex j = 0; j < kThrottlingSeverityCount; ++j) {
-                cold_hysteresis[j] = getFloatFromValue(values[j]);
-                if (std::isnan(cold_hysteresis[j])) {
+                if (!getFloatFromValue(values[j], &cold_hysteresis[j]) ||
+                    std::isnan(cold_hysteresis[j])) {
                     LOG(ERROR) << "Invalid Sensor[" << name
                                << "]'s ColdHysteresis: " << cold_hysteresis[j];
                     sensors_parsed->clear();
@@ -954,7 +1018,11 @@ bool ParseSensorInfo(const Json::Value &config,
 
         float vr_threshold = NAN;
         if (!sensors[i]["VrThreshold"].empty()) {
-            vr_threshold = getFloatFromValue(sensors[i]["VrThreshold"]);
+            if (!getFloatFromValue(sensors[i]["VrThreshold"], &vr_threshold)) {
+                LOG(ERROR) << "Invalid Sensor[" << name << "]'s VrThreshold";
+                sensors_parsed->clear();
+                return false;
+            }
             LOG(INFO) << "Sensor[" << name << "]'s VrThreshold: " << vr_threshold;
         }
         float multiplier = sensors[i]["Multiplier"].asFloat();
@@ -962,7 +1030,12 @@ bool ParseSensorInfo(const Json::Value &config,
 
         std::chrono::milliseconds polling_delay = kUeventPollTimeoutMs;
         if (!sensors[i]["PollingDelay"].empty()) {
-            const auto value = getIntFromValue(sensors[i]["PollingDelay"]);
+            int value = 0;
+            if (!getIntFromValue(sensors[i]["PollingDelay"], &value)) {
+                LOG(ERROR) << "Invalid Sensor[" << name << "]'s PollingDelay";
+                sensors_parsed->clear();
+                return false;
+            }
             polling_delay = (value > 0) ? std::chrono::milliseconds(value)
                                         : std::chrono::milliseconds::max();
         }
@@ -970,18 +1043,40 @@ bool ParseSensorInfo(const Json::Value &config,
 
         std::chrono::milliseconds passive_delay = kMinPollIntervalMs;
         if (!sensors[i]["PassiveDelay"].empty()) {
-            const auto value = getIntFromValue(sensors[i]["PassiveDelay"]);
+            int value = 0;
+            if (!getIntFromValue(sensors[i]["PassiveDelay"], &value)) {
+                LOG(ERROR) << "Invalid Sensor[" << name << "]'s PassiveDelay";
+                sensors_parsed->clear();
+                return false;
+            }
             passive_delay = (value > 0) ? std::chrono::milliseconds(value)
                                         : std::chrono::milliseconds::max();
         }
         LOG(INFO) << "Sensor[" << name << "]'s Passive delay: " << passive_delay.count();
 
+        std::chrono::milliseconds polling_slack = std::chrono::milliseconds::zero();
+        if (!sensors[i]["PollingSlack"].empty()) {
+            int value = 0;
+            if (!getIntFromValue(sensors[i]["PollingSlack"], &value) || value < 0) {
+                LOG(ERROR) << "Sensor[" << name << "]'s PollingSlack should not be negative";
+                sensors_parsed->clear();
+                return false;
+            }
+            polling_slack = std::chrono::milliseconds(value);
+        }
+        LOG(INFO) << "Sensor[" << name << "]'s Polling slack: " << polling_slack.count();
+
         std::chrono::milliseconds time_resolution;
         if (sensors[i]["TimeResolution"].empty()) {
             time_resolution = kMinPollIntervalMs;
         } else {
-            time_resolution =
-                    std::chrono::milliseconds(getIntFromValue(sensors[i]["TimeResolution"]));
+            int value = 0;
+            if (!getIntFromValue(sensors[i]["TimeResolution"], &value)) {
+                LOG(ERROR) << "Invalid Sensor[" << name << "]'s TimeResolution";
+                sensors_parsed->clear();
+                return false;
+            }
+            time_resolution = std::chrono::milliseconds(value);
         }
         LOG(INFO) << "Sensor[" << name << "]'s Time resolution: " << time_resolution.count();
 
@@ -995,6 +1090,17 @@ bool ParseSensorInfo(const Json::Value &config,
             }
         }
 
+        float change_epsilon = NAN;
+        if (!sensors[i]["ChangeEpsilon"].empty()) {
+            if (!getFloatFromValue(sensors[i]["ChangeEpsilon"], &change_epsilon) ||
+                std::isnan(change_epsilon) || change_epsilon < 0) {
+                LOG(ERROR) << "Sensor[" << name << "]'s ChangeEpsilon should not be negative";
+                sensors_parsed->clear();
+                return false;
+            }
+            LOG(INFO) << "Sensor[" << name << "]'s ChangeEpsilon: " << change_epsilon;
+        }
+
         if (is_hidden && send_cb) {
             LOG(ERROR) << "is_hidden and send_cb cannot be enabled together";
             sensors_parsed->clear();
@@ -1031,8 +1137,10 @@ bool ParseSensorInfo(const Json::Value &config,
                 .multiplier = multiplier,
                 .polling_delay = polling_delay,
                 .passive_delay = passive_delay,
+                .polling_slack = polling_slack,
                 .time_resolution = time_resolution,
                 .step_ratio = step_ratio,
+                .change_epsilon = change_epsilon,
                 .send_cb = send_cb,
                 .send_powerhint = send_powerhint,
                 .is_watch = is_watch,
@@ -1091,7 +1199,12 @@ bool ParseCoolingDevice(const Json::Value &config,
         if (values.size()) {
             state2power.reserve(values.size());
             for (Json::Value::ArrayIndex j = 0; j < values.size(); ++j) {
-                state2power.emplace_back(getFloatFromValue(values[j]));
+                if (!getFloatFromValue(values[j], &state2power.emplace_back())) {
+                    LOG(ERROR) << "Invalid CoolingDevice[" << name << "]'s State2Power[" << j
+                               << "]";
+                    cooling_devices_parsed->clear();
+                    return false;
+                }
                 LOG(INFO) << "Cooling device[" << name << "]'s Power2State[" << j
                           << "]: " << state2power[j];
             }
@@ -1103,11 +1216,26 @@ bool ParseCoolingDevice(const Json::Value &config,
         const std::string &power_rail = cooling_devices[i]["PowerRail"].asString();
         LOG(INFO) << "Cooling device power rail : " << power_rail;
 
+        const std::string &freq_domain = cooling_devices[i]["FreqDomain"].asString();
+        if (!freq_domain.empty()) {
+            LOG(INFO) << "Cooling device[" << name << "]'s FreqDomain: " << freq_domain;
+        }
+
+        bool hal_owned = false;
+        if (!cooling_devices[i]["HalOwned"].empty() && cooling_devices[i]["HalOwned"].isBool()) {
+            hal_owned = cooling_devices[i]["HalOwned"].asBool();
+        }
+        LOG(INFO) << "Cooling device[" << name << "]'s HalOwned: " << std::boolalpha << hal_owned
+                  << std::noboolalpha;
+
         (*cooling_devices_parsed)[name] = {
                 .type = cooling_device_type,
                 .read_path = read_path,
                 .write_path = write_path,
                 .state2power = state2power,
+                .max_state = 0,
+                .freq_domain = freq_domain,
+                .hal_owned = hal_owned,
         };
         ++total_parsed;
     }
@@ -1163,7 +1291,12 @@ bool ParsePowerRailInfo(const Json::Value &config,
             if (values.size()) {
                 coefficient.reserve(values.size());
                 for (Json::Value::ArrayIndex j = 0; j < values.size(); ++j) {
-                    coefficient.emplace_back(getFloatFromValue(values[j]));
+                    if (!getFloatFromValue(values[j], &coefficient.emplace_back())) {
+                        LOG(ERROR) << "Invalid PowerRail[" << name << "]'s coefficient[" << j
+                                   << "]";
+                        power_rails_parsed->clear();
+                        return false;
+                    }
                     LOG(INFO) << "PowerRail[" << name << "]'s coefficient[" << j
                               << "]: " << coefficient[j];
                 }
@@ -1218,8 +1351,13 @@ bool ParsePowerRailInfo(const Json::Value &config,
         if (!power_rails[i]["PowerSampleDelay"]) {
             power_sample_delay = std::chrono::milliseconds::max();
         } else {
-            power_sample_delay =
-                    std::chrono::milliseconds(getIntFromValue(power_rails[i]["PowerSampleDelay"]));
+            int value = 0;
+            if (!getIntFromValue(power_rails[i]["PowerSampleDelay"], &value)) {
+                LOG(ERROR) << "Invalid PowerRail[" << name << "]'s PowerSampleDelay";
+                power_rails_parsed->clear();
+                return false;
+            }
+            power_sample_delay = std::chrono::milliseconds(value);
         }
 
         (*power_rails_parsed)[name] = {
@@ -1307,9 +1445,16 @@ bool ParseStatsInfo(const Json::Value &stats_config,
             T prev_value = min_value;
             LOG(INFO) << "Thresholds:";
             for (Json::Value::ArrayIndex i = 0; i < threshold_values_count; ++i) {
-                stats_threshold[i] = std::is_floating_point_v<T>
-                                             ? getFloatFromValue(threshold_values[i])
-                                             : getIntFromValue(threshold_values[i]);
+                bool parsed = false;
+                if constexpr (std::is_floating_point_v<T>) {
+                    parsed = getFloatFromValue(threshold_values[i], &stats_threshold[i]);
+                } else {
+                    parsed = getIntFromValue(threshold_values[i], &stats_threshold[i]);
+                }
+                if (!parsed) {
+                    LOG(ERROR) << "Invalid stats threshold[" << i << "]";
+                    return false;
+                }
                 if (stats_threshold[i] <= prev_value) {
                     LOG(ERROR) << "Invalid array[" << i << "]" << stats_threshold[i]
                                << " is <=" << prev_value;
@@ -12,6 +12,7 @@
 #include <json/value.h>
 
 #include <chrono>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -146,6 +147,7 @@ enum class ReleaseLogic : uint32_t {
     DECREASE,          // Decrease throttling by step
     STEPWISE,          // Support both increase and decrease logix
     RELEASE_TO_FLOOR,  // Release throttling to floor directly
+    PREDICTIVE,        // Release as far as the forecast and power headroom allow
     NONE,
 };
 
@@ -153,6 +155,8 @@ struct BindedCdevInfo {
     CdevArray limit_info;
     ThrottlingArray power_thresholds;
     ReleaseLogic release_logic;
+    // The most states a PREDICTIVE release moves per update
+    int release_step_limit;
     ThrottlingArray cdev_weight_for_pid;
     CdevArray cdev_ceiling;
     int max_release_step;
@@ -198,10 +202,15 @@ struct SensorInfo {
     float multiplier;
     std::chrono::milliseconds polling_delay;
     std::chrono::milliseconds passive_delay;
+    // How late the sensor may be polled, so its polling can share a wakeup with other sensors
+    std::chrono::milliseconds polling_slack;
     std::chrono::milliseconds time_resolution;
     // The StepRatio value which is used for smoothing transient w/ the equation:
     // Temp = CurrentTemp * StepRatio + LastTemp * (1 - StepRatio)
     float step_ratio;
+    // Throttling is only recomputed once the temperature moved more than ChangeEpsilon, or
+    // another input changed, since the last computation. NAN recomputes on every update.
+    float change_epsilon;
     bool send_cb;
     bool send_powerhint;
     bool is_watch;
@@ -216,6 +225,10 @@ struct CdevInfo {
     std::string write_path;
     std::vector<float> state2power;
     int max_state;
+    // cpufreq policy or devfreq device directory, to cap its frequency instead of a kernel cdev
+    std::string freq_domain;
+    // Whether only the HAL writes the state, so it is kept from the writes instead of read back
+    bool hal_owned;
 };
 
 struct PowerRailInfo {
@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "thermal_plan.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+namespace {
+
+using IndexMap = std::unordered_map<std::string, size_t>;
+
+template <typename T>
+void BuildIndex(const std::unordered_map<std::string, T> &info_map,
+                std::vector<std::string> *names, IndexMap *index_map) {
+    names->clear();
+    for (const auto &[name, info] : info_map) {
+        names->push_back(name);
+    }
+    std::sort(names->begin(), names->end());
+    for (size_t i = 0; i < names->size(); ++i) {
+        (*index_map)[(*names)[i]] = i;
+    }
+}
+
+size_t FindIndex(const IndexMap &index_map, const std::string &name) {
+    const auto it = index_map.find(name);
+    return (it == index_map.end()) ? kInvalidPlanIndex : it->second;
+}
+
+void ResolveBindings(const std::string &sensor_name, const std::string &scope,
+                     const std::unordered_map<std::string, BindedCdevInfo> &binded_cdev_info_map,
+                     const IndexMap &cdev_index_map, const IndexMap &power_rail_index_map,
+                     std::vector<PlanBinding> *bindings, std::vector<std::string> *errors) {
+    // Bindings in cooling device name order
+    std::map<std::string, const BindedCdevInfo *> sorted_bindings;
+    for (const auto &[cdev_name, binded_cdev_info] : binded_cdev_info_map) {
+        sorted_bindings[cdev_name] = &binded_cdev_info;
+    }
+    for (const auto &[cdev_name, binded_cdev_info] : sorted_bindings) {
+        PlanBinding binding = {FindIndex(cdev_index_map, cdev_name), kInvalidPlanIndex};
+        if (binding.cdev == kInvalidPlanIndex) {
+            errors->push_back("Sensor[" + sensor_name + "]'s " + scope + "binded CDEV " +
+                              cdev_name + " is not defined");
+        }
+        if (!binded_cdev_info->power_rail.empty()) {
+            binding.power_rail = FindIndex(power_rail_index_map, binded_cdev_info->power_rail);
+            if (binding.power_rail == kInvalidPlanIndex) {
+                errors->push_back("Sensor[" + sensor_name + "]'s " + scope + "binded CDEV " +
+                                  cdev_name + " links undefined power rail " +
+                                  binded_cdev_info->power_rail);
+            }
+        }
+        bindings->push_back(binding);
+    }
+}
+
+// Depth first post-order of the dependency graph, a cycle is reported at the entry closing it
+void ComputeEvaluationOrder(std::string_view kind, const std::vector<std::string> &names,
+                            const std::vector<std::vector<size_t>> &dependencies,
+                            std::vector<size_t> *order, std::vector<std::string> *errors) {
+    enum class VisitState { NONE, VISITING, VISITED };
+    std::vector<VisitState> states(names.size(), VisitState::NONE);
+    order->clear();
+
+    std::function<bool(size_t)> visit = [&](size_t index) {
+        if (states[index] == VisitState::VISITED) {
+            return true;
+        }
+        if (states[index] == VisitState::VISITING) {
+            errors->push_back(std::string(kind) + "[" + names[index] +
+                              "] is part of a dependency cycle");
+            return false;
+        }
+        states[index] = VisitState::VISITING;
+        bool ret = true;
+        for (const auto dependency : dependencies[index]) {
+            if (!visit(dependency)) {
+                ret = false;
+                break;
+            }
+        }
+        states[index] = VisitState::VISITED;
+        order->push_back(index);
+        return ret;
+    };
+
+    for (size_t i = 0; i < names.size(); ++i) {
+        visit(i);
+    }
+}
+
+}  // namespace
+
+bool CompileControlPlan(const std::unordered_map<std::string, SensorInfo> &sensor_info_map,
+                        const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map,
+                        const std::unordered_map<std::string, PowerRailInfo> &power_rail_info_map,
+                        ControlPlan *plan, std::vector<std::string> *errors) {
+    const size_t error_count = errors->size();
+    IndexMap sensor_index_map;
+    IndexMap cdev_index_map;
+    IndexMap power_rail_index_map;
+    *plan = {};
+    BuildIndex(sensor_info_map, &plan->sensor_names, &sensor_index_map);
+    BuildIndex(cooling_device_info_map, &plan->cdev_names, &cdev_index_map);
+    BuildIndex(power_rail_info_map, &plan->power_rail_names, &power_rail_index_map);
+
+    plan->power_rails.resize(plan->power_rail_names.size());
+    std::vector<std::vector<size_t>> power_rail_dependencies(plan->power_rail_names.size());
+    for (size_t i = 0; i < plan->power_rail_names.size(); ++i) {
+        const auto &name = plan->power_rail_names[i];
+        const auto &power_rail_info = power_rail_info_map.at(name);
+        if (power_rail_info.virtual_power_rail_info == nullptr) {
+            continue;
+        }
+        for (const auto &linked_power_rail :
+             power_rail_info.virtual_power_rail_info->linked_power_rails) {
+            // A name which is not a power rail is an energy channel, checked on the device
+            const size_t index = FindIndex(power_rail_index_map, linked_power_rail);
+            if (index == kInvalidPlanIndex) {
+                plan->power_rails[i].energy_channels.push_back(linked_power_rail);
+                continue;
+            }
+            plan->power_rails[i].linked_power_rails.push_back(index);
+            power_rail_dependencies[i].push_back(index);
+        }
+    }
+
+    plan->sensors.resize(plan->sensor_names.size());
+    std::vector<std::vector<size_t>> sensor_dependencies(plan->sensor_names.size());
+    for (size_t i = 0; i < plan->sensor_names.size(); ++i) {
+        const auto &name = plan->sensor_names[i];
+        const auto &sensor_info = sensor_info_map.at(name);
+        auto &plan_sensor = plan->sensors[i];
+
+        if (sensor_info.virtual_sensor_info != nullptr) {
+            const auto &virtual_sensor_info = *sensor_info.virtual_sensor_info;
+            for (size_t j = 0; j < virtual_sensor_info.linked_sensors.size(); ++j) {
+                const auto &linked_sensor = virtual_sensor_info.linked_sensors[j];
+                switch (virtual_sensor_info.linked_sensors_type[j]) {
+                    case SensorFusionType::SENSOR: {
+                        const size_t index = FindIndex(sensor_index_map, linked_sensor);
+                        if (index == kInvalidPlanIndex) {
+                            errors->push_back("Sensor[" + name + "]'s linked sensor " +
+                                              linked_sensor + " is not defined");
+                            break;
+                        }
+                        plan_sensor.linked_sensors.push_back(index);
+                        sensor_dependencies[i].push_back(index);
+                        break;
+                    }
+                    case SensorFusionType::ODPM: {
+                        const size_t index = FindIndex(power_rail_index_map, linked_sensor);
+                        if (index == kInvalidPlanIndex) {
+                            errors->push_back("Sensor[" + name + "]'s linked power rail " +
+                                              linked_sensor + " is not defined");
+                            break;
+                        }
+                        plan_sensor.linked_power_rails.push_back(index);
+                        break;
+                    }
+                    default:
+                        break;
+                }
+            }
+            // Trigger sensors are only required by the watched sensors, as at runtime
+            for (const auto &trigger_sensor : virtual_sensor_info.trigger_sensors) {
+                const size_t index = FindIndex(sensor_index_map, trigger_sensor);
+                if (index != kInvalidPlanIndex) {
+                    plan_sensor.trigger_sensors.push_back(index);
+                } else if (sensor_info.is_watch) {
+                    errors->push_back("Sensor[" + name + "]'s trigger sensor " + trigger_sensor +
+                                      " is not defined");
+                }
+            }
+        }
+
+        if (sensor_info.throttling_info == nullptr) {
+            continue;
+        }
+        const auto &throttling_info = *sensor_info.throttling_info;
+        ResolveBindings(name, "", throttling_info.binded_cdev_info_map, cdev_index_map,
+                        power_rail_index_map, &plan_sensor.bindings, errors);
+        std::map<std::string, size_t> sorted_excluded_power_rails;
+        for (const auto &[excluded_power_rail, excluded_power_info] :
+             throttling_info.excluded_power_info_map) {
+            sorted_excluded_power_rails[excluded_power_rail] =
+                    FindIndex(power_rail_index_map, excluded_power_rail);
+        }
+        for (const auto &[excluded_power_rail, index] : sorted_excluded_power_rails) {
+            if (index == kInvalidPlanIndex) {
+                errors->push_back("Sensor[" + name + "]'s excluded power rail " +
+                                  excluded_power_rail + " is not defined");
+                continue;
+            }
+            plan_sensor.excluded_power_rails.push_back(index);
+        }
+        std::map<std::string, const std::unordered_map<std::string, BindedCdevInfo> *>
+                sorted_profiles;
+        for (const auto &[profile, binded_cdev_info_map] : throttling_info.profile_map) {
+            sorted_profiles[profile] = &binded_cdev_info_map;
+        }
+        for (const auto &[profile, binded_cdev_info_map] : sorted_profiles) {
+            plan_sensor.profiles.emplace_back(profile, std::vector<PlanBinding>());
+            ResolveBindings(name, "profile " + profile + " ", *binded_cdev_info_map,
+                            cdev_index_map, power_rail_index_map,
+                            &plan_sensor.profiles.back().second, errors);
+        }
+    }
+
+    ComputeEvaluationOrder("Sensor", plan->sensor_names, sensor_dependencies,
+                           &plan->sensor_order, errors);
+    ComputeEvaluationOrder("PowerRail", plan->power_rail_names, power_rail_dependencies,
+                           &plan->power_rail_order, errors);
+    return errors->size() == error_count;
+}
+
+size_t GetControlPlanSize(const ControlPlan &plan) {
+    size_t size = plan.sensors.size() + plan.cdev_names.size() + plan.power_rails.size();
+    for (const auto &plan_sensor : plan.sensors) {
+        size += plan_sensor.linked_sensors.size() + plan_sensor.linked_power_rails.size() +
+                plan_sensor.trigger_sensors.size() + plan_sensor.bindings.size() +
+                plan_sensor.excluded_power_rails.size();
+        for (const auto &[profile, bindings] : plan_sensor.profiles) {
+            size += bindings.size();
+        }
+    }
+    for (const auto &plan_power_rail : plan.power_rails) {
+        size += plan_power_rail.linked_power_rails.size();
+    }
+    return size;
+}
+
+void DumpControlPlan(const ControlPlan &plan, std::ostream *os) {
+    *os << "ControlPlan: sensors: " << plan.sensors.size() << " cdevs: " << plan.cdev_names.size()
+        << " power rails: " << plan.power_rails.size() << " size: " << GetControlPlanSize(plan)
+        << std::endl;
+    for (const auto i : plan.sensor_order) {
+        const auto &plan_sensor = plan.sensors[i];
+        *os << " Sensor[" << i << "] " << plan.sensor_names[i] << ":";
+        if (!plan_sensor.linked_sensors.empty()) {
+            *os << " linked sensors:";
+            for (const auto index : plan_sensor.linked_sensors) {
+                *os << " " << index;
+            }
+        }
+        if (!plan_sensor.linked_power_rails.empty()) {
+            *os << " linked power rails:";
+            for (const auto index : plan_sensor.linked_power_rails) {
+                *os << " " << index;
+            }
+        }
+        if (!plan_sensor.trigger_sensors.empty()) {
+            *os << " trigger sensors:";
+            for (const auto index : plan_sensor.trigger_sensors) {
+                *os << " " << index;
+            }
+        }
+        if (!plan_sensor.bindings.empty()) {
+            *os << " cdevs:";
+            for (const auto &binding : plan_sensor.bindings) {
+                *os << " " << binding.cdev;
+                if (binding.power_rail != kInvalidPlanIndex) {
+                    *os << "@" << binding.power_rail;
+                }
+            }
+        }
+        if (!plan_sensor.excluded_power_rails.empty()) {
+            *os << " excluded power rails:";
+            for (const auto index : plan_sensor.excluded_power_rails) {
+                *os << " " << index;
+            }
+        }
+        for (const auto &[profile, bindings] : plan_sensor.profiles) {
+            *os << " profile " << profile << ": " << bindings.size() << " cdevs";
+        }
+        *os << std::endl;
+    }
+    for (const auto i : plan.power_rail_order) {
+        *os << " PowerRail[" << i << "] " << plan.power_rail_names[i];
+        if (!plan.power_rails[i].linked_power_rails.empty()) {
+            *os << " linked power rails:";
+            for (const auto index : plan.power_rails[i].linked_power_rails) {
+                *os << " " << index;
+            }
+        }
+        if (!plan.power_rails[i].energy_channels.empty()) {
+            *os << " energy channels:";
+            for (const auto &energy_channel : plan.power_rails[i].energy_channels) {
+                *os << " " << energy_channel;
+            }
+        }
+        *os << std::endl;
+    }
+    for (size_t i = 0; i < plan.cdev_names.size(); ++i) {
+        *os << " Cdev[" << i << "] " << plan.cdev_names[i] << std::endl;
+    }
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <limits>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "thermal_info.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+constexpr size_t kInvalidPlanIndex = std::numeric_limits<size_t>::max();
+
+// A cooling device bound to a throttling sensor
+struct PlanBinding {
+    size_t cdev;
+    // kInvalidPlanIndex if the binding has no power link
+    size_t power_rail;
+};
+
+struct PlanSensor {
+    // Inputs of a virtual sensor, by fusion type
+    std::vector<size_t> linked_sensors;
+    std::vector<size_t> linked_power_rails;
+    std::vector<size_t> trigger_sensors;
+    std::vector<PlanBinding> bindings;
+    std::vector<size_t> excluded_power_rails;
+    // The bindings of each throttling profile, in profile name order
+    std::vector<std::pair<std::string, std::vector<PlanBinding>>> profiles;
+};
+
+struct PlanPowerRail {
+    std::vector<size_t> linked_power_rails;
+    std::vector<std::string> energy_channels;
+};
+
+// The configuration with every cross-reference resolved to an index. Names are sorted, so the
+// same configuration always compiles to the same plan. The plan validates a config, at init,
+// on reload and in the config compiler. The HAL keeps the plan of its init config, a reload
+// cannot change the references, and its watcher walks the sensors by plan index.
+struct ControlPlan {
+    std::vector<std::string> sensor_names;
+    std::vector<std::string> cdev_names;
+    std::vector<std::string> power_rail_names;
+    std::vector<PlanSensor> sensors;
+    std::vector<PlanPowerRail> power_rails;
+    // Evaluation orders, every input comes before the entries reading it
+    std::vector<size_t> sensor_order;
+    std::vector<size_t> power_rail_order;
+};
+
+// Resolve the references between the parsed sensors, cooling devices and power rails. All the
+// errors are collected instead of stopping at the first one. Return false on any error.
+bool CompileControlPlan(const std::unordered_map<std::string, SensorInfo> &sensor_info_map,
+                        const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map,
+                        const std::unordered_map<std::string, PowerRailInfo> &power_rail_info_map,
+                        ControlPlan *plan, std::vector<std::string> *errors);
+// Number of entries and resolved references of the plan
+size_t GetControlPlanSize(const ControlPlan &plan);
+void DumpControlPlan(const ControlPlan &plan, std::ostream *os);
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
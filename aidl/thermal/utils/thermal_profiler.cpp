@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "thermal_profiler.h"
+
+#include <android-base/logging.h>
+#include <time.h>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+namespace {
+
+std::chrono::nanoseconds getThreadCpuTime() {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return std::chrono::nanoseconds::zero();
+    }
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+int64_t toUs(std::chrono::nanoseconds duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+}  // namespace
+
+void ThermalProfiler::setEnabled(bool enabled) {
+    if (enabled && !isEnabled()) {
+        enabled_time_ = boot_clock::now();
+        last_log_time_ = enabled_time_;
+    }
+    LOG(INFO) << "Thermal profiling " << (enabled ? "enabled" : "disabled");
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void ThermalProfiler::beginTick() {
+    in_tick_ = isEnabled();
+    if (!in_tick_) {
+        return;
+    }
+    tick_start_time_ = boot_clock::now();
+    tick_cpu_start_time_ = getThreadCpuTime();
+    tick_stage_ns_.fill(0);
+    tick_sysfs_ops_.store(0, std::memory_order_relaxed);
+}
+
+void ThermalProfiler::endTick() {
+    if (!in_tick_) {
+        return;
+    }
+    in_tick_ = false;
+    const auto now = boot_clock::now();
+    const int64_t cpu_us = toUs(getThreadCpuTime() - tick_cpu_start_time_);
+    const uint32_t sysfs_ops = tick_sysfs_ops_.load(std::memory_order_relaxed);
+
+    tick_duration_histogram_.record(toUs(now - tick_start_time_));
+    tick_cpu_histogram_.record(cpu_us);
+    tick_sysfs_ops_histogram_.record(sysfs_ops);
+    for (size_t i = 0; i < kProfileStageCount; ++i) {
+        if (tick_stage_ns_[i]) {
+            const int64_t stage_us = toUs(std::chrono::nanoseconds(tick_stage_ns_[i]));
+            stage_histograms_[i].record(stage_us);
+            stage_total_us_[i].fetch_add(stage_us, std::memory_order_relaxed);
+        }
+    }
+    tick_count_.fetch_add(1, std::memory_order_relaxed);
+    total_cpu_us_.fetch_add(cpu_us, std::memory_order_relaxed);
+    total_sysfs_ops_.fetch_add(sysfs_ops, std::memory_order_relaxed);
+
+    if (now - last_log_time_ >= kProfileLogIntervalMs) {
+        logSummary(now);
+        last_log_time_ = now;
+    }
+}
+
+void ThermalProfiler::logSummary(boot_clock::time_point now) {
+    const auto enabled_min =
+            std::chrono::duration_cast<std::chrono::minutes>(now - enabled_time_).count();
+    const uint64_t tick_count = tick_count_.load(std::memory_order_relaxed);
+    const auto tick_duration = tick_duration_histogram_.snapshot();
+    LOG(INFO) << "Thermal profile: ticks: " << tick_count << " in " << enabled_min << "min"
+              << " cpu: " << total_cpu_us_.load(std::memory_order_relaxed) / 1000 << "ms"
+              << " sysfs ops: " << total_sysfs_ops_.load(std::memory_order_relaxed)
+              << " tick p50: " << tick_duration.getPercentile(50) << "us"
+              << " p99: " << tick_duration.getPercentile(99) << "us";
+}
+
+void ThermalProfiler::dump(std::ostringstream *dump_buf) const {
+    *dump_buf << "getThermalProfile:" << std::endl;
+    if (!isEnabled()) {
+        *dump_buf << " Disabled" << std::endl;
+        return;
+    }
+    const auto enabled_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                    boot_clock::now() - enabled_time_)
+                                    .count();
+    const uint64_t tick_count = tick_count_.load(std::memory_order_relaxed);
+    *dump_buf << " Ticks: " << tick_count << " in " << enabled_ms << "ms";
+    if (tick_count) {
+        *dump_buf << " AvgCpu: " << total_cpu_us_.load(std::memory_order_relaxed) / tick_count
+                  << "us AvgSysfsOps: "
+                  << static_cast<float>(total_sysfs_ops_.load(std::memory_order_relaxed)) /
+                             tick_count;
+    }
+    *dump_buf << std::endl;
+
+    const auto dump_percentiles = [dump_buf](std::string_view name,
+                                             const HistogramSnapshot &histogram,
+                                             std::string_view unit) {
+        *dump_buf << "  " << name << ": count: " << histogram.count;
+        if (histogram.count) {
+            *dump_buf << " p50: " << histogram.getPercentile(50) << unit
+                      << " p95: " << histogram.getPercentile(95) << unit
+                      << " p99: " << histogram.getPercentile(99) << unit;
+        }
+    };
+    *dump_buf << " Tick:" << std::endl;
+    dump_percentiles("Duration", tick_duration_histogram_.snapshot(), "us");
+    *dump_buf << std::endl;
+    dump_percentiles("Cpu", tick_cpu_histogram_.snapshot(), "us");
+    *dump_buf << std::endl;
+    dump_percentiles("SysfsOps", tick_sysfs_ops_histogram_.snapshot(), "");
+    *dump_buf << std::endl;
+    *dump_buf << " Stages:" << std::endl;
+    for (size_t i = 0; i < kProfileStageCount; ++i) {
+        dump_percentiles(kProfileStageNames[i], stage_histograms_[i].snapshot(), "us");
+        *dump_buf << " total: " << stage_total_us_[i].load(std::memory_order_relaxed) << "us"
+                  << std::endl;
+    }
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
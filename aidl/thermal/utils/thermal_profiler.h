@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android-base/chrono_utils.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <string_view>
+
+#include "thermal_stats_helper.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+using ::android::base::boot_clock;
+
+constexpr std::chrono::milliseconds kProfileLogIntervalMs = std::chrono::milliseconds(600000);
+
+// Stages of a thermal watcher tick
+enum class ProfileStage : size_t {
+    READ = 0,
+    SEVERITY,
+    THROTTLING,
+    ACTUATION,
+    CALLBACK,
+    STATS,
+    NUM_STAGES,
+};
+
+constexpr size_t kProfileStageCount = static_cast<size_t>(ProfileStage::NUM_STAGES);
+constexpr std::array<std::string_view, kProfileStageCount> kProfileStageNames = {
+        "Read", "Severity", "Throttling", "Actuation", "Callback", "Stats"};
+
+// Cost of the thermal HAL itself: wakeups, CPU time and duration of the watcher ticks, and
+// sysfs operations. Ticks are only timed when enabled, the disabled cost is a relaxed load.
+class ThermalProfiler {
+  public:
+    ThermalProfiler() = default;
+    ~ThermalProfiler() = default;
+    // Disallow copy and assign
+    ThermalProfiler(const ThermalProfiler &) = delete;
+    void operator=(const ThermalProfiler &) = delete;
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Only called from the thermal watcher thread
+    void beginTick();
+    void endTick();
+    void addStageTime(ProfileStage stage, std::chrono::nanoseconds duration) {
+        tick_stage_ns_[static_cast<size_t>(stage)] += duration.count();
+    }
+    bool isTicking() const { return in_tick_; }
+
+    // Called on any thread for a sysfs read or write
+    void countSysfsOp() {
+        if (isEnabled()) {
+            tick_sysfs_ops_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    void dump(std::ostringstream *dump_buf) const;
+
+  private:
+    void logSummary(boot_clock::time_point now);
+
+    std::atomic<bool> enabled_ = false;
+    boot_clock::time_point enabled_time_;
+    boot_clock::time_point last_log_time_;
+
+    // State of the current tick, only touched by the watcher thread
+    bool in_tick_ = false;
+    boot_clock::time_point tick_start_time_;
+    std::chrono::nanoseconds tick_cpu_start_time_;
+    std::array<int64_t, kProfileStageCount> tick_stage_ns_{};
+    std::atomic<uint32_t> tick_sysfs_ops_ = 0;
+
+    // Microseconds
+    std::array<DurationHistogram, kProfileStageCount> stage_histograms_;
+    std::array<std::atomic<int64_t>, kProfileStageCount> stage_total_us_{};
+    DurationHistogram tick_duration_histogram_;
+    DurationHistogram tick_cpu_histogram_;
+    // Sysfs operations per tick
+    DurationHistogram tick_sysfs_ops_histogram_;
+    std::atomic<uint64_t> tick_count_ = 0;
+    std::atomic<int64_t> total_cpu_us_ = 0;
+    std::atomic<uint64_t> total_sysfs_ops_ = 0;
+};
+
+// Add the time spent in a scope to a stage of the current tick
+class ScopedProfileStage {
+  public:
+    ScopedProfileStage(ThermalProfiler *profiler, ProfileStage stage)
+        : profiler_(profiler->isTicking() ? profiler : nullptr), stage_(stage) {
+        if (profiler_ != nullptr) {
+            start_time_ = boot_clock::now();
+        }
+    }
+    ~ScopedProfileStage() {
+        if (profiler_ != nullptr) {
+            profiler_->addStageTime(stage_, boot_clock::now() - start_time_);
+        }
+    }
+    // Disallow copy and assign
+    ScopedProfileStage(const ScopedProfileStage &) = delete;
+    void operator=(const ScopedProfileStage &) = delete;
+
+  private:
+    ThermalProfiler *profiler_;
+    ProfileStage stage_;
+    boot_clock::time_point start_time_;
+};
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "thermal_sample_log.h"
+
+#include <android-base/logging.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+size_t ThermalSampleLog::getSourceIndex(std::string_view name) {
+    const auto it = source_index_map_.find(name.data());
+    if (it != source_index_map_.end()) {
+        return it->second;
+    }
+    source_names_.emplace_back(name);
+    source_index_map_[name.data()] = source_names_.size() - 1;
+    return source_names_.size() - 1;
+}
+
+void ThermalSampleLog::setSampleInputs(size_t sensor_index, std::vector<size_t> input_indices) {
+    if (sample_inputs_.size() <= sensor_index) {
+        sample_inputs_.resize(sensor_index + 1);
+    }
+    sample_inputs_[sensor_index] = std::move(input_indices);
+}
+
+void ThermalSampleLog::finalize() {
+    source_count_ = source_names_.size();
+    sample_inputs_.resize(source_count_);
+    values_.reset(new std::atomic<float>[source_count_]);
+    for (size_t i = 0; i < source_count_; ++i) {
+        values_[i].store(NAN, std::memory_order_relaxed);
+        input_width_ = std::max(input_width_, sample_inputs_[i].size());
+    }
+
+    std::lock_guard<std::mutex> _lock(sample_mutex_);
+    entries_.resize(kSampleLogCapacity);
+    input_values_.resize(kSampleLogCapacity * input_width_);
+    log_states_.resize(source_count_);
+    LOG(INFO) << "Sample log initialized with " << source_count_ << " sources, "
+              << kSampleLogCapacity << "x" << input_width_ << " inputs";
+}
+
+bool ThermalSampleLog::addSample(size_t sensor_index, float temp, ThrottlingSeverity severity,
+                                 std::string *log_line) {
+    if (sensor_index >= source_count_) {
+        return false;
+    }
+    const auto now = boot_clock::now();
+    std::lock_guard<std::mutex> _lock(sample_mutex_);
+    const size_t entry_index = next_entry_;
+    entries_[entry_index] = {sensor_index, now, temp, severity};
+    const auto &inputs = sample_inputs_[sensor_index];
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        input_values_[entry_index * input_width_ + i] =
+                values_[inputs[i]].load(std::memory_order_relaxed);
+    }
+    next_entry_ = (next_entry_ + 1) % kSampleLogCapacity;
+    entry_count_ = std::min(entry_count_ + 1, kSampleLogCapacity);
+
+    // A severity change is always logged, a temperature change only out of the rate limit
+    auto &log_state = log_states_[sensor_index];
+    const bool severity_changed = severity != log_state.severity;
+    const bool temp_changed = std::isnan(log_state.temp) ||
+                              std::fabs(temp - log_state.temp) >= kSampleLogTempDelta;
+    if (!severity_changed &&
+        (!temp_changed || now - log_state.timestamp < min_log_interval_)) {
+        return false;
+    }
+    log_state = {temp, severity, now};
+    std::ostringstream buf;
+    formatSample(entries_[entry_index], input_values_.data() + entry_index * input_width_, &buf);
+    *log_line = buf.str();
+    return true;
+}
+
+void ThermalSampleLog::formatSample(const SampleEntry &entry, const float *input_values,
+                                    std::ostringstream *buf) const {
+    *buf << source_names_[entry.sensor_index] << ":" << entry.temp << " raw data: ";
+    const auto &inputs = sample_inputs_[entry.sensor_index];
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        *buf << source_names_[inputs[i]] << ":" << input_values[i] << " ";
+    }
+}
+
+void ThermalSampleLog::dump(std::ostringstream *dump_buf, std::string_view sensor_filter) const {
+    // Copy the ring and format it out of the lock, not to block addSample on the watcher
+    std::vector<SampleEntry> entries;
+    std::vector<float> input_values;
+    size_t next_entry;
+    size_t entry_count;
+    {
+        std::lock_guard<std::mutex> _lock(sample_mutex_);
+        entries = entries_;
+        input_values = input_values_;
+        next_entry = next_entry_;
+        entry_count = entry_count_;
+    }
+
+    const auto now = boot_clock::now();
+    *dump_buf << "getSensorSampleLog:" << std::endl;
+    for (size_t i = 0; i < entry_count; ++i) {
+        const size_t entry_index = (next_entry + kSampleLogCapacity - 1 - i) % kSampleLogCapacity;
+        const auto &entry = entries[entry_index];
+        if (!sensor_filter.empty() && source_names_[entry.sensor_index] != sensor_filter) {
+            continue;
+        }
+        *dump_buf << " -"
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(now - entry.timestamp)
+                             .count()
+                  << "ms " << toString(entry.severity) << " ";
+        formatSample(entry, input_values.data() + entry_index * input_width_, dump_buf);
+        *dump_buf << std::endl;
+    }
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <aidl/android/hardware/thermal/ThrottlingSeverity.h>
+#include <android-base/chrono_utils.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+using ::android::base::boot_clock;
+
+constexpr size_t kInvalidSampleLogIndex = std::numeric_limits<size_t>::max();
+constexpr size_t kSampleLogCapacity = 512;
+constexpr std::chrono::milliseconds kDefaultSampleLogIntervalMs = std::chrono::milliseconds(5000);
+// Temperature change to log a sample in text, in the unit reported to the framework
+constexpr float kSampleLogTempDelta = 1.0;
+
+// A preallocated ring of the watched sensor samples. Every source (sensor or power rail) is
+// addressed by the index assigned at registration, and a sample captures the latest value of
+// the sources its sensor is composed of. Text is only formatted for dump, or for the log when a
+// sample changes significantly and the rate limit allows.
+class ThermalSampleLog {
+  public:
+    ThermalSampleLog() = default;
+    ~ThermalSampleLog() = default;
+    // Disallow copy and assign
+    ThermalSampleLog(const ThermalSampleLog &) = delete;
+    void operator=(const ThermalSampleLog &) = delete;
+
+    // Return the index of a source, registering it if needed. Only called before finalize()
+    size_t getSourceIndex(std::string_view name);
+    // Set the sources captured with each sample of a sensor. Only called before finalize()
+    void setSampleInputs(size_t sensor_index, std::vector<size_t> input_indices);
+    // Allocate the buffers, no allocation happens after this
+    void finalize();
+    void setMinLogInterval(std::chrono::milliseconds min_log_interval) {
+        min_log_interval_ = min_log_interval;
+    }
+
+    void updateValue(size_t index, float value) {
+        if (index < source_count_) {
+            values_[index].store(value, std::memory_order_relaxed);
+        }
+    }
+    // Append a sample of a sensor, return true and fill log_line if it should be logged
+    bool addSample(size_t sensor_index, float temp, ThrottlingSeverity severity,
+                   std::string *log_line);
+    // Dump the samples from the newest one, filtered by sensor name if not empty
+    void dump(std::ostringstream *dump_buf, std::string_view sensor_filter = "") const;
+
+  private:
+    struct SampleEntry {
+        size_t sensor_index;
+        boot_clock::time_point timestamp;
+        float temp;
+        ThrottlingSeverity severity;
+    };
+    struct LogState {
+        float temp = NAN;
+        ThrottlingSeverity severity = ThrottlingSeverity::NONE;
+        boot_clock::time_point timestamp = boot_clock::time_point::min();
+    };
+    // Format a sample with the input values it captured
+    void formatSample(const SampleEntry &entry, const float *input_values,
+                      std::ostringstream *buf) const;
+
+    std::unordered_map<std::string, size_t> source_index_map_;
+    std::vector<std::string> source_names_;
+    std::vector<std::vector<size_t>> sample_inputs_;
+    size_t source_count_ = 0;
+    size_t input_width_ = 0;
+    std::unique_ptr<std::atomic<float>[]> values_;
+    std::chrono::milliseconds min_log_interval_ = kDefaultSampleLogIntervalMs;
+
+    mutable std::mutex sample_mutex_;
+    std::vector<SampleEntry> entries_;
+    // Input values of entries_[i] are at input_values_[i * input_width_]
+    std::vector<float> input_values_;
+    size_t next_entry_ = 0;
+    size_t entry_count_ = 0;
+    std::vector<LogState> log_states_;
+};
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
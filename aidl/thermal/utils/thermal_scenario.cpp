@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "thermal_scenario.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/parsedouble.h>
+#include <android-base/parseint.h>
+#include <android-base/strings.h>
+
+#include <algorithm>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+bool ParseScenarioScript(std::string_view script, std::vector<ScenarioEvent> *events) {
+    events->clear();
+    for (const auto &raw_line : ::android::base::Split(std::string(script), "\n;")) {
+        const auto line = ::android::base::Trim(raw_line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> tokens;
+        for (auto &token : ::android::base::Split(line, " \t")) {
+            if (!token.empty()) {
+                tokens.emplace_back(std::move(token));
+            }
+        }
+
+        int64_t offset_ms;
+        if (tokens.size() < 3 || !::android::base::ParseInt(tokens[0], &offset_ms, int64_t(0))) {
+            LOG(ERROR) << "Invalid scenario event: " << line;
+            return false;
+        }
+        ScenarioEvent event{std::chrono::milliseconds(offset_ms), tokens[1], ScenarioAction::CLEAR,
+                            0.0, false};
+        if (tokens[2] == "clear" && tokens.size() == 3) {
+            // Nothing else to parse
+        } else if ((tokens[2] == "temp" || tokens[2] == "severity") &&
+                   (tokens.size() == 4 || (tokens.size() == 5 && tokens[4] == "max_throttling")) &&
+                   ::android::base::ParseFloat(tokens[3], &event.value)) {
+            event.action = tokens[2] == "temp" ? ScenarioAction::TEMP : ScenarioAction::SEVERITY;
+            event.max_throttling = tokens.size() == 5;
+        } else {
+            LOG(ERROR) << "Invalid scenario event: " << line;
+            return false;
+        }
+        events->emplace_back(std::move(event));
+    }
+    // Events at the same offset keep the script order
+    std::stable_sort(events->begin(), events->end(),
+                     [](const ScenarioEvent &a, const ScenarioEvent &b) {
+                         return a.offset < b.offset;
+                     });
+    return true;
+}
+
+bool ThermalScenario::start(std::string_view source, bool loop, float speed,
+                            const std::unordered_map<std::string, SensorInfo> &sensor_info_map) {
+    std::string script(source);
+    if (source.starts_with("/") && !::android::base::ReadFileToString(script, &script)) {
+        LOG(ERROR) << "Failed to read scenario file " << source;
+        return false;
+    }
+
+    std::vector<ScenarioEvent> events;
+    if (!ParseScenarioScript(script, &events) || events.empty()) {
+        LOG(ERROR) << "Failed to parse scenario " << source;
+        return false;
+    }
+    if (speed < kMinScenarioSpeed || speed > kMaxScenarioSpeed) {
+        LOG(ERROR) << "Invalid scenario speed " << speed;
+        return false;
+    }
+    if (loop && events.back().offset.count() == 0) {
+        LOG(ERROR) << "Cannot loop a scenario without duration";
+        return false;
+    }
+    for (const auto &event : events) {
+        if (event.action == ScenarioAction::CLEAR && event.sensor == "all") {
+            continue;
+        }
+        if (!sensor_info_map.count(event.sensor)) {
+            LOG(ERROR) << "Cannot find scenario sensor " << event.sensor;
+            return false;
+        }
+        if (event.action == ScenarioAction::SEVERITY &&
+            (event.value < 0 || event.value >= kThrottlingSeverityCount)) {
+            LOG(ERROR) << "Invalid scenario severity " << event.value << " of " << event.sensor;
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> _lock(scenario_mutex_);
+    source_ = source.size() > 64 ? std::string(source.substr(0, 64)) + "..." : std::string(source);
+    events_ = std::move(events);
+    running_ = true;
+    loop_ = loop;
+    speed_ = speed;
+    next_event_ = 0;
+    loop_count_ = 0;
+    start_time_ = boot_clock::now();
+    last_event_time_ = boot_clock::time_point::min();
+    cdev_request_count_map_.clear();
+    cdev_last_state_map_.clear();
+    callback_count_map_.clear();
+    cdev_latency_histogram_ = std::make_unique<DurationHistogram>();
+    callback_latency_histogram_ = std::make_unique<DurationHistogram>();
+    callback_duration_histogram_ = std::make_unique<DurationHistogram>();
+    LOG(INFO) << "Start scenario " << source_ << " with " << events_.size()
+              << " events, loop: " << loop << " speed: " << speed;
+    return true;
+}
+
+std::set<std::string> ThermalScenario::stop() {
+    std::lock_guard<std::mutex> _lock(scenario_mutex_);
+    if (running_) {
+        LOG(INFO) << "Stop scenario " << source_;
+    }
+    running_ = false;
+    last_event_time_ = boot_clock::time_point::min();
+    return std::move(emulated_sensors_);
+}
+
+bool ThermalScenario::isRunning() const {
+    std::lock_guard<std::mutex> _lock(scenario_mutex_);
+    return running_;
+}
+
+boot_clock::time_point ThermalScenario::getEventTime(size_t idx) const {
+    const double offset_ms = static_cast<double>(loop_count_) * events_.back().offset.count() +
+                             events_[idx].offset.count();
+    return start_time_ + std::chrono::duration_cast<boot_clock::duration>(
+                                 std::chrono::duration<double, std::milli>(offset_ms / speed_));
+}
+
+std::chrono::milliseconds ThermalScenario::poll(boot_clock::time_point now,
+                                                std::vector<ScenarioEvent> *due_events) {
+    std::lock_guard<std::mutex> _lock(scenario_mutex_);
+    while (running_ && getEventTime(next_event_) <= now) {
+        last_event_time_ = getEventTime(next_event_);
+        const auto &event = events_[next_event_];
+        due_events->push_back(event);
+        if (event.action != ScenarioAction::CLEAR) {
+            emulated_sensors_.insert(event.sensor);
+        } else if (event.sensor == "all") {
+            emulated_sensors_.clear();
+        } else {
+            emulated_sensors_.erase(event.sensor);
+        }
+        if (++next_event_ < events_.size()) {
+            continue;
+        }
+        if (loop_) {
+            next_event_ = 0;
+            loop_count_++;
+            // Only replay the latest loop if the watcher slept over several of them
+            if (due_events->size() >= events_.size()) {
+                const double elapsed_ms =
+                        std::chrono::duration<double, std::milli>(now - start_time_).count() *
+                        speed_;
+                loop_count_ = std::max(loop_count_, static_cast<size_t>(
+                                                            elapsed_ms /
+                                                            events_.back().offset.count()));
+            }
+        } else {
+            LOG(INFO) << "Scenario " << source_ << " finished";
+            running_ = false;
+        }
+    }
+    if (!running_) {
+        return std::chrono::milliseconds::max();
+    }
+    return std::chrono::ceil<std::chrono::milliseconds>(getEventTime(next_event_) - now);
+}
+
+void ThermalScenario::recordCdevRequest(std::string_view cdev, int state,
+                                        boot_clock::time_point now) {
+    std::lock_guard<std::mutex> _lock(scenario_mutex_);
+    // Keep recording the response to the last event after the script ends, until stopped
+    if (last_event_time_ == boot_clock::time_point::min()) {
+        return;
+    }
+    cdev_request_count_map_[std::string(cdev)]++;
+    cdev_last_state_map_[std::string(cdev)] = state;
+    cdev_latency_histogram_->record(
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - last_event_time_).count());
+}
+
+void ThermalScenario::recordCallback(std::string_view sensor, boot_clock::time_point now,
+                                     std::chrono::microseconds duration) {
+    std::lock_guard<std::mutex> _lock(scenario_mutex_);
+    // Keep recording the response to the last event after the script ends, until stopped
+    if (last_event_time_ == boot_clock::time_point::min()) {
+        return;
+    }
+    callback_count_map_[std::string(sensor)]++;
+    callback_latency_histogram_->record(
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - last_event_time_).count());
+    callback_duration_histogram_->record(duration.count());
+}
+
+void ThermalScenario::dump(std::ostringstream *dump_buf) const {
+    std::lock_guard<std::mutex> _lock(scenario_mutex_);
+    *dump_buf << "getScenarioStatus:" << std::endl;
+    if (events_.empty()) {
+        *dump_buf << " No scenario" << std::endl;
+        return;
+    }
+    *dump_buf << " Source: " << source_ << " Running: " << std::boolalpha << running_
+              << " Loop: " << loop_ << " Speed: " << speed_ << std::endl;
+    *dump_buf << " Progress: " << next_event_ << "/" << events_.size()
+              << " Loops: " << loop_count_ << " Elapsed: "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(boot_clock::now() -
+                                                                       start_time_)
+                         .count()
+              << "ms" << std::endl;
+    *dump_buf << " CdevRequests:" << std::endl;
+    for (const auto &[cdev, count] : cdev_request_count_map_) {
+        *dump_buf << "  " << cdev << ": count: " << count
+                  << " last state: " << cdev_last_state_map_.at(cdev) << std::endl;
+    }
+    *dump_buf << " Callbacks:" << std::endl;
+    for (const auto &[sensor, count] : callback_count_map_) {
+        *dump_buf << "  " << sensor << ": count: " << count << std::endl;
+    }
+    const auto dump_percentiles = [dump_buf](std::string_view name,
+                                             const HistogramSnapshot &histogram,
+                                             std::string_view unit) {
+        *dump_buf << " " << name << ": count: " << histogram.count;
+        if (histogram.count) {
+            *dump_buf << " p50: " << histogram.getPercentile(50) << unit
+                      << " p95: " << histogram.getPercentile(95) << unit
+                      << " p99: " << histogram.getPercentile(99) << unit;
+        }
+        *dump_buf << std::endl;
+    };
+    dump_percentiles("EventToCdevRequest", cdev_latency_histogram_->snapshot(), "ms");
+    dump_percentiles("EventToCallback", callback_latency_histogram_->snapshot(), "ms");
+    dump_percentiles("CallbackDuration", callback_duration_histogram_->snapshot(), "us");
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
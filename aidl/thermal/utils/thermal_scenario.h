@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android-base/chrono_utils.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "thermal_info.h"
+#include "thermal_stats_helper.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+using ::android::base::boot_clock;
+
+constexpr float kMinScenarioSpeed = 0.01;
+constexpr float kMaxScenarioSpeed = 1000.0;
+
+enum class ScenarioAction : uint32_t {
+    TEMP = 0,
+    SEVERITY,
+    CLEAR,
+};
+
+struct ScenarioEvent {
+    // Offset from the start of the script, before the speed up
+    std::chrono::milliseconds offset;
+    std::string sensor;
+    ScenarioAction action;
+    float value;
+    bool max_throttling;
+};
+
+// Parse a scenario script, one event per line or separated by ';':
+//   <offset_ms> <sensor> temp <value> [max_throttling]
+//   <offset_ms> <sensor> severity <value> [max_throttling]
+//   <offset_ms> <sensor|all> clear
+// Lines starting with '#' are ignored. Events are sorted by offset.
+bool ParseScenarioScript(std::string_view script, std::vector<ScenarioEvent> *events);
+
+// Plays back a scenario script on the thermal watcher ticks, and records the control loop
+// response to the injected temperatures
+class ThermalScenario {
+  public:
+    ThermalScenario() = default;
+    ~ThermalScenario() = default;
+    // Disallow copy and assign
+    ThermalScenario(const ThermalScenario &) = delete;
+    void operator=(const ThermalScenario &) = delete;
+
+    // Start a scenario from a file path or an inline script, replacing the running one.
+    // A looping script restarts at the offset of its last event.
+    bool start(std::string_view source, bool loop, float speed,
+               const std::unordered_map<std::string, SensorInfo> &sensor_info_map);
+    // Stop the scenario, return the sensors its events emulated since the last stop
+    std::set<std::string> stop();
+    bool isRunning() const;
+    // Move the events due at now to due_events, return the time until the next event or max()
+    std::chrono::milliseconds poll(boot_clock::time_point now,
+                                   std::vector<ScenarioEvent> *due_events);
+    void recordCdevRequest(std::string_view cdev, int state, boot_clock::time_point now);
+    void recordCallback(std::string_view sensor, boot_clock::time_point now,
+                        std::chrono::microseconds duration);
+    void dump(std::ostringstream *dump_buf) const;
+
+  private:
+    boot_clock::time_point getEventTime(size_t idx) const;
+
+    mutable std::mutex scenario_mutex_;
+    std::string source_;
+    std::vector<ScenarioEvent> events_;
+    bool running_ = false;
+    bool loop_ = false;
+    float speed_ = 1.0;
+    size_t next_event_ = 0;
+    size_t loop_count_ = 0;
+    boot_clock::time_point start_time_;
+    boot_clock::time_point last_event_time_ = boot_clock::time_point::min();
+    // The sensors emulated by the events, their emulation is cleared on stop
+    std::set<std::string> emulated_sensors_;
+
+    // Control loop response since the scenario started
+    std::unordered_map<std::string, size_t> cdev_request_count_map_;
+    std::unordered_map<std::string, int> cdev_last_state_map_;
+    std::unordered_map<std::string, size_t> callback_count_map_;
+    // Milliseconds from the latest event to a cdev request or a callback
+    std::unique_ptr<DurationHistogram> cdev_latency_histogram_;
+    std::unique_ptr<DurationHistogram> callback_latency_histogram_;
+    // Microseconds spent in the callback
+    std::unique_ptr<DurationHistogram> callback_duration_histogram_;
+};
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define ATRACE_TAG (ATRACE_TAG_THERMAL | ATRACE_TAG_HAL)
+
+#include "thermal_severity.h"
+
+#include <utils/Trace.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+namespace {
+
+constexpr size_t kFirstSeverityLevel = static_cast<size_t>(ThrottlingSeverity::LIGHT);
+constexpr float kInf = std::numeric_limits<float>::infinity();
+
+}  // namespace
+
+void SeverityClassifier::registerSensors(
+        const std::unordered_map<std::string, SensorInfo> &sensor_info_map) {
+    sensor_names_.clear();
+    sensor_index_map_.clear();
+    for (const auto &[sensor_name, sensor_info] : sensor_info_map) {
+        sensor_names_.push_back(sensor_name);
+    }
+    std::sort(sensor_names_.begin(), sensor_names_.end());
+
+    const size_t sensor_count = sensor_names_.size();
+    for (size_t i = 0; i < kThrottlingSeverityCount; ++i) {
+        hot_trigger_[i].assign(sensor_count, kInf);
+        hot_release_[i].assign(sensor_count, kInf);
+        cold_trigger_[i].assign(sensor_count, -kInf);
+        cold_release_[i].assign(sensor_count, -kInf);
+    }
+    for (size_t j = 0; j < sensor_count; ++j) {
+        const auto &sensor_info = sensor_info_map.at(sensor_names_[j]);
+        sensor_index_map_[sensor_names_[j]] = j;
+        for (size_t i = kFirstSeverityLevel; i < kThrottlingSeverityCount; ++i) {
+            // A NAN hysteresis of a valid threshold stays NAN and never releases, as before
+            if (!std::isnan(sensor_info.hot_thresholds[i])) {
+                hot_trigger_[i][j] = sensor_info.hot_thresholds[i];
+                hot_release_[i][j] = sensor_info.hot_thresholds[i] - sensor_info.hot_hysteresis[i];
+            }
+            if (!std::isnan(sensor_info.cold_thresholds[i])) {
+                cold_trigger_[i][j] = sensor_info.cold_thresholds[i];
+                cold_release_[i][j] =
+                        sensor_info.cold_thresholds[i] + sensor_info.cold_hysteresis[i];
+            }
+        }
+    }
+}
+
+bool SeverityClassifier::getSensorIndex(std::string_view sensor_name, size_t *index) const {
+    const auto it = sensor_index_map_.find(sensor_name.data());
+    if (it == sensor_index_map_.end()) {
+        return false;
+    }
+    *index = it->second;
+    return true;
+}
+
+SeverityPair SeverityClassifier::classify(size_t index, float value,
+                                          ThrottlingSeverity prev_hot_severity,
+                                          ThrottlingSeverity prev_cold_severity) const {
+    size_t hot = 0;
+    size_t hot_release = 0;
+    size_t cold = 0;
+    size_t cold_release = 0;
+    // Levels ascend, the last match is the highest severity
+    for (size_t i = kFirstSeverityLevel; i < kThrottlingSeverityCount; ++i) {
+        hot = (value >= hot_trigger_[i][index]) ? i : hot;
+        hot_release = (value > hot_release_[i][index]) ? i : hot_release;
+        cold = (value <= cold_trigger_[i][index]) ? i : cold;
+        cold_release = (value < cold_release_[i][index]) ? i : cold_release;
+    }
+    if (hot < static_cast<size_t>(prev_hot_severity)) {
+        hot = hot_release;
+    }
+    if (cold < static_cast<size_t>(prev_cold_severity)) {
+        cold = cold_release;
+    }
+    return std::make_pair(static_cast<ThrottlingSeverity>(hot),
+                          static_cast<ThrottlingSeverity>(cold));
+}
+
+void SeverityClassifier::classifyBatch(const SeverityBatch &batch,
+                                       std::vector<SeverityPair> *severities,
+                                       std::vector<uint64_t> *changed_mask) const {
+    ATRACE_CALL();
+    const size_t sensor_count = sensor_names_.size();
+    std::vector<int32_t> hot(sensor_count, 0);
+    std::vector<int32_t> hot_release(sensor_count, 0);
+    std::vector<int32_t> cold(sensor_count, 0);
+    std::vector<int32_t> cold_release(sensor_count, 0);
+    const float *values = batch.values.data();
+
+    // One level of every sensor per pass, branchless so that it is vectorized
+    for (size_t i = kFirstSeverityLevel; i < kThrottlingSeverityCount; ++i) {
+        const int32_t level = static_cast<int32_t>(i);
+        const float *hot_trigger = hot_trigger_[i].data();
+        const float *hot_release_level = hot_release_[i].data();
+        const float *cold_trigger = cold_trigger_[i].data();
+        const float *cold_release_level = cold_release_[i].data();
+        for (size_t j = 0; j < sensor_count; ++j) {
+            hot[j] = (values[j] >= hot_trigger[j]) ? level : hot[j];
+            hot_release[j] = (values[j] > hot_release_level[j]) ? level : hot_release[j];
+            cold[j] = (values[j] <= cold_trigger[j]) ? level : cold[j];
+            cold_release[j] = (values[j] < cold_release_level[j]) ? level : cold_release[j];
+        }
+    }
+
+    severities->resize(sensor_count);
+    changed_mask->assign((sensor_count + 63) / 64, 0);
+    for (size_t j = 0; j < sensor_count; ++j) {
+        const auto prev_hot = static_cast<int32_t>(batch.prev_hot_severities[j]);
+        const auto prev_cold = static_cast<int32_t>(batch.prev_cold_severities[j]);
+        const int32_t hot_severity = (hot[j] < prev_hot) ? hot_release[j] : hot[j];
+        const int32_t cold_severity = (cold[j] < prev_cold) ? cold_release[j] : cold[j];
+        (*severities)[j] = std::make_pair(static_cast<ThrottlingSeverity>(hot_severity),
+                                          static_cast<ThrottlingSeverity>(cold_severity));
+        if (!std::isnan(values[j]) && (hot_severity != prev_hot || cold_severity != prev_cold)) {
+            (*changed_mask)[j / 64] |= uint64_t(1) << (j % 64);
+        }
+    }
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <aidl/android/hardware/thermal/ThrottlingSeverity.h>
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "thermal_info.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+using ::aidl::android::hardware::thermal::ThrottlingSeverity;
+
+using SeverityPair = std::pair<ThrottlingSeverity, ThrottlingSeverity>;
+
+// Input of a batch classification, one entry per registered sensor in index order. A NAN
+// value skips the sensor.
+struct SeverityBatch {
+    std::vector<float> values;
+    std::vector<ThrottlingSeverity> prev_hot_severities;
+    std::vector<ThrottlingSeverity> prev_cold_severities;
+};
+
+// Hot and cold severity classification from the thresholds and hysteresis of the sensors.
+// The tables are stored per severity level across the sensors, so that a batch compares one
+// level of every sensor in a branchless loop the compiler vectorizes. A missing threshold is
+// stored as an infinity which never matches.
+class SeverityClassifier {
+  public:
+    SeverityClassifier() = default;
+    ~SeverityClassifier() = default;
+    // Disallow copy and assign
+    SeverityClassifier(const SeverityClassifier &) = delete;
+    void operator=(const SeverityClassifier &) = delete;
+
+    // Build the tables, the sensors are indexed in name order
+    void registerSensors(const std::unordered_map<std::string, SensorInfo> &sensor_info_map);
+    size_t getSensorCount() const { return sensor_names_.size(); }
+    // Return false if the sensor is not registered
+    bool getSensorIndex(std::string_view sensor_name, size_t *index) const;
+    const std::string &getSensorName(size_t index) const { return sensor_names_[index]; }
+
+    // Classify a single reading
+    SeverityPair classify(size_t index, float value, ThrottlingSeverity prev_hot_severity,
+                          ThrottlingSeverity prev_cold_severity) const;
+    // Classify the readings of all the sensors, and set the bit of each sensor whose hot or
+    // cold severity changed from the previous one
+    void classifyBatch(const SeverityBatch &batch, std::vector<SeverityPair> *severities,
+                       std::vector<uint64_t> *changed_mask) const;
+
+  private:
+    using SeverityTable = std::array<std::vector<float>, kThrottlingSeverityCount>;
+
+    std::vector<std::string> sensor_names_;
+    std::unordered_map<std::string, size_t> sensor_index_map_;
+    // Severity is at least the level once the value reaches the trigger, and stays at the
+    // level until the value falls past the release
+    SeverityTable hot_trigger_;
+    SeverityTable hot_release_;
+    SeverityTable cold_trigger_;
+    SeverityTable cold_release_;
+};
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -10,6 +10,8 @@
 #include <android/binder_manager.h>
 
 #include <algorithm>
+#include <cstring>
+#include <map>
 #include <numeric>
 #include <string_view>
 
@@ -70,8 +72,174 @@ void resetCurrentTempStatus(CurrTempStatus *curr_temp_status, float new_temp) {
     curr_temp_status->repeat_count = 1;
 }
 
+int64_t toNs(const boot_clock::time_point &time_point) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time_point.time_since_epoch())
+            .count();
+}
+
+boot_clock::time_point fromNs(int64_t ns) {
+    return boot_clock::time_point(
+            std::chrono::duration_cast<boot_clock::duration>(std::chrono::nanoseconds(ns)));
+}
+
+template <typename ValueType>
+ThermalStats<ValueType> loadThermalStats(const AtomicThermalStats<ValueType> &atomic_stats) {
+    ThermalStats<ValueType> thermal_stats;
+    for (const auto &stats_by_threshold : atomic_stats.stats_by_custom_threshold) {
+        StatsByThreshold<ValueType> stats;
+        stats.thresholds = stats_by_threshold->thresholds;
+        stats.logging_name = stats_by_threshold->logging_name;
+        stats.stats_record = stats_by_threshold->stats_record.load();
+        thermal_stats.stats_by_custom_threshold.push_back(std::move(stats));
+    }
+    if (atomic_stats.stats_by_default_threshold != nullptr) {
+        thermal_stats.stats_by_default_threshold = atomic_stats.stats_by_default_threshold->load();
+    }
+    return thermal_stats;
+}
+
+int64_t floatToStatsData(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float statsDataToFloat(int64_t data) {
+    const uint32_t bits = static_cast<uint32_t>(data);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+uint64_t hashStatsLayout(std::string_view key, size_t size, uint64_t seed) {
+    seed = hashStatsData(key.data(), key.size(), seed);
+    return hashStatsData(&size, sizeof(size), seed);
+}
+
 }  // namespace
 
+float HistogramSnapshot::getPercentile(float percentile) const {
+    if (!count) {
+        return NAN;
+    }
+    const uint64_t rank = std::max<uint64_t>(1, std::ceil(count * percentile / 100));
+    uint64_t cumulative_count = 0;
+    for (const auto &[upper_bound, bucket_count] : buckets) {
+        cumulative_count += bucket_count;
+        if (cumulative_count >= rank) {
+            return upper_bound;
+        }
+    }
+    return buckets.back().first;
+}
+
+AtomicStatsRecord::AtomicStatsRecord(const size_t &time_in_state_size, int state)
+    : time_in_state_size_(time_in_state_size),
+      cur_state_(state),
+      cur_state_start_time_ns_(toNs(boot_clock::now())),
+      last_stats_report_time_ns_(cur_state_start_time_ns_.load()),
+      time_in_state_ms_(new std::atomic<int64_t>[time_in_state_size]),
+      reported_time_in_state_ms_(new std::atomic<int64_t>[time_in_state_size]) {
+    for (size_t i = 0; i < time_in_state_size_; ++i) {
+        time_in_state_ms_[i].store(0, std::memory_order_relaxed);
+        reported_time_in_state_ms_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void AtomicStatsRecord::beginWrite() {
+    seq_.store(seq_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void AtomicStatsRecord::endWrite() {
+    seq_.store(seq_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void AtomicStatsRecord::update(int new_state) {
+    const auto now_ns = toNs(boot_clock::now());
+    const auto cur_state = cur_state_.load(std::memory_order_relaxed);
+    const auto cur_state_duration_ms =
+            (now_ns - cur_state_start_time_ns_.load(std::memory_order_relaxed)) / 1000000;
+    LOG(VERBOSE) << "Adding duration " << cur_state_duration_ms << " for cur_state: " << cur_state
+                 << " with value: " << time_in_state_ms_[cur_state].load(std::memory_order_relaxed);
+    beginWrite();
+    // Update last record end time
+    time_in_state_ms_[cur_state].store(
+            time_in_state_ms_[cur_state].load(std::memory_order_relaxed) + cur_state_duration_ms,
+            std::memory_order_relaxed);
+    cur_state_start_time_ns_.store(now_ns, std::memory_order_relaxed);
+    cur_state_.store(new_state, std::memory_order_relaxed);
+    endWrite();
+}
+
+StatsRecord AtomicStatsRecord::load() const {
+    StatsRecord stats_record(time_in_state_size_);
+    uint32_t seq_begin, seq_end;
+    do {
+        seq_begin = seq_.load(std::memory_order_acquire);
+        stats_record.cur_state = cur_state_.load(std::memory_order_relaxed);
+        stats_record.cur_state_start_time =
+                fromNs(cur_state_start_time_ns_.load(std::memory_order_relaxed));
+        stats_record.last_stats_report_time =
+                fromNs(last_stats_report_time_ns_.load(std::memory_order_relaxed));
+        stats_record.report_fail_count = report_fail_count_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < time_in_state_size_; ++i) {
+            stats_record.time_in_state_ms[i] = std::chrono::milliseconds(
+                    time_in_state_ms_[i].load(std::memory_order_relaxed) -
+                    reported_time_in_state_ms_[i].load(std::memory_order_relaxed));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        seq_end = seq_.load(std::memory_order_relaxed);
+    } while ((seq_begin & 1) || seq_begin != seq_end);
+
+    // close the unclosed entry at now, as if a new record started with same state
+    const auto now = boot_clock::now();
+    stats_record.time_in_state_ms[stats_record.cur_state] +=
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                    now - stats_record.cur_state_start_time);
+    stats_record.cur_state_start_time = now;
+    return stats_record;
+}
+
+void AtomicStatsRecord::markReported(const StatsRecord &reported_record) {
+    beginWrite();
+    for (size_t i = 0; i < time_in_state_size_; ++i) {
+        reported_time_in_state_ms_[i].store(
+                reported_time_in_state_ms_[i].load(std::memory_order_relaxed) +
+                        reported_record.time_in_state_ms[i].count(),
+                std::memory_order_relaxed);
+    }
+    last_stats_report_time_ns_.store(toNs(reported_record.cur_state_start_time),
+                                     std::memory_order_relaxed);
+    report_fail_count_.store(0, std::memory_order_relaxed);
+    endWrite();
+}
+
+void AtomicStatsRecord::restore(const std::vector<std::chrono::milliseconds> &time_in_state_ms,
+                                std::chrono::milliseconds since_last_report) {
+    beginWrite();
+    for (size_t i = 0; i < time_in_state_size_ && i < time_in_state_ms.size(); ++i) {
+        reported_time_in_state_ms_[i].store(
+                reported_time_in_state_ms_[i].load(std::memory_order_relaxed) -
+                        time_in_state_ms[i].count(),
+                std::memory_order_relaxed);
+    }
+    last_stats_report_time_ns_.store(toNs(boot_clock::now() - since_last_report),
+                                     std::memory_order_relaxed);
+    endWrite();
+}
+
+void AtomicStatsRecord::markReportFailed(const StatsRecord &reported_record) {
+    // If consecutive count of failure is high, reset stat to avoid overflow
+    if (reported_record.report_fail_count + 1 >= kMaxStatsReportingFailCount) {
+        markReported(reported_record);
+        return;
+    }
+    beginWrite();
+    report_fail_count_.store(reported_record.report_fail_count + 1, std::memory_order_relaxed);
+    endWrite();
+}
+
 bool ThermalStatsHelper::initializeStats(
         const Json::Value &config,
         const std::unordered_map<std::string, SensorInfo> &sensor_info_map_,
@@ -89,6 +257,22 @@ bool ThermalStatsHelper::initializeStats(
         LOG(ERROR) << "Failed to parse cooling device stats config";
         return false;
     }
+    for (const auto &[sensor, sensor_info] : sensor_info_map_) {
+        auto &slot = sensor_temp_stats_slot_map_[sensor];
+        slot = std::make_unique<SensorTempStatsSlot>();
+        if (sensor_info.is_watch) {
+            slot->temp_histogram = std::make_unique<TempHistogram>();
+            slot->time_to_mitigate_histogram = std::make_unique<DurationHistogram>();
+        }
+    }
+    for (const auto &[cdev, cdev_info] : cooling_device_info_map_) {
+        auto &slot = cdev_dwell_slot_map_[cdev];
+        slot = std::make_unique<CdevDwellSlot>();
+        slot->cur_state_start_time = boot_clock::now();
+        for (int state = 0; state <= cdev_info.max_state; ++state) {
+            slot->dwell_histograms.emplace_back(std::make_unique<DurationHistogram>());
+        }
+    }
     if (!initializeSensorTempStats(sensor_stats_info, sensor_info_map_)) {
         LOG(ERROR) << "Failed to initialize sensor temp stats";
         return false;
@@ -105,6 +289,7 @@ bool ThermalStatsHelper::initializeStats(
 
     last_total_stats_report_time = boot_clock::now();
     abnormal_stats_reported_per_update_interval = 0;
+    initializeStatsStore();
     LOG(INFO) << "Thermal Stats Initialized Successfully";
     return true;
 }
@@ -113,11 +298,14 @@ bool ThermalStatsHelper::initializeSensorCdevRequestStats(
         const StatsInfo<int> &request_stats_info,
         const std::unordered_map<std::string, SensorInfo> &sensor_info_map_,
         const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map_) {
-    std::unique_lock<std::shared_mutex> _lock(sensor_cdev_request_stats_map_mutex_);
     for (const auto &[sensor, sensor_info] : sensor_info_map_) {
         for (const auto &binded_cdev_info_pair :
              sensor_info.throttling_info->binded_cdev_info_map) {
             const auto &cdev = binded_cdev_info_pair.first;
+            // Every binded cdev has a slot for the request tracking, even without stats
+            auto &slot = sensor_cdev_request_stats_slot_map_[sensor][cdev];
+            slot = std::make_unique<SensorCdevRequestStatsSlot>();
+            auto &request_stats = slot->request_stats;
             const auto &max_state =
                     cooling_device_info_map_.at(binded_cdev_info_pair.first).max_state;
             // Record by all state
@@ -134,13 +322,14 @@ bool ThermalStatsHelper::initializeSensorCdevRequestStats(
                     std::iota(thresholds.begin(), thresholds.end(), starting_state);
                     const auto logging_name = cdev + kCompressedThresholdSuffix.data();
                     ThresholdList<int> threshold_list(logging_name, thresholds);
-                    sensor_cdev_request_stats_map_[sensor][cdev]
-                            .stats_by_custom_threshold.emplace_back(threshold_list);
+                    request_stats.stats_by_custom_threshold.emplace_back(
+                            std::make_unique<AtomicStatsByThreshold<int>>(threshold_list));
                 } else {
                     // buckets = [0, 1, 2, 3, ...max_state]
                     const auto default_threshold_time_in_state_size = max_state + 1;
-                    sensor_cdev_request_stats_map_[sensor][cdev].stats_by_default_threshold =
-                            StatsRecord(default_threshold_time_in_state_size);
+                    request_stats.stats_by_default_threshold =
+                            std::make_unique<AtomicStatsRecord>(
+                                    default_threshold_time_in_state_size);
                 }
                 LOG(INFO) << "Sensor Cdev user vote stats on basis of all state initialized for ["
                           << sensor << "-" << cdev << "]";
@@ -155,11 +344,11 @@ bool ThermalStatsHelper::initializeSensorCdevRequestStats(
                         LOG(ERROR) << "For sensor " << sensor << " bindedCdev: " << cdev
                                    << "Invalid bindedCdev stats threshold: "
                                    << threshold_list.thresholds.back() << " >= " << max_state;
-                        sensor_cdev_request_stats_map_.clear();
+                        sensor_cdev_request_stats_slot_map_.clear();
                         return false;
                     }
-                    sensor_cdev_request_stats_map_[sensor][cdev]
-                            .stats_by_custom_threshold.emplace_back(threshold_list);
+                    request_stats.stats_by_custom_threshold.emplace_back(
+                            std::make_unique<AtomicStatsByThreshold<int>>(threshold_list));
                     LOG(INFO)
                             << "Sensor Cdev user vote stats on basis of threshold initialized for ["
                             << sensor << "-" << cdev << "]";
@@ -173,17 +362,16 @@ bool ThermalStatsHelper::initializeSensorCdevRequestStats(
 bool ThermalStatsHelper::initializeSensorTempStats(
         const StatsInfo<float> &sensor_stats_info,
         const std::unordered_map<std::string, SensorInfo> &sensor_info_map_) {
-    std::unique_lock<std::shared_mutex> _lock(sensor_stats_mutex_);
-    auto &temp_stats_map_ = sensor_stats.temp_stats_map_;
     const int severity_time_in_state_size = kThrottlingSeverityCount;
     for (const auto &[sensor, sensor_info] : sensor_info_map_) {
+        auto &temp_stats = sensor_temp_stats_slot_map_.at(sensor)->temp_stats;
         // Record by severity
         if (sensor_info.is_watch &&
             isRecordByDefaultThreshold(
                     sensor_stats_info.record_by_default_threshold_all_or_name_set_, sensor)) {
             // number of buckets = number of severity
-            temp_stats_map_[sensor].stats_by_default_threshold =
-                    StatsRecord(severity_time_in_state_size);
+            temp_stats.stats_by_default_threshold =
+                    std::make_unique<AtomicStatsRecord>(severity_time_in_state_size);
             LOG(INFO) << "Sensor temp stats on basis of severity initialized for [" << sensor
                       << "]";
         }
@@ -191,7 +379,8 @@ bool ThermalStatsHelper::initializeSensorTempStats(
         // Record by custom threshold
         if (sensor_stats_info.record_by_threshold.count(sensor)) {
             for (const auto &threshold_list : sensor_stats_info.record_by_threshold.at(sensor)) {
-                temp_stats_map_[sensor].stats_by_custom_threshold.emplace_back(threshold_list);
+                temp_stats.stats_by_custom_threshold.emplace_back(
+                        std::make_unique<AtomicStatsByThreshold<float>>(threshold_list));
                 LOG(INFO) << "Sensor temp stats on basis of threshold initialized for [" << sensor
                           << "]";
             }
@@ -203,8 +392,7 @@ bool ThermalStatsHelper::initializeSensorTempStats(
 bool ThermalStatsHelper::initializeSensorAbnormalityStats(
         const AbnormalStatsInfo &abnormal_stats_info,
         const std::unordered_map<std::string, SensorInfo> &sensor_info_map_) {
-    std::unique_lock<std::shared_mutex> _lock(sensor_stats_mutex_);
-    auto &temp_range_info_map_ = sensor_stats.temp_range_info_map_;
+    std::unordered_map<std::string, std::shared_ptr<TempRangeInfo>> temp_range_info_map_;
     for (const auto &sensors_temp_range_info : abnormal_stats_info.sensors_temp_range_infos) {
         const auto &temp_range_info_ptr =
                 std::make_shared<TempRangeInfo>(sensors_temp_range_info.temp_range_info);
@@ -212,7 +400,7 @@ bool ThermalStatsHelper::initializeSensorAbnormalityStats(
             temp_range_info_map_[sensor] = temp_range_info_ptr;
         }
     }
-    auto &temp_stuck_info_map_ = sensor_stats.temp_stuck_info_map_;
+    std::unordered_map<std::string, std::shared_ptr<TempStuckInfo>> temp_stuck_info_map_;
     for (const auto &sensors_temp_stuck_info : abnormal_stats_info.sensors_temp_stuck_infos) {
         const auto &temp_stuck_info_ptr =
                 std::make_shared<TempStuckInfo>(sensors_temp_stuck_info.temp_stuck_info);
@@ -238,8 +426,19 @@ bool ThermalStatsHelper::initializeSensorAbnormalityStats(
             temp_stuck_info_map_[sensor] = default_temp_stuck_info_ptr;
     }
 
+    for (const auto &sensor_temp_range_info : temp_range_info_map_) {
+        const auto slot_it = sensor_temp_stats_slot_map_.find(sensor_temp_range_info.first);
+        if (slot_it != sensor_temp_stats_slot_map_.end()) {
+            slot_it->second->temp_range_info = sensor_temp_range_info.second;
+        }
+    }
     for (const auto &sensor_temp_stuck_info : temp_stuck_info_map_) {
-        sensor_stats.curr_temp_status_map_[sensor_temp_stuck_info.first] = {
+        const auto slot_it = sensor_temp_stats_slot_map_.find(sensor_temp_stuck_info.first);
+        if (slot_it == sensor_temp_stats_slot_map_.end()) {
+            continue;
+        }
+        slot_it->second->temp_stuck_info = sensor_temp_stuck_info.second;
+        slot_it->second->curr_temp_status = {
                 .temp = std::numeric_limits<float>::min(),
                 .start_time = boot_clock::time_point::min(),
                 .repeat_count = 0,
@@ -248,94 +447,271 @@ bool ThermalStatsHelper::initializeSensorAbnormalityStats(
     return true;
 }
 
-void ThermalStatsHelper::updateStatsRecord(StatsRecord *stats_record, int new_state) {
+size_t ThermalStatsHelper::getStatsStorePayloadCount() const {
+    // since_last_total_stats_report, then max/min temp with timestamps of each sensor, then
+    // since_last_report and time_in_state of each record
+    size_t payload_count = 1 + 4 * persisted_temp_stats_slots_.size();
+    for (const auto stats_record : persisted_stats_records_) {
+        payload_count += 1 + stats_record->getTimeInStateSize();
+    }
+    return payload_count;
+}
+
+void ThermalStatsHelper::initializeStatsStore() {
+    uint64_t layout_hash = 0;
+    const auto add_record = [&](const std::string &key, AtomicStatsRecord *stats_record) {
+        persisted_stats_records_.push_back(stats_record);
+        layout_hash = hashStatsLayout(key, stats_record->getTimeInStateSize(), layout_hash);
+    };
+    // Walk the slots in name order so the layout is stable across instances
+    const std::map<std::string_view, SensorTempStatsSlot *> temp_stats_slots = [&]() {
+        std::map<std::string_view, SensorTempStatsSlot *> slots;
+        for (const auto &[sensor, slot] : sensor_temp_stats_slot_map_) {
+            if (!slot->temp_stats.empty()) {
+                slots[sensor] = slot.get();
+            }
+        }
+        return slots;
+    }();
+    for (const auto &[sensor, slot] : temp_stats_slots) {
+        persisted_temp_stats_slots_.push_back(slot);
+        const std::string key(sensor);
+        for (size_t i = 0; i < slot->temp_stats.stats_by_custom_threshold.size(); ++i) {
+            add_record(key + kCustomThresholdSetSuffix.data() + std::to_string(i),
+                       &slot->temp_stats.stats_by_custom_threshold[i]->stats_record);
+        }
+        if (slot->temp_stats.stats_by_default_threshold != nullptr) {
+            add_record(key, slot->temp_stats.stats_by_default_threshold.get());
+        }
+    }
+    const std::map<std::string_view, std::map<std::string_view, SensorCdevRequestStatsSlot *>>
+            request_stats_slots = [&]() {
+                std::map<std::string_view, std::map<std::string_view, SensorCdevRequestStatsSlot *>>
+                        slots;
+                for (const auto &[sensor, cdev_slot_map] : sensor_cdev_request_stats_slot_map_) {
+                    for (const auto &[cdev, slot] : cdev_slot_map) {
+                        slots[sensor][cdev] = slot.get();
+                    }
+                }
+                return slots;
+            }();
+    for (const auto &[sensor, cdev_slot_map] : request_stats_slots) {
+        for (const auto &[cdev, slot] : cdev_slot_map) {
+            const std::string key = std::string(sensor) + "-" + std::string(cdev);
+            for (size_t i = 0; i < slot->request_stats.stats_by_custom_threshold.size(); ++i) {
+                add_record(key + kCustomThresholdSetSuffix.data() + std::to_string(i),
+                           &slot->request_stats.stats_by_custom_threshold[i]->stats_record);
+            }
+            if (slot->request_stats.stats_by_default_threshold != nullptr) {
+                add_record(key, slot->request_stats.stats_by_default_threshold.get());
+            }
+        }
+    }
+
+    const size_t payload_count = getStatsStorePayloadCount();
+    if (!stats_store_.open(kThermalStatsStorePath, layout_hash, payload_count)) {
+        LOG(WARNING) << "Thermal stats will not be persisted";
+        return;
+    }
+    last_stats_flush_time_ = boot_clock::now();
+    std::vector<int64_t> payload;
+    if (!stats_store_.read(&payload)) {
+        LOG(INFO) << "No thermal stats to restore";
+        return;
+    }
+
     const auto now = boot_clock::now();
-    const auto cur_state_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now - stats_record->cur_state_start_time);
-    LOG(VERBOSE) << "Adding duration " << cur_state_duration.count()
-                 << " for cur_state: " << stats_record->cur_state << " with value: "
-                 << stats_record->time_in_state_ms[stats_record->cur_state].count();
-    // Update last record end time
-    stats_record->time_in_state_ms[stats_record->cur_state] += cur_state_duration;
-    stats_record->cur_state_start_time = now;
-    stats_record->cur_state = new_state;
+    size_t idx = 0;
+    last_total_stats_report_time = now - std::chrono::milliseconds(payload[idx++]);
+    for (const auto slot : persisted_temp_stats_slots_) {
+        slot->max_temp.store(statsDataToFloat(payload[idx++]), std::memory_order_relaxed);
+        slot->max_temp_timestamp.store(payload[idx++], std::memory_order_relaxed);
+        slot->min_temp.store(statsDataToFloat(payload[idx++]), std::memory_order_relaxed);
+        slot->min_temp_timestamp.store(payload[idx++], std::memory_order_relaxed);
+    }
+    for (const auto stats_record : persisted_stats_records_) {
+        const auto since_last_report = std::chrono::milliseconds(payload[idx++]);
+        std::vector<std::chrono::milliseconds> time_in_state_ms(
+                stats_record->getTimeInStateSize());
+        for (auto &time_in_state : time_in_state_ms) {
+            time_in_state = std::chrono::milliseconds(payload[idx++]);
+        }
+        stats_record->restore(time_in_state_ms, since_last_report);
+    }
+    LOG(INFO) << "Thermal stats restored from " << kThermalStatsStorePath;
+}
+
+void ThermalStatsHelper::flushStats(bool force) {
+    if (!stats_store_.isOpened()) {
+        return;
+    }
+    const auto now = boot_clock::now();
+    if (!force && now - last_stats_flush_time_ < kStatsFlushIntervalMs) {
+        return;
+    }
+    std::vector<int64_t> payload;
+    payload.reserve(getStatsStorePayloadCount());
+    payload.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(
+                              now - last_total_stats_report_time)
+                              .count());
+    for (const auto slot : persisted_temp_stats_slots_) {
+        payload.push_back(floatToStatsData(slot->max_temp.load(std::memory_order_relaxed)));
+        payload.push_back(slot->max_temp_timestamp.load(std::memory_order_relaxed));
+        payload.push_back(floatToStatsData(slot->min_temp.load(std::memory_order_relaxed)));
+        payload.push_back(slot->min_temp_timestamp.load(std::memory_order_relaxed));
+    }
+    for (const auto stats_record : persisted_stats_records_) {
+        const StatsRecord stats_record_copy = stats_record->load();
+        payload.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  stats_record_copy.cur_state_start_time -
+                                  stats_record_copy.last_stats_report_time)
+                                  .count());
+        for (const auto &time_in_state : stats_record_copy.time_in_state_ms) {
+            payload.push_back(time_in_state.count());
+        }
+    }
+    stats_store_.write(payload);
+    last_stats_flush_time_ = now;
 }
 
 void ThermalStatsHelper::updateSensorCdevRequestStats(std::string_view sensor,
                                                       std::string_view cdev, int new_value) {
-    std::unique_lock<std::shared_mutex> _lock(sensor_cdev_request_stats_map_mutex_);
-    if (!sensor_cdev_request_stats_map_.count(sensor.data()) ||
-        !sensor_cdev_request_stats_map_[sensor.data()].count(cdev.data())) {
+    const auto sensor_it = sensor_cdev_request_stats_slot_map_.find(sensor.data());
+    if (sensor_it == sensor_cdev_request_stats_slot_map_.end()) {
+        return;
+    }
+    const auto cdev_it = sensor_it->second.find(cdev.data());
+    if (cdev_it == sensor_it->second.end()) {
         return;
     }
-    auto &request_stats = sensor_cdev_request_stats_map_[sensor.data()][cdev.data()];
-    for (auto &stats_by_threshold : request_stats.stats_by_custom_threshold) {
-        int value = calculateThresholdBucket(stats_by_threshold.thresholds, new_value);
-        if (value != stats_by_threshold.stats_record.cur_state) {
+    auto &slot = *cdev_it->second;
+    std::lock_guard<std::mutex> _lock(slot.writer_mutex);
+    if (new_value > slot.prev_request) {
+        // The first request increase after a severity rise completes the mitigation
+        const auto sensor_slot_it = sensor_temp_stats_slot_map_.find(sensor.data());
+        if (sensor_slot_it != sensor_temp_stats_slot_map_.end() &&
+            sensor_slot_it->second->time_to_mitigate_histogram != nullptr) {
+            const auto pending_since_ns = sensor_slot_it->second->mitigation_pending_since_ns.exchange(
+                    0, std::memory_order_relaxed);
+            if (pending_since_ns) {
+                sensor_slot_it->second->time_to_mitigate_histogram->record(
+                        (toNs(boot_clock::now()) - pending_since_ns) / 1000000);
+            }
+        }
+    }
+    slot.prev_request = new_value;
+    for (auto &stats_by_threshold : slot.request_stats.stats_by_custom_threshold) {
+        int value = calculateThresholdBucket(stats_by_threshold->thresholds, new_value);
+        if (value != stats_by_threshold->stats_record.getCurState()) {
             LOG(VERBOSE) << "Updating bindedCdev stats for sensor: " << sensor.data()
                          << " , cooling_device: " << cdev.data() << " with new value: " << value;
-            updateStatsRecord(&stats_by_threshold.stats_record, value);
+            stats_by_threshold->stats_record.update(value);
         }
     }
 
-    if (request_stats.stats_by_default_threshold.has_value()) {
-        auto &stats_record = request_stats.stats_by_default_threshold.value();
-        if (new_value != stats_record.cur_state) {
+    if (slot.request_stats.stats_by_default_threshold != nullptr) {
+        auto &stats_record = *slot.request_stats.stats_by_default_threshold;
+        if (new_value != stats_record.getCurState()) {
             LOG(VERBOSE) << "Updating bindedCdev stats for sensor: " << sensor.data()
                          << " , cooling_device: " << cdev.data()
                          << " with new value: " << new_value;
-            updateStatsRecord(&stats_record, new_value);
+            stats_record.update(new_value);
         }
     }
 }
 
 void ThermalStatsHelper::updateSensorTempStatsByThreshold(std::string_view sensor,
                                                           float temperature) {
-    std::unique_lock<std::shared_mutex> _lock(sensor_stats_mutex_);
-    verifySensorAbnormality(sensor, temperature);
-    auto &temp_stats_map_ = sensor_stats.temp_stats_map_;
-    if (!temp_stats_map_.count(sensor.data())) {
+    const auto slot_it = sensor_temp_stats_slot_map_.find(sensor.data());
+    if (slot_it == sensor_temp_stats_slot_map_.end()) {
         return;
     }
-    auto &sensor_temp_stats = temp_stats_map_[sensor.data()];
-    for (auto &stats_by_threshold : sensor_temp_stats.stats_by_custom_threshold) {
-        int value = calculateThresholdBucket(stats_by_threshold.thresholds, temperature);
-        if (value != stats_by_threshold.stats_record.cur_state) {
+    auto &slot = *slot_it->second;
+    std::lock_guard<std::mutex> _lock(slot.writer_mutex);
+    verifySensorAbnormality(sensor, &slot, temperature);
+    if (slot.temp_histogram != nullptr) {
+        slot.temp_histogram->record(
+                std::lround((temperature - kTempHistogramMin) / kTempHistogramResolution));
+    }
+    if (slot.temp_stats.empty()) {
+        return;
+    }
+    for (auto &stats_by_threshold : slot.temp_stats.stats_by_custom_threshold) {
+        int value = calculateThresholdBucket(stats_by_threshold->thresholds, temperature);
+        if (value != stats_by_threshold->stats_record.getCurState()) {
             LOG(VERBOSE) << "Updating sensor stats for sensor: " << sensor.data()
                          << " with value: " << value;
-            updateStatsRecord(&stats_by_threshold.stats_record, value);
+            stats_by_threshold->stats_record.update(value);
         }
     }
-    if (temperature > sensor_temp_stats.max_temp) {
-        sensor_temp_stats.max_temp = temperature;
-        sensor_temp_stats.max_temp_timestamp = system_clock::now();
+    if (temperature > slot.max_temp.load(std::memory_order_relaxed)) {
+        slot.max_temp_timestamp.store(system_clock::now().time_since_epoch().count(),
+                                      std::memory_order_relaxed);
+        slot.max_temp.store(temperature, std::memory_order_relaxed);
     }
-    if (temperature < sensor_temp_stats.min_temp) {
-        sensor_temp_stats.min_temp = temperature;
-        sensor_temp_stats.min_temp_timestamp = system_clock::now();
+    if (temperature < slot.min_temp.load(std::memory_order_relaxed)) {
+        slot.min_temp_timestamp.store(system_clock::now().time_since_epoch().count(),
+                                      std::memory_order_relaxed);
+        slot.min_temp.store(temperature, std::memory_order_relaxed);
     }
 }
 
 void ThermalStatsHelper::updateSensorTempStatsBySeverity(std::string_view sensor,
                                                          const ThrottlingSeverity &severity) {
-    std::unique_lock<std::shared_mutex> _lock(sensor_stats_mutex_);
-    auto &temp_stats_map_ = sensor_stats.temp_stats_map_;
-    if (temp_stats_map_.count(sensor.data()) &&
-        temp_stats_map_[sensor.data()].stats_by_default_threshold.has_value()) {
-        auto &stats_record = temp_stats_map_[sensor.data()].stats_by_default_threshold.value();
-        int value = static_cast<int>(severity);
-        if (value != stats_record.cur_state) {
-            LOG(VERBOSE) << "Updating sensor stats for sensor: " << sensor.data()
-                         << " with value: " << value;
-            updateStatsRecord(&stats_record, value);
+    const auto slot_it = sensor_temp_stats_slot_map_.find(sensor.data());
+    if (slot_it == sensor_temp_stats_slot_map_.end()) {
+        return;
+    }
+    auto &slot = *slot_it->second;
+    std::lock_guard<std::mutex> _lock(slot.writer_mutex);
+    if (slot.time_to_mitigate_histogram != nullptr) {
+        if (severity == ThrottlingSeverity::NONE) {
+            slot.mitigation_pending_since_ns.store(0, std::memory_order_relaxed);
+        } else if (severity > slot.prev_severity &&
+                   !slot.mitigation_pending_since_ns.load(std::memory_order_relaxed)) {
+            slot.mitigation_pending_since_ns.store(toNs(boot_clock::now()),
+                                                   std::memory_order_relaxed);
         }
+        slot.prev_severity = severity;
+    }
+    if (slot.temp_stats.stats_by_default_threshold == nullptr) {
+        return;
+    }
+    auto &stats_record = *slot.temp_stats.stats_by_default_threshold;
+    int value = static_cast<int>(severity);
+    if (value != stats_record.getCurState()) {
+        LOG(VERBOSE) << "Updating sensor stats for sensor: " << sensor.data()
+                     << " with value: " << value;
+        stats_record.update(value);
+    }
+}
+
+void ThermalStatsHelper::updateCdevStateDwell(std::string_view cdev, int new_state) {
+    const auto slot_it = cdev_dwell_slot_map_.find(cdev.data());
+    if (slot_it == cdev_dwell_slot_map_.end()) {
+        return;
+    }
+    auto &slot = *slot_it->second;
+    std::lock_guard<std::mutex> _lock(slot.writer_mutex);
+    if (new_state == slot.cur_state) {
+        return;
     }
+    const auto now = boot_clock::now();
+    if (slot.cur_state >= 0 && static_cast<size_t>(slot.cur_state) < slot.dwell_histograms.size()) {
+        slot.dwell_histograms[slot.cur_state]->record(
+                std::chrono::duration_cast<std::chrono::milliseconds>(now -
+                                                                      slot.cur_state_start_time)
+                        .count());
+    }
+    slot.cur_state = new_state;
+    slot.cur_state_start_time = now;
 }
 
-void ThermalStatsHelper::verifySensorAbnormality(std::string_view sensor, float temp) {
+void ThermalStatsHelper::verifySensorAbnormality(std::string_view sensor,
+                                                 SensorTempStatsSlot *slot, float temp) {
     LOG(VERBOSE) << "Verify sensor abnormality for " << sensor << " with temp " << temp;
-    if (sensor_stats.temp_range_info_map_.count(sensor.data())) {
-        const auto &temp_range_info = sensor_stats.temp_range_info_map_[sensor.data()];
+    if (slot->temp_range_info != nullptr) {
+        const auto &temp_range_info = slot->temp_range_info;
         if (temp < temp_range_info->min_temp_threshold) {
             LOG(ERROR) << "Outlier Temperature Detected, sensor: " << sensor.data()
                        << " temp: " << temp << " < " << temp_range_info->min_temp_threshold;
@@ -348,9 +724,9 @@ void ThermalStatsHelper::verifySensorAbnormality(std::string_view sensor, float
                                      std::round(temp));
         }
     }
-    if (sensor_stats.temp_stuck_info_map_.count(sensor.data())) {
-        const auto &temp_stuck_info = sensor_stats.temp_stuck_info_map_[sensor.data()];
-        auto &curr_temp_status = sensor_stats.curr_temp_status_map_[sensor.data()];
+    if (slot->temp_stuck_info != nullptr) {
+        const auto &temp_stuck_info = slot->temp_stuck_info;
+        auto &curr_temp_status = slot->curr_temp_status;
         LOG(VERBOSE) << "Current Temp Status: temp=" << curr_temp_status.temp
                      << " repeat_count=" << curr_temp_status.repeat_count
                      << " start_time=" << curr_temp_status.start_time.time_since_epoch().count();
@@ -387,44 +763,58 @@ int ThermalStatsHelper::reportStats() {
                  << since_last_total_stats_update_ms.count();
     if (since_last_total_stats_update_ms < kUpdateIntervalMs) {
         LOG(VERBOSE) << "Time elapsed since last update less than " << kUpdateIntervalMs.count();
+        flushStats();
         return 0;
     }
 
     const std::shared_ptr<IStats> stats_client = getStatsService();
     if (!stats_client) {
         LOG(ERROR) << "Unable to get AIDL Stats service";
+        flushStats();
         return -1;
     }
     int count_failed_reporting =
             reportAllSensorTempStats(stats_client) + reportAllSensorCdevRequestStats(stats_client);
     last_total_stats_report_time = curTime;
     abnormal_stats_reported_per_update_interval = 0;
+    // Commit the new baseline so the reported time is not reported again after restart
+    flushStats(true);
     return count_failed_reporting;
 }
 
 int ThermalStatsHelper::reportAllSensorTempStats(const std::shared_ptr<IStats> &stats_client) {
     int count_failed_reporting = 0;
-    std::unique_lock<std::shared_mutex> _lock(sensor_stats_mutex_);
-    for (auto &[sensor, temp_stats] : sensor_stats.temp_stats_map_) {
+    for (auto &[sensor, slot] : sensor_temp_stats_slot_map_) {
+        auto &temp_stats = slot->temp_stats;
+        if (temp_stats.empty()) {
+            continue;
+        }
+        // Reset temp stats after reporting
+        SensorTempStats sensor_temp_stats;
+        sensor_temp_stats.max_temp_timestamp = SystemTimePoint(SystemTimePoint::duration(
+                slot->max_temp_timestamp.load(std::memory_order_relaxed)));
+        sensor_temp_stats.max_temp = slot->max_temp.exchange(std::numeric_limits<float>::min(),
+                                                             std::memory_order_relaxed);
+        sensor_temp_stats.min_temp_timestamp = SystemTimePoint(SystemTimePoint::duration(
+                slot->min_temp_timestamp.load(std::memory_order_relaxed)));
+        sensor_temp_stats.min_temp = slot->min_temp.exchange(std::numeric_limits<float>::max(),
+                                                             std::memory_order_relaxed);
         for (size_t threshold_set_idx = 0;
              threshold_set_idx < temp_stats.stats_by_custom_threshold.size(); threshold_set_idx++) {
-            auto &stats_by_threshold = temp_stats.stats_by_custom_threshold[threshold_set_idx];
+            auto &stats_by_threshold = *temp_stats.stats_by_custom_threshold[threshold_set_idx];
             std::string sensor_name = stats_by_threshold.logging_name.value_or(
                     sensor + kCustomThresholdSetSuffix.data() + std::to_string(threshold_set_idx));
-            if (!reportSensorTempStats(stats_client, sensor_name, temp_stats,
+            if (!reportSensorTempStats(stats_client, sensor_name, sensor_temp_stats, slot.get(),
                                        &stats_by_threshold.stats_record)) {
                 count_failed_reporting++;
             }
         }
-        if (temp_stats.stats_by_default_threshold.has_value()) {
-            if (!reportSensorTempStats(stats_client, sensor, temp_stats,
-                                       &temp_stats.stats_by_default_threshold.value())) {
+        if (temp_stats.stats_by_default_threshold != nullptr) {
+            if (!reportSensorTempStats(stats_client, sensor, sensor_temp_stats, slot.get(),
+                                       temp_stats.stats_by_default_threshold.get())) {
                 count_failed_reporting++;
             }
         }
-        // Reset temp stats after reporting
-        temp_stats.max_temp = std::numeric_limits<float>::min();
-        temp_stats.min_temp = std::numeric_limits<float>::max();
     }
     return count_failed_reporting;
 }
@@ -432,15 +822,17 @@ int ThermalStatsHelper::reportAllSensorTempStats(const std::shared_ptr<IStats> &
 bool ThermalStatsHelper::reportSensorTempStats(const std::shared_ptr<IStats> &stats_client,
                                                std::string_view sensor,
                                                const SensorTempStats &sensor_temp_stats,
-                                               StatsRecord *stats_record) {
+                                               SensorTempStatsSlot *slot,
+                                               AtomicStatsRecord *stats_record) {
     LOG(VERBOSE) << "Reporting sensor stats for " << sensor;
-    // maintain a copy in case reporting fails
-    StatsRecord thermal_stats_before_reporting = *stats_record;
+    // take a copy, the record keeps being updated while reporting
+    const StatsRecord stats_record_to_report = stats_record->load();
     std::vector<VendorAtomValue> values(2);
     values[0].set<VendorAtomValue::stringValue>(sensor);
-    std::vector<int64_t> time_in_state_ms = processStatsRecordForReporting(stats_record);
+    std::vector<int64_t> time_in_state_ms = processStatsRecordForReporting(stats_record_to_report);
     const auto since_last_update_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            stats_record->cur_state_start_time - stats_record->last_stats_report_time);
+            stats_record_to_report.cur_state_start_time -
+            stats_record_to_report.last_stats_report_time);
     values[1].set<VendorAtomValue::longValue>(since_last_update_ms.count());
     VendorAtomValue tmp;
     for (auto &time_in_state : time_in_state_ms) {
@@ -463,42 +855,45 @@ bool ThermalStatsHelper::reportSensorTempStats(const std::shared_ptr<IStats> &st
             system_clock::to_time_t(sensor_temp_stats.min_temp_timestamp));
     values.push_back(tmp);
 
-    if (!reportAtom(stats_client, PixelAtoms::Atom::kVendorTempResidencyStats, std::move(values))) {
+    const bool reported =
+            reportAtom(stats_client, PixelAtoms::Atom::kVendorTempResidencyStats, std::move(values));
+    std::lock_guard<std::mutex> _lock(slot->writer_mutex);
+    if (!reported) {
         LOG(ERROR) << "Unable to report VendorTempResidencyStats to Stats service for "
                       "sensor: "
                    << sensor;
-        *stats_record = restoreStatsRecordOnFailure(std::move(thermal_stats_before_reporting));
+        stats_record->markReportFailed(stats_record_to_report);
         return false;
     }
     // Update last time of stats reporting
-    stats_record->last_stats_report_time = boot_clock::now();
+    stats_record->markReported(stats_record_to_report);
     return true;
 }
 
 int ThermalStatsHelper::reportAllSensorCdevRequestStats(
         const std::shared_ptr<IStats> &stats_client) {
     int count_failed_reporting = 0;
-    std::unique_lock<std::shared_mutex> _lock(sensor_cdev_request_stats_map_mutex_);
-    for (auto &[sensor, cdev_request_stats_map] : sensor_cdev_request_stats_map_) {
-        for (auto &[cdev, request_stats] : cdev_request_stats_map) {
+    for (auto &[sensor, cdev_request_stats_slot_map] : sensor_cdev_request_stats_slot_map_) {
+        for (auto &[cdev, slot] : cdev_request_stats_slot_map) {
+            auto &request_stats = slot->request_stats;
             for (size_t threshold_set_idx = 0;
                  threshold_set_idx < request_stats.stats_by_custom_threshold.size();
                  threshold_set_idx++) {
                 auto &stats_by_threshold =
-                        request_stats.stats_by_custom_threshold[threshold_set_idx];
+                        *request_stats.stats_by_custom_threshold[threshold_set_idx];
                 std::string cdev_name = stats_by_threshold.logging_name.value_or(
                         cdev + kCustomThresholdSetSuffix.data() +
                         std::to_string(threshold_set_idx));
-                if (!reportSensorCdevRequestStats(stats_client, sensor, cdev_name,
+                if (!reportSensorCdevRequestStats(stats_client, sensor, cdev_name, slot.get(),
                                                   &stats_by_threshold.stats_record)) {
                     count_failed_reporting++;
                 }
             }
 
-            if (request_stats.stats_by_default_threshold.has_value()) {
+            if (request_stats.stats_by_default_threshold != nullptr) {
                 if (!reportSensorCdevRequestStats(
-                            stats_client, sensor, cdev,
-                            &request_stats.stats_by_default_threshold.value())) {
+                            stats_client, sensor, cdev, slot.get(),
+                            request_stats.stats_by_default_threshold.get())) {
                     count_failed_reporting++;
                 }
             }
@@ -510,17 +905,19 @@ int ThermalStatsHelper::reportAllSensorCdevRequestStats(
 bool ThermalStatsHelper::reportSensorCdevRequestStats(const std::shared_ptr<IStats> &stats_client,
                                                       std::string_view sensor,
                                                       std::string_view cdev,
-                                                      StatsRecord *stats_record) {
+                                                      SensorCdevRequestStatsSlot *slot,
+                                                      AtomicStatsRecord *stats_record) {
     LOG(VERBOSE) << "Reporting bindedCdev stats for sensor: " << sensor
                  << " cooling_device: " << cdev;
-    // maintain a copy in case reporting fails
-    StatsRecord thermal_stats_before_reporting = *stats_record;
+    // take a copy, the record keeps being updated while reporting
+    const StatsRecord stats_record_to_report = stats_record->load();
     std::vector<VendorAtomValue> values(3);
     values[0].set<VendorAtomValue::stringValue>(sensor);
     values[1].set<VendorAtomValue::stringValue>(cdev);
-    std::vector<int64_t> time_in_state_ms = processStatsRecordForReporting(stats_record);
+    std::vector<int64_t> time_in_state_ms = processStatsRecordForReporting(stats_record_to_report);
     const auto since_last_update_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            stats_record->cur_state_start_time - stats_record->last_stats_report_time);
+            stats_record_to_report.cur_state_start_time -
+            stats_record_to_report.last_stats_report_time);
     values[2].set<VendorAtomValue::longValue>(since_last_update_ms.count());
     VendorAtomValue tmp;
     for (auto &time_in_state : time_in_state_ms) {
@@ -528,29 +925,28 @@ bool ThermalStatsHelper::reportSensorCdevRequestStats(const std::shared_ptr<ISta
         values.push_back(tmp);
     }
 
-    if (!reportAtom(stats_client, PixelAtoms::Atom::kVendorSensorCoolingDeviceStats,
-                    std::move(values))) {
+    const bool reported = reportAtom(stats_client, PixelAtoms::Atom::kVendorSensorCoolingDeviceStats,
+                                     std::move(values));
+    std::lock_guard<std::mutex> _lock(slot->writer_mutex);
+    if (!reported) {
         LOG(ERROR) << "Unable to report VendorSensorCoolingDeviceStats to Stats "
                       "service for sensor: "
                    << sensor << " cooling_device: " << cdev;
-        *stats_record = restoreStatsRecordOnFailure(std::move(thermal_stats_before_reporting));
+        stats_record->markReportFailed(stats_record_to_report);
         return false;
     }
     // Update last time of stats reporting
-    stats_record->last_stats_report_time = boot_clock::now();
+    stats_record->markReported(stats_record_to_report);
     return true;
 }
 
-std::vector<int64_t> ThermalStatsHelper::processStatsRecordForReporting(StatsRecord *stats_record) {
-    // update the last unclosed entry and start new record with same state
-    updateStatsRecord(stats_record, stats_record->cur_state);
-    std::vector<std::chrono::milliseconds> &time_in_state_ms = stats_record->time_in_state_ms;
+std::vector<int64_t> ThermalStatsHelper::processStatsRecordForReporting(
+        const StatsRecord &stats_record) {
     // convert std::chrono::milliseconds time_in_state to int64_t vector for reporting
-    std::vector<int64_t> stats_residency(time_in_state_ms.size());
-    std::transform(time_in_state_ms.begin(), time_in_state_ms.end(), stats_residency.begin(),
+    std::vector<int64_t> stats_residency(stats_record.time_in_state_ms.size());
+    std::transform(stats_record.time_in_state_ms.begin(), stats_record.time_in_state_ms.end(),
+                   stats_residency.begin(),
                    [](std::chrono::milliseconds time_ms) { return time_ms.count(); });
-    // clear previous stats
-    std::fill(time_in_state_ms.begin(), time_in_state_ms.end(), std::chrono::milliseconds::zero());
     return stats_residency;
 }
 
@@ -597,57 +993,60 @@ bool ThermalStatsHelper::reportAtom(const std::shared_ptr<IStats> &stats_client,
     return ret.isOk();
 }
 
-StatsRecord ThermalStatsHelper::restoreStatsRecordOnFailure(
-        StatsRecord &&stats_record_before_failure) {
-    stats_record_before_failure.report_fail_count += 1;
-    // If consecutive count of failure is high, reset stat to avoid overflow
-    if (stats_record_before_failure.report_fail_count >= kMaxStatsReportingFailCount) {
-        return StatsRecord(stats_record_before_failure.time_in_state_ms.size(),
-                           stats_record_before_failure.cur_state);
-    } else {
-        return stats_record_before_failure;
-    }
-}
-
 std::unordered_map<std::string, SensorTempStats> ThermalStatsHelper::GetSensorTempStatsSnapshot() {
-    auto sensor_temp_stats_snapshot = sensor_stats.temp_stats_map_;
-    for (auto &sensor_temp_stats_pair : sensor_temp_stats_snapshot) {
-        for (auto &temp_stats : sensor_temp_stats_pair.second.stats_by_custom_threshold) {
-            // update the last unclosed entry and start new record with same state
-            updateStatsRecord(&temp_stats.stats_record, temp_stats.stats_record.cur_state);
-        }
-        if (sensor_temp_stats_pair.second.stats_by_default_threshold.has_value()) {
-            auto &stats_by_default_threshold =
-                    sensor_temp_stats_pair.second.stats_by_default_threshold.value();
-            // update the last unclosed entry and start new record with same state
-            updateStatsRecord(&stats_by_default_threshold, stats_by_default_threshold.cur_state);
+    std::unordered_map<std::string, SensorTempStats> sensor_temp_stats_snapshot;
+    for (const auto &[sensor, slot] : sensor_temp_stats_slot_map_) {
+        if (slot->temp_stats.empty()) {
+            continue;
         }
+        auto &sensor_temp_stats = sensor_temp_stats_snapshot[sensor];
+        static_cast<ThermalStats<float> &>(sensor_temp_stats) = loadThermalStats(slot->temp_stats);
+        sensor_temp_stats.max_temp = slot->max_temp.load(std::memory_order_relaxed);
+        sensor_temp_stats.max_temp_timestamp = SystemTimePoint(SystemTimePoint::duration(
+                slot->max_temp_timestamp.load(std::memory_order_relaxed)));
+        sensor_temp_stats.min_temp = slot->min_temp.load(std::memory_order_relaxed);
+        sensor_temp_stats.min_temp_timestamp = SystemTimePoint(SystemTimePoint::duration(
+                slot->min_temp_timestamp.load(std::memory_order_relaxed)));
     }
     return sensor_temp_stats_snapshot;
 }
 
 std::unordered_map<std::string, std::unordered_map<std::string, ThermalStats<int>>>
 ThermalStatsHelper::GetSensorCoolingDeviceRequestStatsSnapshot() {
-    auto sensor_cdev_request_stats_snapshot = sensor_cdev_request_stats_map_;
-    for (auto &sensor_cdev_request_stats_pair : sensor_cdev_request_stats_snapshot) {
-        for (auto &cdev_request_stats_pair : sensor_cdev_request_stats_pair.second) {
-            for (auto &request_stats : cdev_request_stats_pair.second.stats_by_custom_threshold) {
-                // update the last unclosed entry and start new record with same state
-                updateStatsRecord(&request_stats.stats_record,
-                                  request_stats.stats_record.cur_state);
-            }
-            if (cdev_request_stats_pair.second.stats_by_default_threshold.has_value()) {
-                auto &stats_by_default_threshold =
-                        cdev_request_stats_pair.second.stats_by_default_threshold.value();
-                // update the last unclosed entry and start new record with same state
-                updateStatsRecord(&stats_by_default_threshold,
-                                  stats_by_default_threshold.cur_state);
+    std::unordered_map<std::string, std::unordered_map<std::string, ThermalStats<int>>>
+            sensor_cdev_request_stats_snapshot;
+    for (const auto &[sensor, cdev_request_stats_slot_map] : sensor_cdev_request_stats_slot_map_) {
+        for (const auto &[cdev, slot] : cdev_request_stats_slot_map) {
+            if (!slot->request_stats.empty()) {
+                sensor_cdev_request_stats_snapshot[sensor][cdev] =
+                        loadThermalStats(slot->request_stats);
             }
         }
     }
     return sensor_cdev_request_stats_snapshot;
 }
 
+ThermalHistogramsSnapshot ThermalStatsHelper::GetThermalHistogramsSnapshot() const {
+    ThermalHistogramsSnapshot histograms_snapshot;
+    for (const auto &[sensor, slot] : sensor_temp_stats_slot_map_) {
+        if (slot->temp_histogram != nullptr) {
+            histograms_snapshot.sensor_temp[sensor] =
+                    slot->temp_histogram->snapshot(kTempHistogramResolution, kTempHistogramMin);
+        }
+        if (slot->time_to_mitigate_histogram != nullptr) {
+            histograms_snapshot.sensor_time_to_mitigate[sensor] =
+                    slot->time_to_mitigate_histogram->snapshot();
+        }
+    }
+    for (const auto &[cdev, slot] : cdev_dwell_slot_map_) {
+        auto &cdev_state_dwell = histograms_snapshot.cdev_state_dwell[cdev];
+        for (const auto &dwell_histogram : slot->dwell_histograms) {
+            cdev_state_dwell.emplace_back(dwell_histogram->snapshot());
+        }
+    }
+    return histograms_snapshot;
+}
+
 }  // namespace implementation
 }  // namespace thermal
 }  // namespace hardware
@@ -11,13 +11,18 @@
 #include <android-base/chrono_utils.h>
 #include <hardware/google/pixel/pixelstats/pixelatoms.pb.h>
 
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <mutex>
 #include <shared_mutex>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
 
 #include "thermal_info.h"
+#include "thermal_stats_store.h"
 
 namespace aidl {
 namespace android {
@@ -40,6 +45,12 @@ constexpr int kMaxStatsReportingFailCount = 3;
 // -2.
 constexpr int kVendorAtomOffset = 2;
 constexpr float kPrecisionThreshold = 1e-4;
+constexpr std::string_view kThermalStatsStorePath("/data/vendor/thermal/thermal_stats.bin");
+// Interval to commit the in-memory stats to the stats store
+constexpr std::chrono::milliseconds kStatsFlushIntervalMs = std::chrono::milliseconds(60000);
+// Temperature histogram records in kTempHistogramResolution steps above kTempHistogramMin
+constexpr float kTempHistogramMin = -40.0;
+constexpr float kTempHistogramResolution = 0.5;
 
 struct StatsRecord {
     int cur_state; /* temperature / cdev state at current time */
@@ -97,21 +108,187 @@ struct SensorTempStats : ThermalStats<float> {
     SystemTimePoint min_temp_timestamp = SystemTimePoint::min();
 };
 
+// Snapshot of a histogram, buckets are kept as (upper bound, count) for the non-empty ones
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    std::vector<std::pair<float, uint64_t>> buckets;
+    // Return the upper bound of the bucket holding the given percentile, NAN if empty
+    float getPercentile(float percentile) const;
+};
+
+// Log-linear histogram of non-negative integers (HDR style). Values below 2^kSubBucketBits are
+// recorded exactly, larger ones with a relative error of 2^-(kSubBucketBits - 1), values from
+// 2^kMaxValueBits are clamped to the last bucket. Recording is O(1) with relaxed atomics so it
+// can be done from the update hooks, and a snapshot never blocks the writer.
+template <size_t kSubBucketBits, size_t kMaxValueBits>
+class LogLinearHistogram {
+  public:
+    static constexpr size_t kSubBucketCount = size_t(1) << kSubBucketBits;
+    static constexpr size_t kHalfSubBucketCount = kSubBucketCount / 2;
+    static constexpr size_t kBucketCount =
+            kSubBucketCount + (kMaxValueBits - kSubBucketBits) * kHalfSubBucketCount;
+
+    void record(int64_t value) {
+        counts_[getBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Values are converted to value * scale + offset in the snapshot
+    HistogramSnapshot snapshot(float scale = 1.0, float offset = 0.0) const {
+        HistogramSnapshot histogram_snapshot;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            const uint64_t count = counts_[i].load(std::memory_order_relaxed);
+            if (count) {
+                histogram_snapshot.count += count;
+                histogram_snapshot.buckets.emplace_back(getBucketUpperBound(i) * scale + offset,
+                                                        count);
+            }
+        }
+        return histogram_snapshot;
+    }
+
+  private:
+    static size_t getBucketIndex(int64_t value) {
+        if (value < static_cast<int64_t>(kSubBucketCount)) {
+            return value < 0 ? 0 : value;
+        }
+        if (value >= (int64_t(1) << kMaxValueBits)) {
+            return kBucketCount - 1;
+        }
+        // value >> shift is in [kHalfSubBucketCount, kSubBucketCount)
+        const size_t shift = 63 - __builtin_clzll(value) - kSubBucketBits + 1;
+        return kSubBucketCount + (shift - 1) * kHalfSubBucketCount + (value >> shift) -
+               kHalfSubBucketCount;
+    }
+    static int64_t getBucketUpperBound(size_t idx) {
+        if (idx < kSubBucketCount) {
+            return idx;
+        }
+        const size_t shift = (idx - kSubBucketCount) / kHalfSubBucketCount + 1;
+        const int64_t sub_bucket = (idx - kSubBucketCount) % kHalfSubBucketCount + kHalfSubBucketCount;
+        return ((sub_bucket + 1) << shift) - 1;
+    }
+    std::array<std::atomic<uint32_t>, kBucketCount> counts_{};
+};
+
+// 0.5C steps, exact up to 87.5C, then 1C steps up to ~216C and 2C steps up to ~472C
+using TempHistogram = LogLinearHistogram<8, 10>;
+// Milliseconds with 12.5% error, clamped at ~4.6 hours
+using DurationHistogram = LogLinearHistogram<4, 24>;
+
+struct ThermalHistogramsSnapshot {
+    // Temperature distribution of the watched sensors
+    std::unordered_map<std::string, HistogramSnapshot> sensor_temp;
+    // Time from a severity rise of a sensor to its next cdev request increase
+    std::unordered_map<std::string, HistogramSnapshot> sensor_time_to_mitigate;
+    // Dwell time of each cdev at each state, indexed by state
+    std::unordered_map<std::string, std::vector<HistogramSnapshot>> cdev_state_dwell;
+};
+
 struct CurrTempStatus {
     float temp;
     boot_clock::time_point start_time;
     int repeat_count;
 };
 
-struct SensorStats {
-    // Temperature residency stats for each sensor being watched
-    std::unordered_map<std::string, SensorTempStats> temp_stats_map_;
-    // Min, Max Temp threshold info for each sensor being monitored
-    std::unordered_map<std::string, std::shared_ptr<TempRangeInfo>> temp_range_info_map_;
-    // Temperature Stuck info for each sensor being monitored
-    std::unordered_map<std::string, std::shared_ptr<TempStuckInfo>> temp_stuck_info_map_;
-    // Current temperature status for each sensor being monitored for stuck
-    std::unordered_map<std::string, CurrTempStatus> curr_temp_status_map_;
+// Residency record shared by a single writer and many readers. The writer publishes every
+// state change under a sequence counter, readers copy the record with load() and retry on a
+// torn read, so they never block the writer. Time reported to stats is kept as a baseline
+// instead of clearing the counters.
+class AtomicStatsRecord {
+  public:
+    explicit AtomicStatsRecord(const size_t &time_in_state_size, int state = 0);
+    // Disallow copy and assign
+    AtomicStatsRecord(const AtomicStatsRecord &) = delete;
+    void operator=(const AtomicStatsRecord &) = delete;
+
+    int getCurState() const { return cur_state_.load(std::memory_order_relaxed); }
+    // Close the current state and start to record the new state, only called by the writer
+    void update(int new_state);
+    // Copy of the record since the last report, with the current state closed at now
+    StatsRecord load() const;
+    // Move the baseline to a snapshot returned by load(), serialized with the writer
+    void markReported(const StatsRecord &reported_record);
+    // Keep the baseline so the time is reported next time, or drop it after too many failures
+    void markReportFailed(const StatsRecord &reported_record);
+    // Add back the unreported time persisted by a previous instance, called before any update
+    void restore(const std::vector<std::chrono::milliseconds> &time_in_state_ms,
+                 std::chrono::milliseconds since_last_report);
+    size_t getTimeInStateSize() const { return time_in_state_size_; }
+
+  private:
+    void beginWrite();
+    void endWrite();
+    const size_t time_in_state_size_;
+    std::atomic<uint32_t> seq_ = 0;
+    std::atomic<int> cur_state_;
+    std::atomic<int64_t> cur_state_start_time_ns_;
+    std::atomic<int64_t> last_stats_report_time_ns_;
+    std::atomic<int> report_fail_count_ = 0;
+    // Accumulated and already reported time of each state
+    std::unique_ptr<std::atomic<int64_t>[]> time_in_state_ms_;
+    std::unique_ptr<std::atomic<int64_t>[]> reported_time_in_state_ms_;
+};
+
+template <typename ValueType>
+struct AtomicStatsByThreshold {
+    const std::vector<ValueType> thresholds;
+    const std::optional<std::string> logging_name;
+    AtomicStatsRecord stats_record;
+    explicit AtomicStatsByThreshold(const ThresholdList<ValueType> &threshold_list)
+        : thresholds(threshold_list.thresholds),
+          logging_name(threshold_list.logging_name),
+          // number of states = number of thresholds + 1
+          stats_record(threshold_list.thresholds.size() + 1) {}
+};
+
+template <typename ValueType>
+struct AtomicThermalStats {
+    std::vector<std::unique_ptr<AtomicStatsByThreshold<ValueType>>> stats_by_custom_threshold;
+    std::unique_ptr<AtomicStatsRecord> stats_by_default_threshold;
+    bool empty() const {
+        return stats_by_custom_threshold.empty() && stats_by_default_threshold == nullptr;
+    }
+};
+
+// Stats slot of a sensor, allocated in initializeStats and never resized afterwards so that
+// it can be looked up without holding a lock.
+struct SensorTempStatsSlot {
+    // Serializes the writers (watcher and binder threads reading the sensor), readers never
+    // take it
+    std::mutex writer_mutex;
+    AtomicThermalStats<float> temp_stats;
+    std::atomic<float> max_temp = std::numeric_limits<float>::min();
+    std::atomic<int64_t> max_temp_timestamp = SystemTimePoint::min().time_since_epoch().count();
+    std::atomic<float> min_temp = std::numeric_limits<float>::max();
+    std::atomic<int64_t> min_temp_timestamp = SystemTimePoint::min().time_since_epoch().count();
+    // Min, Max Temp threshold info of the sensor
+    std::shared_ptr<TempRangeInfo> temp_range_info;
+    // Temperature Stuck info of the sensor
+    std::shared_ptr<TempStuckInfo> temp_stuck_info;
+    // Current temperature status of the sensor for stuck detection
+    CurrTempStatus curr_temp_status;
+    // Distribution histograms, only allocated for the watched sensors
+    std::unique_ptr<TempHistogram> temp_histogram;
+    std::unique_ptr<DurationHistogram> time_to_mitigate_histogram;
+    ThrottlingSeverity prev_severity = ThrottlingSeverity::NONE;
+    // Start of the pending mitigation in boot_clock ns, 0 if there is none
+    std::atomic<int64_t> mitigation_pending_since_ns = 0;
+};
+
+// Stats slot of a sensor's request to a binded cooling device
+struct SensorCdevRequestStatsSlot {
+    std::mutex writer_mutex;
+    AtomicThermalStats<int> request_stats;
+    int prev_request = 0;
+};
+
+// Throttling depth of a cooling device
+struct CdevDwellSlot {
+    std::mutex writer_mutex;
+    int cur_state = 0;
+    boot_clock::time_point cur_state_start_time;
+    // One histogram per state
+    std::vector<std::unique_ptr<DurationHistogram>> dwell_histograms;
 };
 
 class ThermalStatsHelper {
@@ -130,6 +307,8 @@ class ThermalStatsHelper {
     void updateSensorTempStatsBySeverity(std::string_view sensor,
                                          const ThrottlingSeverity &severity);
     void updateSensorTempStatsByThreshold(std::string_view sensor, float temperature);
+    // Record the dwell time of the previous state when a cooling device changes its state
+    void updateCdevStateDwell(std::string_view cdev, int new_state);
     /*
      * Function to report all the stats by calling all specific stats reporting function.
      * Returns:
@@ -138,6 +317,8 @@ class ThermalStatsHelper {
      *  >0, count represents the number of stats failed to report.
      */
     int reportStats();
+    // Commit the stats to the stats store if kStatsFlushIntervalMs has elapsed
+    void flushStats(bool force = false);
     bool reportThermalAbnormality(const ThermalSensorAbnormalityDetected::AbnormalityType &type,
                                   std::string_view name, std::optional<int> reading);
     // Get a snapshot of Thermal Stats Sensor Map till that point in time
@@ -145,19 +326,29 @@ class ThermalStatsHelper {
     // Get a snapshot of Thermal Stats Sensor Map till that point in time
     std::unordered_map<std::string, std::unordered_map<std::string, ThermalStats<int>>>
     GetSensorCoolingDeviceRequestStatsSnapshot();
+    // Get a snapshot of the distribution histograms
+    ThermalHistogramsSnapshot GetThermalHistogramsSnapshot() const;
 
   private:
     static constexpr std::chrono::milliseconds kUpdateIntervalMs =
             std::chrono::duration_cast<std::chrono::milliseconds>(24h);
     boot_clock::time_point last_total_stats_report_time = boot_clock::time_point::min();
-    int abnormal_stats_reported_per_update_interval = 0;
-    mutable std::shared_mutex sensor_stats_mutex_;
-    SensorStats sensor_stats;
-    mutable std::shared_mutex sensor_cdev_request_stats_map_mutex_;
+    std::atomic<int> abnormal_stats_reported_per_update_interval = 0;
+    // Stats slot for each sensor, the map itself is immutable after initializeStats
+    std::unordered_map<std::string, std::unique_ptr<SensorTempStatsSlot>>
+            sensor_temp_stats_slot_map_;
     // userVote request stat for the sensor to the corresponding cdev (sensor -> cdev ->
-    // StatsRecord)
-    std::unordered_map<std::string, std::unordered_map<std::string, ThermalStats<int>>>
-            sensor_cdev_request_stats_map_;
+    // stats slot), the maps are immutable after initializeStats
+    std::unordered_map<std::string,
+                       std::unordered_map<std::string, std::unique_ptr<SensorCdevRequestStatsSlot>>>
+            sensor_cdev_request_stats_slot_map_;
+    // State dwell of each cooling device, immutable after initializeStats
+    std::unordered_map<std::string, std::unique_ptr<CdevDwellSlot>> cdev_dwell_slot_map_;
+    // Persisted temp stats slots and records in the order of the stats store payload
+    std::vector<SensorTempStatsSlot *> persisted_temp_stats_slots_;
+    std::vector<AtomicStatsRecord *> persisted_stats_records_;
+    ThermalStatsStore stats_store_;
+    boot_clock::time_point last_stats_flush_time_ = boot_clock::time_point::min();
 
     bool initializeSensorTempStats(
             const StatsInfo<float> &sensor_stats_info,
@@ -169,19 +360,23 @@ class ThermalStatsHelper {
     bool initializeSensorAbnormalityStats(
             const AbnormalStatsInfo &abnormal_stats_info,
             const std::unordered_map<std::string, SensorInfo> &sensor_info_map_);
-    void updateStatsRecord(StatsRecord *stats_record, int new_state);
-    void verifySensorAbnormality(std::string_view sensor, float temperature);
+    // Map the stats store and restore the stats left by the previous instance
+    void initializeStatsStore();
+    size_t getStatsStorePayloadCount() const;
+    void verifySensorAbnormality(std::string_view sensor, SensorTempStatsSlot *slot,
+                                 float temperature);
     int reportAllSensorTempStats(const std::shared_ptr<IStats> &stats_client);
     bool reportSensorTempStats(const std::shared_ptr<IStats> &stats_client, std::string_view sensor,
-                               const SensorTempStats &sensor_temp_stats, StatsRecord *stats_record);
+                               const SensorTempStats &sensor_temp_stats,
+                               SensorTempStatsSlot *slot, AtomicStatsRecord *stats_record);
     int reportAllSensorCdevRequestStats(const std::shared_ptr<IStats> &stats_client);
     bool reportSensorCdevRequestStats(const std::shared_ptr<IStats> &stats_client,
                                       std::string_view sensor, std::string_view cdev,
-                                      StatsRecord *stats_record);
+                                      SensorCdevRequestStatsSlot *slot,
+                                      AtomicStatsRecord *stats_record);
     bool reportAtom(const std::shared_ptr<IStats> &stats_client, const int32_t &atom_id,
                     std::vector<VendorAtomValue> &&values);
-    std::vector<int64_t> processStatsRecordForReporting(StatsRecord *stats_record);
-    StatsRecord restoreStatsRecordOnFailure(StatsRecord &&stats_record_before_failure);
+    std::vector<int64_t> processStatsRecordForReporting(const StatsRecord &stats_record);
 };
 
 }  // namespace implementation
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "thermal_stats_store.h"
+
+#include <android-base/logging.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <atomic>
+#include <cstring>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+namespace {
+
+constexpr uint32_t kStatsStoreMagic = 0x54485354;  // "THST"
+constexpr uint32_t kStatsStoreVersion = 1;
+constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ULL;
+constexpr uint64_t kFnvPrime = 0x100000001b3ULL;
+
+}  // namespace
+
+uint64_t hashStatsData(const void *data, size_t size, uint64_t seed) {
+    uint64_t hash = seed ? seed : kFnvOffsetBasis;
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+ThermalStatsStore::~ThermalStatsStore() {
+    if (mapped_ != nullptr) {
+        msync(mapped_, mapped_size_, MS_SYNC);
+        munmap(mapped_, mapped_size_);
+    }
+}
+
+int64_t *ThermalStatsStore::payloadCopy(size_t idx) const {
+    return reinterpret_cast<int64_t *>(static_cast<uint8_t *>(mapped_) + sizeof(Header)) +
+           idx * payload_count_;
+}
+
+bool ThermalStatsStore::isCopyValid(size_t idx) const {
+    return header()->generation[idx] != 0 &&
+           header()->checksum[idx] == hashStatsData(payloadCopy(idx),
+                                                    payload_count_ * sizeof(int64_t),
+                                                    header()->generation[idx]);
+}
+
+bool ThermalStatsStore::open(std::string_view path, uint64_t layout_hash, size_t payload_count) {
+    fd_.reset(TEMP_FAILURE_RETRY(
+            ::open(path.data(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP)));
+    if (fd_ == -1) {
+        PLOG(WARNING) << "Failed to open thermal stats store " << path;
+        return false;
+    }
+
+    payload_count_ = payload_count;
+    mapped_size_ = sizeof(Header) + 2 * payload_count * sizeof(int64_t);
+    struct stat st;
+    const bool size_matched = fstat(fd_, &st) == 0 && static_cast<size_t>(st.st_size) == mapped_size_;
+    if (!size_matched && ftruncate(fd_, mapped_size_) != 0) {
+        PLOG(ERROR) << "Failed to resize thermal stats store " << path;
+        fd_.reset();
+        return false;
+    }
+
+    void *mapped = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        PLOG(ERROR) << "Failed to mmap thermal stats store " << path;
+        fd_.reset();
+        return false;
+    }
+    mapped_ = mapped;
+
+    if (!size_matched || header()->magic != kStatsStoreMagic ||
+        header()->version != kStatsStoreVersion || header()->layout_hash != layout_hash ||
+        header()->payload_count != payload_count) {
+        LOG(INFO) << "Reset thermal stats store " << path << " for the new stats layout";
+        std::memset(mapped_, 0, mapped_size_);
+        header()->magic = kStatsStoreMagic;
+        header()->version = kStatsStoreVersion;
+        header()->layout_hash = layout_hash;
+        header()->payload_count = payload_count;
+        msync(mapped_, mapped_size_, MS_ASYNC);
+    }
+    return true;
+}
+
+bool ThermalStatsStore::read(std::vector<int64_t> *payload) const {
+    if (mapped_ == nullptr) {
+        return false;
+    }
+    // Fall back to the other copy if the active one is torn
+    const size_t active = header()->active & 1;
+    for (const size_t idx : {active, 1 - active}) {
+        if (isCopyValid(idx)) {
+            payload->assign(payloadCopy(idx), payloadCopy(idx) + payload_count_);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThermalStatsStore::write(const std::vector<int64_t> &payload) {
+    if (mapped_ == nullptr || payload.size() != payload_count_) {
+        return;
+    }
+    const size_t active = header()->active & 1;
+    const size_t inactive = 1 - active;
+    const uint64_t generation = header()->generation[active] + 1;
+    std::memcpy(payloadCopy(inactive), payload.data(), payload_count_ * sizeof(int64_t));
+    header()->generation[inactive] = generation;
+    header()->checksum[inactive] =
+            hashStatsData(payload.data(), payload_count_ * sizeof(int64_t), generation);
+    std::atomic_thread_fence(std::memory_order_release);
+    header()->active = inactive;
+    msync(mapped_, mapped_size_, MS_ASYNC);
+}
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
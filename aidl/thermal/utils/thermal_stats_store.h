@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace implementation {
+
+using ::android::base::unique_fd;
+
+// FNV-1a hash, used for both the layout identity and the payload checksum
+uint64_t hashStatsData(const void *data, size_t size, uint64_t seed);
+
+// An mmapped file which keeps the last committed copy of the thermal stats.
+// The payload is double buffered: a new copy is written to the inactive half and committed by
+// flipping the active index, so a crash in the middle of a write leaves the previous copy valid.
+class ThermalStatsStore {
+  public:
+    ThermalStatsStore() = default;
+    ~ThermalStatsStore();
+    // Disallow copy and assign
+    ThermalStatsStore(const ThermalStatsStore &) = delete;
+    void operator=(const ThermalStatsStore &) = delete;
+
+    // Map the file for a payload of the given layout, the file is reset if the layout changed
+    bool open(std::string_view path, uint64_t layout_hash, size_t payload_count);
+    bool isOpened() const { return mapped_ != nullptr; }
+    // Get the last committed payload, return false if there is no valid copy
+    bool read(std::vector<int64_t> *payload) const;
+    // Commit a new payload and schedule the write back without waiting for it
+    void write(const std::vector<int64_t> &payload);
+
+  private:
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t layout_hash;
+        uint64_t payload_count;
+        uint64_t active;
+        uint64_t generation[2];
+        uint64_t checksum[2];
+    };
+    Header *header() const { return reinterpret_cast<Header *>(mapped_); }
+    int64_t *payloadCopy(size_t idx) const;
+    bool isCopyValid(size_t idx) const;
+    unique_fd fd_;
+    void *mapped_ = nullptr;
+    size_t mapped_size_ = 0;
+    size_t payload_count_ = 0;
+};
+
+}  // namespace implementation
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -48,6 +48,70 @@ size_t getTargetStateOfPID(const SensorInfo &sensor_info, const ThrottlingSeveri
     return target_state;
 }
 
+namespace {
+
+// The temperature a PREDICTIVE release must keep the forecast under: the PID target, else the
+// next hot threshold above the severity
+size_t getReleaseTargetState(const SensorInfo &sensor_info, const ThrottlingSeverity severity) {
+    const auto pid_target_state = getTargetStateOfPID(sensor_info, severity);
+    if (!std::isnan(sensor_info.hot_thresholds[pid_target_state])) {
+        return pid_target_state;
+    }
+    for (size_t i = static_cast<size_t>(severity) + 1; i < kThrottlingSeverityCount; ++i) {
+        if (!std::isnan(sensor_info.hot_thresholds[i])) {
+            return i;
+        }
+    }
+    return static_cast<size_t>(severity);
+}
+
+// Release as many states as the power headroom pays for, scaled down as the forecast comes
+// within the hysteresis of the target. Either headroom gone drops the release at once.
+int computePredictiveReleaseStep(const SensorInfo &sensor_info,
+                                 const BindedCdevInfo &binded_cdev_info, const CdevInfo &cdev_info,
+                                 const ThrottlingSeverity severity, const float avg_power,
+                                 const SensorForecast *forecast, const int request,
+                                 const int release_step) {
+    const float power_threshold = binded_cdev_info.power_thresholds[static_cast<size_t>(severity)];
+    const size_t target_state = getReleaseTargetState(sensor_info, severity);
+    const float target_temp = sensor_info.hot_thresholds[target_state];
+    if (forecast == nullptr || std::isnan(forecast->predicted_temp) || std::isnan(target_temp) ||
+        std::isnan(power_threshold)) {
+        return 0;
+    }
+    const float power_headroom = power_threshold - avg_power;
+    const float temp_headroom = target_temp - forecast->predicted_temp;
+    if (power_headroom <= 0 || temp_headroom <= 0) {
+        return 0;
+    }
+    const float margin = sensor_info.hot_hysteresis[target_state];
+    const float power_budget =
+            power_headroom * ((margin > 0) ? std::min(temp_headroom / margin, 1.0f) : 1.0f);
+
+    // The power is measured at the released state, each further state costs its extra power
+    const int released_state = std::max(request - release_step, 0);
+    int target = released_state;
+    while (target > 0 && released_state - target < binded_cdev_info.release_step_limit) {
+        if (cdev_info.state2power.size() > static_cast<size_t>(released_state)) {
+            if (cdev_info.state2power[target - 1] - cdev_info.state2power[released_state] >
+                power_budget) {
+                break;
+            }
+        } else if (target != released_state) {
+            // Without a power model the release moves one state per update
+            break;
+        }
+        target--;
+    }
+    LOG(VERBOSE) << "Predictive release: target_temp=" << target_temp
+                 << " predicted_temp=" << forecast->predicted_temp
+                 << " power_budget=" << power_budget << " released_state " << released_state
+                 << " -> " << target;
+    return request - target;
+}
+
+}  // namespace
+
 void ThermalThrottling::parseProfileProperty(std::string_view sensor_name,
                                              const SensorInfo &sensor_info) {
     if (sensor_info.throttling_info == nullptr) {
@@ -76,6 +140,9 @@ void ThermalThrottling::clearThrottlingData(std::string_view sensor_name,
         return;
     }
     std::unique_lock<std::shared_mutex> _lock(thermal_throttling_status_map_mutex_);
+    if (thermal_throttling_status_map_.at(sensor_name.data()).is_cleared) {
+        return;
+    }
 
     for (auto &pid_power_budget_pair :
          thermal_throttling_status_map_.at(sensor_name.data()).pid_power_budget_map) {
@@ -104,10 +171,41 @@ void ThermalThrottling::clearThrottlingData(std::string_view sensor_name,
             static_cast<size_t>(ThrottlingSeverity::NONE);
     thermal_throttling_status_map_[sensor_name.data()].prev_power_budget = NAN;
     thermal_throttling_status_map_[sensor_name.data()].tran_cycle = 0;
+    thermal_throttling_status_map_[sensor_name.data()].last_input_temp = NAN;
+    thermal_throttling_status_map_[sensor_name.data()].is_steady = false;
+    thermal_throttling_status_map_[sensor_name.data()].is_request_dirty = true;
+    thermal_throttling_status_map_[sensor_name.data()].is_cleared = true;
 
     return;
 }
 
+void ThermalThrottling::onResume() {
+    std::unique_lock<std::shared_mutex> _lock(thermal_throttling_status_map_mutex_);
+    // The integrator is kept, it carries the steady state budget. The derivative and the
+    // budget transient are meaningless across the suspend gap, so they restart from scratch.
+    for (auto &[sensor_name, throttling_status] : thermal_throttling_status_map_) {
+        throttling_status.prev_err = NAN;
+        throttling_status.tran_cycle = 0;
+        throttling_status.budget_transient = 0;
+    }
+}
+
+void ThermalThrottling::onConfigReload(std::string_view sensor_name) {
+    std::unique_lock<std::shared_mutex> _lock(thermal_throttling_status_map_mutex_);
+    const auto it = thermal_throttling_status_map_.find(sensor_name.data());
+    if (it == thermal_throttling_status_map_.end()) {
+        return;
+    }
+    // The integrator is kept so that the budget does not jump, the transient restarts with
+    // the reloaded cycle count
+    auto &throttling_status = it->second;
+    throttling_status.tran_cycle = 0;
+    throttling_status.last_input_temp = NAN;
+    throttling_status.is_steady = false;
+    throttling_status.is_request_dirty = true;
+    throttling_status.is_cleared = false;
+}
+
 bool ThermalThrottling::registerThermalThrottling(
         std::string_view sensor_name, const std::shared_ptr<ThrottlingInfo> &throttling_info,
         const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map) {
@@ -128,6 +226,12 @@ bool ThermalThrottling::registerThermalThrottling(
     thermal_throttling_status_map_[sensor_name.data()].prev_power_budget = NAN;
     thermal_throttling_status_map_[sensor_name.data()].tran_cycle = 0;
     thermal_throttling_status_map_[sensor_name.data()].profile = "";
+    thermal_throttling_status_map_[sensor_name.data()].last_input_temp = NAN;
+    thermal_throttling_status_map_[sensor_name.data()].is_steady = false;
+    thermal_throttling_status_map_[sensor_name.data()].is_request_dirty = true;
+    thermal_throttling_status_map_[sensor_name.data()].last_request_severity =
+            ThrottlingSeverity::NONE;
+    thermal_throttling_status_map_[sensor_name.data()].is_cleared = false;
 
     for (auto &binded_cdev_pair : throttling_info->binded_cdev_info_map) {
         if (!cooling_device_info_map.count(binded_cdev_pair.first)) {
@@ -576,19 +680,23 @@ bool ThermalThrottling::throttlingReleaseUpdate(
         std::string_view sensor_name,
         const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map,
         const std::unordered_map<std::string, PowerStatus> &power_status_map,
-        const ThrottlingSeverity severity, const SensorInfo &sensor_info) {
+        const ThrottlingSeverity severity, const SensorInfo &sensor_info,
+        const SensorForecast *forecast) {
     ATRACE_CALL();
     std::unique_lock<std::shared_mutex> _lock(thermal_throttling_status_map_mutex_);
     if (!thermal_throttling_status_map_.count(sensor_name.data())) {
         return false;
     }
     auto &thermal_throttling_status = thermal_throttling_status_map_.at(sensor_name.data());
+    bool ret = true;
     for (const auto &binded_cdev_info_pair : sensor_info.throttling_info->binded_cdev_info_map) {
         float avg_power = -1;
 
+        // A cdev without release keeps its request, the other cdevs are still released
         if (!thermal_throttling_status.throttling_release_map.count(binded_cdev_info_pair.first) ||
             !power_status_map.count(binded_cdev_info_pair.second.power_rail)) {
-            return false;
+            ret = false;
+            continue;
         }
 
         const auto max_state = cooling_device_info_map.at(binded_cdev_info_pair.first).max_state;
@@ -661,20 +769,126 @@ bool ThermalThrottling::throttlingReleaseUpdate(
             case ReleaseLogic::RELEASE_TO_FLOOR:
                 release_step = is_over_budget ? 0 : max_state;
                 break;
+            case ReleaseLogic::PREDICTIVE: {
+                int request = 0;
+                const auto pid_request_it =
+                        thermal_throttling_status.pid_cdev_request_map.find(
+                                binded_cdev_info_pair.first);
+                if (pid_request_it != thermal_throttling_status.pid_cdev_request_map.end()) {
+                    request = pid_request_it->second;
+                }
+                const auto hardlimit_request_it =
+                        thermal_throttling_status.hardlimit_cdev_request_map.find(
+                                binded_cdev_info_pair.first);
+                if (hardlimit_request_it !=
+                    thermal_throttling_status.hardlimit_cdev_request_map.end()) {
+                    request = std::max(request, hardlimit_request_it->second);
+                }
+                release_step = computePredictiveReleaseStep(
+                        sensor_info, binded_cdev_info_pair.second,
+                        cooling_device_info_map.at(binded_cdev_info_pair.first), severity,
+                        avg_power, forecast, request, release_step);
+                break;
+            }
             case ReleaseLogic::NONE:
             default:
                 break;
         }
     }
+    return ret;
+}
+
+bool ThermalThrottling::isThrottlingInputUnchanged(
+        const Temperature &temp, const SensorInfo &sensor_info,
+        const ThrottlingSeverity curr_severity,
+        const std::unordered_map<std::string, PowerStatus> &power_status_map,
+        const bool max_throttling, const SensorForecast *forecast,
+        const ThermalThrottlingStatus &throttling_status) const {
+    if (std::isnan(sensor_info.change_epsilon) || !throttling_status.is_steady ||
+        throttling_status.tran_cycle || std::isnan(throttling_status.last_input_temp) ||
+        std::fabs(temp.value - throttling_status.last_input_temp) > sensor_info.change_epsilon ||
+        curr_severity != throttling_status.last_input_severity ||
+        max_throttling != throttling_status.last_input_max_throttling ||
+        throttling_status.profile != throttling_status.last_input_profile) {
+        return false;
+    }
+
+    // The predictive release follows the predicted temperature
+    const float predicted_temp = (forecast != nullptr) ? forecast->predicted_temp : NAN;
+    if (std::isnan(predicted_temp) != std::isnan(throttling_status.last_input_predicted_temp) ||
+        std::fabs(predicted_temp - throttling_status.last_input_predicted_temp) >
+                sensor_info.change_epsilon) {
+        return false;
+    }
+
+    for (const auto &[power_rail, last_power] : throttling_status.last_input_power_map) {
+        const auto power_status_it = power_status_map.find(power_rail);
+        const float power = (power_status_it != power_status_map.end())
+                                    ? power_status_it->second.last_updated_avg_power
+                                    : NAN;
+        if (power != last_power && !(std::isnan(power) && std::isnan(last_power))) {
+            return false;
+        }
+    }
+
+    // The integral keeps moving unless the error is past the cutoff or the integral saturated
+    if (throttling_status.pid_power_budget_map.size()) {
+        const auto target_state = getTargetStateOfPID(sensor_info, curr_severity);
+        const float err = sensor_info.hot_thresholds[target_state] - temp.value;
+        const float k_i = sensor_info.throttling_info->k_i[target_state];
+        const bool i_saturated = std::fabs(throttling_status.i_budget) >=
+                                         sensor_info.throttling_info->i_max[target_state] &&
+                                 err * k_i * throttling_status.i_budget >= 0;
+        if (err < sensor_info.throttling_info->i_cutoff[target_state] && k_i != 0 &&
+            !i_saturated) {
+            return false;
+        }
+    }
     return true;
 }
 
+void ThermalThrottling::recordThrottlingInput(
+        const Temperature &temp, const SensorInfo &sensor_info,
+        const ThrottlingSeverity curr_severity,
+        const std::unordered_map<std::string, PowerStatus> &power_status_map,
+        const bool max_throttling, const SensorForecast *forecast,
+        ThermalThrottlingStatus *throttling_status) {
+    throttling_status->last_input_temp = temp.value;
+    throttling_status->last_input_predicted_temp =
+            (forecast != nullptr) ? forecast->predicted_temp : NAN;
+    throttling_status->last_input_severity = curr_severity;
+    throttling_status->last_input_max_throttling = max_throttling;
+    throttling_status->last_input_profile = throttling_status->profile;
+    throttling_status->last_input_power_map.clear();
+
+    const auto record_power = [&](const std::string &power_rail) {
+        const auto power_status_it = power_status_map.find(power_rail);
+        throttling_status->last_input_power_map[power_rail] =
+                (power_status_it != power_status_map.end())
+                        ? power_status_it->second.last_updated_avg_power
+                        : NAN;
+    };
+    for (const auto &excluded_power_info_pair :
+         sensor_info.throttling_info->excluded_power_info_map) {
+        record_power(excluded_power_info_pair.first);
+    }
+    const auto &binded_cdev_info_map =
+            sensor_info.throttling_info->profile_map.count(throttling_status->profile)
+                    ? sensor_info.throttling_info->profile_map.at(throttling_status->profile)
+                    : sensor_info.throttling_info->binded_cdev_info_map;
+    for (const auto &binded_cdev_info_pair : binded_cdev_info_map) {
+        if (!binded_cdev_info_pair.second.power_rail.empty()) {
+            record_power(binded_cdev_info_pair.second.power_rail);
+        }
+    }
+}
+
 void ThermalThrottling::thermalThrottlingUpdate(
         const Temperature &temp, const SensorInfo &sensor_info,
         const ThrottlingSeverity curr_severity, const std::chrono::milliseconds time_elapsed_ms,
         const std::unordered_map<std::string, PowerStatus> &power_status_map,
         const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map,
-        const bool max_throttling) {
+        const bool max_throttling, const SensorForecast *forecast) {
     if (!thermal_throttling_status_map_.count(temp.name)) {
         return;
     }
@@ -683,6 +897,25 @@ void ThermalThrottling::thermalThrottlingUpdate(
         parseProfileProperty(temp.name.c_str(), sensor_info);
     }
 
+    auto &throttling_status = thermal_throttling_status_map_[temp.name];
+    throttling_status.is_cleared = false;
+    if (isThrottlingInputUnchanged(temp, sensor_info, curr_severity, power_status_map,
+                                   max_throttling, forecast, throttling_status)) {
+        LOG(VERBOSE) << "Sensor " << temp.name << " throttling inputs unchanged, keep requests";
+        ATRACE_INT((temp.name + std::string("-throttling_skipped")).c_str(), 1);
+        return;
+    }
+    ATRACE_INT((temp.name + std::string("-throttling_skipped")).c_str(), 0);
+
+    // Only the sensors with a ChangeEpsilon need the previous requests for the steady check
+    const bool track_input = !std::isnan(sensor_info.change_epsilon);
+    std::unordered_map<std::string, int> prev_pid_cdev_request_map;
+    std::unordered_map<std::string, int> prev_throttling_release_map;
+    if (track_input) {
+        prev_pid_cdev_request_map = throttling_status.pid_cdev_request_map;
+        prev_throttling_release_map = throttling_status.throttling_release_map;
+    }
+
     if (thermal_throttling_status_map_[temp.name].pid_power_budget_map.size()) {
         if (!allocatePowerToCdev(temp, sensor_info, curr_severity, time_elapsed_ms,
                                  power_status_map, cooling_device_info_map, max_throttling)) {
@@ -702,7 +935,16 @@ void ThermalThrottling::thermalThrottlingUpdate(
 
     if (thermal_throttling_status_map_[temp.name].throttling_release_map.size()) {
         throttlingReleaseUpdate(temp.name.c_str(), cooling_device_info_map, power_status_map,
-                                curr_severity, sensor_info);
+                                curr_severity, sensor_info, forecast);
+    }
+
+    throttling_status.is_request_dirty = true;
+    if (track_input) {
+        recordThrottlingInput(temp, sensor_info, curr_severity, power_status_map, max_throttling,
+                              forecast, &throttling_status);
+        throttling_status.is_steady =
+                prev_pid_cdev_request_map == throttling_status.pid_cdev_request_map &&
+                prev_throttling_release_map == throttling_status.throttling_release_map;
     }
 }
 
@@ -718,6 +960,13 @@ void ThermalThrottling::computeCoolingDevicesRequest(
     }
 
     auto &thermal_throttling_status = thermal_throttling_status_map_.at(sensor_name.data());
+    // The requests are unchanged, so are the cooling device requests computed from them
+    if (!thermal_throttling_status.is_request_dirty &&
+        thermal_throttling_status.last_request_severity == curr_severity) {
+        return;
+    }
+    thermal_throttling_status.is_request_dirty = false;
+    thermal_throttling_status.last_request_severity = curr_severity;
     const auto &cdev_release_map = thermal_throttling_status.throttling_release_map;
 
     const auto &profile = thermal_throttling_status_map_[sensor_name.data()].profile;
@@ -16,6 +16,7 @@
 #include <unordered_set>
 
 #include "power_files.h"
+#include "thermal_forecast.h"
 #include "thermal_info.h"
 #include "thermal_stats_helper.h"
 
@@ -38,6 +39,20 @@ struct ThermalThrottlingStatus {
     float budget_transient;
     int tran_cycle;
     std::string profile;
+    // Inputs of the last throttling computation, it is skipped while they do not change
+    float last_input_temp;
+    // NAN without a forecast
+    float last_input_predicted_temp;
+    ThrottlingSeverity last_input_severity;
+    bool last_input_max_throttling;
+    std::string last_input_profile;
+    std::unordered_map<std::string, float> last_input_power_map;
+    // Whether the last throttling computation left the requests unchanged
+    bool is_steady;
+    // Whether the requests changed since the cooling device requests were computed
+    bool is_request_dirty;
+    ThrottlingSeverity last_request_severity;
+    bool is_cleared;
 };
 
 // Return the control temp target of PID algorithm
@@ -54,6 +69,10 @@ class ThermalThrottling {
 
     // Clear throttling data
     void clearThrottlingData(std::string_view sensor_name, const SensorInfo &sensor_info);
+    // Drop the PID history which does not hold over a system suspend
+    void onResume();
+    // Recompute the requests of a sensor with its reloaded tunables on its next update
+    void onConfigReload(std::string_view sensor_name);
     // Register map for throttling algo
     bool registerThermalThrottling(
             std::string_view sensor_name, const std::shared_ptr<ThrottlingInfo> &throttling_info,
@@ -64,13 +83,20 @@ class ThermalThrottling {
         std::shared_lock<std::shared_mutex> _lock(thermal_throttling_status_map_mutex_);
         return thermal_throttling_status_map_;
     }
-    // Update thermal throttling request for the specific sensor
+    // Get a copy of the throttling status map
+    std::unordered_map<std::string, ThermalThrottlingStatus> GetThermalThrottlingStatusSnapshot()
+            const {
+        std::shared_lock<std::shared_mutex> _lock(thermal_throttling_status_map_mutex_);
+        return thermal_throttling_status_map_;
+    }
+    // Update thermal throttling request for the specific sensor, the forecast of the sensor
+    // drives the PREDICTIVE release
     void thermalThrottlingUpdate(
             const Temperature &temp, const SensorInfo &sensor_info,
             const ThrottlingSeverity curr_severity, const std::chrono::milliseconds time_elapsed_ms,
             const std::unordered_map<std::string, PowerStatus> &power_status_map,
             const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map,
-            const bool max_throttling = false);
+            const bool max_throttling = false, const SensorForecast *forecast = nullptr);
 
     // Compute the throttling target from all the sensors' request
     void computeCoolingDevicesRequest(std::string_view sensor_name, const SensorInfo &sensor_info,
@@ -83,6 +109,20 @@ class ThermalThrottling {
   private:
     // Check if the thermal throttling profile need to be switched
     void parseProfileProperty(std::string_view sensor_name, const SensorInfo &sensor_info);
+    // Return true if the throttling inputs of a steady sensor stayed within its ChangeEpsilon
+    // and the PID integral would not move, so the previous requests still hold
+    bool isThrottlingInputUnchanged(
+            const Temperature &temp, const SensorInfo &sensor_info,
+            const ThrottlingSeverity curr_severity,
+            const std::unordered_map<std::string, PowerStatus> &power_status_map,
+            const bool max_throttling, const SensorForecast *forecast,
+            const ThermalThrottlingStatus &throttling_status) const;
+    // Record the inputs of a throttling computation
+    void recordThrottlingInput(const Temperature &temp, const SensorInfo &sensor_info,
+                               const ThrottlingSeverity curr_severity,
+                               const std::unordered_map<std::string, PowerStatus> &power_status_map,
+                               const bool max_throttling, const SensorForecast *forecast,
+                               ThermalThrottlingStatus *throttling_status);
     // PID algo - get the total power budget
     float updatePowerBudget(const Temperature &temp, const SensorInfo &sensor_info,
                             std::chrono::milliseconds time_elapsed_ms,
@@ -109,12 +149,13 @@ class ThermalThrottling {
     void updateCdevRequestBySeverity(std::string_view sensor_name, const SensorInfo &sensor_info,
                                      ThrottlingSeverity curr_severity);
     // Throttling release algo - decide release step according to the predefined power threshold,
-    // return false if the throttling release is not registered in thermal config
+    // return false if the throttling release of any cdev is not registered in thermal config
     bool throttlingReleaseUpdate(
             std::string_view sensor_name,
             const std::unordered_map<std::string, CdevInfo> &cooling_device_info_map,
             const std::unordered_map<std::string, PowerStatus> &power_status_map,
-            const ThrottlingSeverity severity, const SensorInfo &sensor_info);
+            const ThrottlingSeverity severity, const SensorInfo &sensor_info,
+            const SensorForecast *forecast);
     // Update the cooling device request set for new request and notify the caller if there is
     // change in max_request for the cooling device.
     bool updateCdevMaxRequestAndNotifyIfChange(std::string_view cdev_name, int cur_request,
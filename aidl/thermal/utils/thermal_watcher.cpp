@@ -18,11 +18,14 @@
 #include <linux/thermal.h>
 #include <sys/inotify.h>
 #include <sys/resource.h>
+#include <sys/timerfd.h>
 #include <sys/types.h>
 #include <utils/Trace.h>
 
+#include <algorithm>
 #include <chrono>
 #include <fstream>
+#include <limits>
 
 #include "../thermal-helper.h"
 
@@ -34,6 +37,9 @@ namespace implementation {
 
 namespace {
 
+// Sleep intervals above this are treated as no deadline, to keep the deadline arithmetic safe
+constexpr std::chrono::milliseconds kMaxWatcherSleepMs = std::chrono::hours(24 * 365);
+
 static int nlErrorHandle(struct sockaddr_nl *nla, struct nlmsgerr *err, void *arg) {
     int *ret = reinterpret_cast<int *>(arg);
     *ret = err->error;
@@ -344,8 +350,7 @@ void ThermalWatcher::registerFilesToWatch(const std::set<std::string> &sensors_t
     fcntl(uevent_fd_, F_SETFL, O_NONBLOCK);
 
     looper_->addFd(uevent_fd_.get(), 0, ::android::Looper::EVENT_INPUT, nullptr, nullptr);
-    sleep_ms_ = std::chrono::milliseconds(0);
-    last_update_time_ = boot_clock::now();
+    next_deadline_ = boot_clock::now();
 }
 
 void ThermalWatcher::registerFilesToWatchNl(const std::set<std::string> &sensors_to_watch) {
@@ -385,12 +390,17 @@ void ThermalWatcher::registerFilesToWatchNl(const std::set<std::string> &sensors
 
     fcntl(thermal_genl_fd_, F_SETFL, O_NONBLOCK);
     looper_->addFd(thermal_genl_fd_.get(), 0, ::android::Looper::EVENT_INPUT, nullptr, nullptr);
-    sleep_ms_ = std::chrono::milliseconds(0);
-    last_update_time_ = boot_clock::now();
+    next_deadline_ = boot_clock::now();
 }
 
 bool ThermalWatcher::startWatchingDeviceFiles() {
     if (cb_) {
+        timer_fd_.reset(timerfd_create(CLOCK_BOOTTIME, TFD_NONBLOCK | TFD_CLOEXEC));
+        if (timer_fd_.get() < 0) {
+            PLOG(ERROR) << "Failed to create watcher timer, fall back to poll timeout";
+        } else {
+            looper_->addFd(timer_fd_.get(), 0, ::android::Looper::EVENT_INPUT, nullptr, nullptr);
+        }
         auto ret = this->run("FileWatcherThread", -10);
         if (ret != ::android::NO_ERROR) {
             LOG(ERROR) << "ThermalWatcherThread start fail";
@@ -486,33 +496,73 @@ void ThermalWatcher::wake() {
     looper_->wake();
 }
 
+bool ThermalWatcher::armTimer() {
+    if (timer_fd_.get() < 0) {
+        return false;
+    }
+    if (armed_deadline_ == next_deadline_) {
+        return true;
+    }
+    // An all zero it_value disarms the timer
+    struct itimerspec spec = {};
+    if (next_deadline_ != boot_clock::time_point::max()) {
+        const auto deadline_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         next_deadline_.time_since_epoch())
+                                         .count();
+        spec.it_value.tv_sec = deadline_ns / 1000000000;
+        spec.it_value.tv_nsec = deadline_ns % 1000000000;
+    }
+    if (timerfd_settime(timer_fd_.get(), TFD_TIMER_ABSTIME, &spec, nullptr) != 0) {
+        PLOG(ERROR) << "Failed to arm watcher timer";
+        return false;
+    }
+    armed_deadline_ = next_deadline_;
+    return true;
+}
+
 bool ThermalWatcher::threadLoop() {
     LOG(VERBOSE) << "ThermalWatcher polling...";
 
     int fd;
     std::set<std::string> sensors;
 
-    auto time_elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(boot_clock::now() -
-                                                                                 last_update_time_);
-
-    if (time_elapsed_ms < sleep_ms_ &&
-        looper_->pollOnce(sleep_ms_.count(), &fd, nullptr, nullptr) >= 0) {
-        ATRACE_NAME("ThermalWatcher::threadLoop - receive event");
-        if (fd != uevent_fd_.get() && fd != thermal_genl_fd_.get()) {
-            return true;
-        } else if (fd == thermal_genl_fd_.get()) {
-            parseGenlink(&sensors);
-        } else if (fd == uevent_fd_.get()) {
-            parseUevent(&sensors);
+    const auto now = boot_clock::now();
+    if (now < next_deadline_) {
+        int timeout_ms = -1;
+        if (!armTimer() && next_deadline_ != boot_clock::time_point::max()) {
+            timeout_ms = static_cast<int>(std::min<int64_t>(
+                    std::chrono::ceil<std::chrono::milliseconds>(next_deadline_ - now).count(),
+                    std::numeric_limits<int>::max()));
         }
-        // Ignore cb_ if uevent is not from monitored sensors
-        if (sensors.size() == 0) {
-            return true;
+        if (looper_->pollOnce(timeout_ms, &fd, nullptr, nullptr) >= 0) {
+            ATRACE_NAME("ThermalWatcher::threadLoop - receive event");
+            if (fd == timer_fd_.get()) {
+                uint64_t expirations;
+                if (read(timer_fd_.get(), &expirations, sizeof(expirations)) < 0 &&
+                    errno != EAGAIN) {
+                    PLOG(ERROR) << "Failed to read watcher timer";
+                }
+                armed_deadline_ = boot_clock::time_point::max();
+            } else if (fd != uevent_fd_.get() && fd != thermal_genl_fd_.get()) {
+                return true;
+            } else if (fd == thermal_genl_fd_.get()) {
+                parseGenlink(&sensors);
+            } else if (fd == uevent_fd_.get()) {
+                parseUevent(&sensors);
+            }
+            // Ignore cb_ if uevent is not from monitored sensors
+            if (fd != timer_fd_.get() && sensors.size() == 0) {
+                return true;
+            }
         }
     }
 
-    sleep_ms_ = cb_(sensors);
-    last_update_time_ = boot_clock::now();
+    const auto update_time = boot_clock::now();
+    const auto sleep_ms = cb_(sensors);
+    // The deadline is kept relative to the update start, so that it doesn't drift with the
+    // time spent in the callback
+    next_deadline_ = (sleep_ms >= kMaxWatcherSleepMs) ? boot_clock::time_point::max()
+                                                      : update_time + sleep_ms;
     return true;
 }
 
@@ -72,6 +72,9 @@ class ThermalWatcher : public ::android::Thread {
     // Parse thermal netlink message
     void parseGenlink(std::set<std::string> *sensor_name);
 
+    // Arm the timer for next_deadline_, return false if the timer is not available
+    bool armTimer();
+
     // Maps watcher filer descriptor to watched file path.
     std::unordered_map<int, std::string> watch_to_file_path_map_;
 
@@ -89,10 +92,13 @@ class ThermalWatcher : public ::android::Thread {
     ::android::base::unique_fd thermal_genl_fd_;
     // Sensor list which monitor flag is enabled.
     std::set<std::string> monitored_sensors_;
-    // Sleep interval voting result
-    std::chrono::milliseconds sleep_ms_;
-    // Timestamp for last thermal update
-    boot_clock::time_point last_update_time_;
+    // CLOCK_BOOTTIME timer for the polling deadline, an absolute deadline does not drift with
+    // the time spent in the callback
+    ::android::base::unique_fd timer_fd_;
+    // Deadline of the next thermal update, from the sleep interval voting result
+    boot_clock::time_point next_deadline_ = boot_clock::time_point::min();
+    // Deadline the timer is armed with
+    boot_clock::time_point armed_deadline_ = boot_clock::time_point::max();
     // For thermal genl socket object.
     struct nl_sock *sk_thermal;
 };
@@ -5,6 +5,7 @@
  */
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "virtualtemp_estimator_data.h"